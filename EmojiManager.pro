@@ -1,7 +1,12 @@
 QT += widgets
-QT += core gui widgets svg
+QT += core gui widgets svg sql
 
 CONFIG += c++17 release
+
+# 调试输出：DEBUG_LOG 默认只在 debug 构建中打开，release 构建需要时取消下一行的注释
+# DEFINES += ENABLE_DEBUG=1
+# 追踪：编译进来的类别位掩码（见 src/trace.h），0 表示去掉全部追踪代码
+# DEFINES += EMOJI_TRACE_CATEGORIES=0
 TARGET = EmojiManager
 TEMPLATE = app
 
@@ -9,18 +14,67 @@ SOURCES += \
     src/main.cpp \
     src/mainwindow.cpp \
     src/emojilistwidget.cpp \
+    src/emojilistmodel.cpp \
     src/emojilistdelegate.cpp \
     src/previewdialog.cpp \
-    src/splashiconwidget.cpp
+    src/splashiconwidget.cpp \
+    src/importpipeline.cpp \
+    src/thumbnailcache.cpp \
+    src/thumbnailloader.cpp \
+    src/thumbnailer.cpp \
+    src/librarystore.cpp \
+    src/sqlitecatalog.cpp \
+    src/sortengine.cpp \
+    src/searchindex.cpp \
+    src/emojifiltermodel.cpp \
+    src/contenthash.cpp \
+    src/perceptualhash.cpp \
+    src/similarityindex.cpp \
+    src/animationclock.cpp \
+    src/framecache.cpp \
+    src/imagecache.cpp \
+    src/emojimimedata.cpp \
+    src/tiledimageview.cpp \
+    src/folderwatcher.cpp \
+    src/directorywalker.cpp \
+    src/missingfilescanner.cpp \
+    src/headlessrunner.cpp \
+    src/startupprofile.cpp \
+    src/trace.cpp
 
 HEADERS += \
     src/emoji_meta.h \
     src/mainwindow.h \
     src/emojilistwidget.h \
+    src/emojilistmodel.h \
     src/emojilistdelegate.h \
     src/previewdialog.h \
     src/emoji_meta.h \
-    src/splashiconwidget.h
+    src/splashiconwidget.h \
+    src/importpipeline.h \
+    src/thumbnailcache.h \
+    src/thumbnailloader.h \
+    src/thumbnailer.h \
+    src/librarystore.h \
+    src/librarybackend.h \
+    src/sqlitecatalog.h \
+    src/sortengine.h \
+    src/searchindex.h \
+    src/emojifiltermodel.h \
+    src/contenthash.h \
+    src/perceptualhash.h \
+    src/similarityindex.h \
+    src/animationclock.h \
+    src/framecache.h \
+    src/imagecache.h \
+    src/emojimimedata.h \
+    src/tiledimageview.h \
+    src/folderwatcher.h \
+    src/directorywalker.h \
+    src/missingfilescanner.h \
+    src/headlessrunner.h \
+    src/startupprofile.h \
+    src/trace.h
 
 RESOURCES += \
     resources.qrc
@@ -0,0 +1,50 @@
+#include "animationclock.h"
+
+namespace {
+const qint64 kMaxWaitMs = 60 * 1000;  // 很远的预约分段等待，避免 int 溢出
+}
+
+AnimationClock::AnimationClock(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);  // GIF 帧间隔常见为 20~100ms，粗粒度定时器误差太大
+    connect(&m_timer, &QTimer::timeout, this, &AnimationClock::onTimeout);
+    m_clock.start();
+}
+
+void AnimationClock::arm()
+{
+    if (m_paused || m_due < 0) return;
+    m_timer.start(int(qBound<qint64>(0, m_due - now(), kMaxWaitMs)));
+}
+
+void AnimationClock::scheduleAt(qint64 t)
+{
+    if (m_due >= 0 && m_due <= t) return;  // 已有更早的预约
+    m_due = t;
+    arm();
+}
+
+void AnimationClock::setPaused(bool paused)
+{
+    if (m_paused == paused) return;
+    if (paused) {
+        m_pausedAt = m_clock.elapsed();
+        m_timer.stop();
+    } else {
+        m_offset += m_clock.elapsed() - m_pausedAt;
+    }
+    m_paused = paused;
+    arm();
+}
+
+void AnimationClock::onTimeout()
+{
+    if (now() < m_due) {
+        arm();
+        return;
+    }
+    m_due = -1;
+    emit tick();
+}
@@ -0,0 +1,48 @@
+/*
+* 文件名：animationclock.h
+* 日期：2026-10-16
+* 该文件功能大致描述：全部动图缩略图共用的动画时钟。只有一个单次 QTimer，定时到“下一次有帧需要切换”的时刻；
+*                    多个请求合并为最早的一个，没有动图可见时不再定时，CPU 占用为零。暂停期间动画时间不走，恢复后从原处继续。
+* 该文件函数功能描述：
+*   - now()：当前动画时间（毫秒）
+*   - scheduleAt()：请求在动画时间 t 发出一次 tick()
+*   - setPaused()：暂停/恢复（主窗口隐藏时暂停）
+*   - tick()：信号，由 EmojiListWidget 处理：重绘帧已切换的可见单元格，并预约下一次 tick
+* 与该文件相关联的其他文件：animationclock.cpp, framecache.h, emojilistwidget.cpp, emojilistdelegate.cpp, mainwindow.cpp
+*/
+
+#ifndef ANIMATIONCLOCK_H
+#define ANIMATIONCLOCK_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+class AnimationClock : public QObject {
+    Q_OBJECT
+public:
+    explicit AnimationClock(QObject *parent = nullptr);
+
+    qint64 now() const { return (m_paused ? m_pausedAt : m_clock.elapsed()) - m_offset; }
+    void scheduleAt(qint64 t);
+    void setPaused(bool paused);
+    bool isPaused() const { return m_paused; }
+
+signals:
+    void tick();
+
+private slots:
+    void onTimeout();
+
+private:
+    void arm();  // 按 m_due 启动定时器（暂停时不启动）
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_offset = 0;    // 累计暂停时长
+    qint64 m_pausedAt = 0;
+    qint64 m_due = -1;      // 已预约的 tick 时刻（动画时间），-1 表示没有
+    bool m_paused = false;
+};
+
+#endif // ANIMATIONCLOCK_H
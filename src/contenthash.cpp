@@ -0,0 +1,214 @@
+#include "contenthash.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+const quint64 P1 = 11400714785074694791ULL;
+const quint64 P2 = 14029467366897019727ULL;
+const quint64 P3 = 1609587929392839161ULL;
+const quint64 P4 = 9650029242287828579ULL;
+const quint64 P5 = 2870177450012600261ULL;
+const qint64 kReadChunk = 1 << 20;  // 映射失败时的分块读取大小
+
+inline quint64 rotl(quint64 x, int r) { return (x << r) | (x >> (64 - r)); }
+inline quint64 read64(const uchar *p) { return qFromLittleEndian<quint64>(p); }
+inline quint64 read32(const uchar *p) { return qFromLittleEndian<quint32>(p); }
+
+inline quint64 round64(quint64 acc, quint64 input)
+{
+    acc += input * P2;
+    acc = rotl(acc, 31);
+    return acc * P1;
+}
+
+inline quint64 mergeRound(quint64 acc, quint64 val)
+{
+    acc ^= round64(0, val);
+    return acc * P1 + P4;
+}
+
+// 在原地移除一个 (key, value) 对（QMultiHash::remove 会移除所有相同的对）
+template <typename K>
+bool eraseOne(QMultiHash<K, QString> &hash, const K &key, const QString &value)
+{
+    auto it = hash.find(key, value);
+    if (it == hash.end()) return false;
+    hash.erase(it);
+    return true;
+}
+
+} // namespace
+
+ContentHash::ContentHash(quint64 seed)
+    : m_seed(seed)
+{
+    m_v[0] = seed + P1 + P2;
+    m_v[1] = seed + P2;
+    m_v[2] = seed;
+    m_v[3] = seed - P1;
+}
+
+void ContentHash::update(const uchar *data, qint64 len)
+{
+    m_total += quint64(len);
+    if (m_bufLen + len < 32) {
+        memcpy(m_buf + m_bufLen, data, size_t(len));
+        m_bufLen += int(len);
+        return;
+    }
+    const uchar *p = data;
+    const uchar *end = data + len;
+    if (m_bufLen > 0) {
+        const int fill = 32 - m_bufLen;
+        memcpy(m_buf + m_bufLen, p, size_t(fill));
+        for (int i = 0; i < 4; ++i) m_v[i] = round64(m_v[i], read64(m_buf + 8 * i));
+        p += fill;
+        m_bufLen = 0;
+    }
+    while (p + 32 <= end) {
+        for (int i = 0; i < 4; ++i) m_v[i] = round64(m_v[i], read64(p + 8 * i));
+        p += 32;
+    }
+    if (p < end) {
+        m_bufLen = int(end - p);
+        memcpy(m_buf, p, size_t(m_bufLen));
+    }
+}
+
+quint64 ContentHash::digest() const
+{
+    quint64 h;
+    if (m_total >= 32) {
+        h = rotl(m_v[0], 1) + rotl(m_v[1], 7) + rotl(m_v[2], 12) + rotl(m_v[3], 18);
+        for (int i = 0; i < 4; ++i) h = mergeRound(h, m_v[i]);
+    } else {
+        h = m_seed + P5;
+    }
+    h += m_total;
+
+    const uchar *p = m_buf;
+    const uchar *end = m_buf + m_bufLen;
+    while (p + 8 <= end) {
+        h ^= round64(0, read64(p));
+        h = rotl(h, 27) * P1 + P4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= read32(p) * P1;
+        h = rotl(h, 23) * P2 + P3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= quint64(*p) * P5;
+        h = rotl(h, 11) * P1;
+        ++p;
+    }
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h ? h : 1;  // 0 保留给“未知”
+}
+
+quint64 ContentHash::ofFile(const QString &path, bool *ok)
+{
+    if (ok) *ok = false;
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return 0;
+    ContentHash hasher;
+    const qint64 size = f.size();
+    if (size > 0) {
+        if (uchar *mapped = f.map(0, size)) {
+            hasher.update(mapped, size);  // 内存映射：不经过用户态缓冲区复制
+            f.unmap(mapped);
+        } else {
+            QByteArray chunk(int(kReadChunk), Qt::Uninitialized);
+            qint64 n;
+            while ((n = f.read(chunk.data(), kReadChunk)) > 0) {
+                hasher.update(reinterpret_cast<const uchar *>(chunk.constData()), n);
+            }
+            if (n < 0) return 0;
+        }
+    }
+    if (ok) *ok = true;
+    return hasher.digest();
+}
+
+void ContentIndex::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_byHash.clear();
+    m_unhashedBySize.clear();
+    m_learned.clear();
+}
+
+void ContentIndex::add(const QString &path, qint64 size, quint64 hash)
+{
+    QMutexLocker lock(&m_mutex);
+    if (hash) m_byHash.insert(hash, path);
+    else m_unhashedBySize.insert(size, path);
+}
+
+void ContentIndex::remove(const QString &path, qint64 size, quint64 hash)
+{
+    QMutexLocker lock(&m_mutex);
+    if (hash && eraseOne(m_byHash, hash, path)) return;
+    if (eraseOne(m_unhashedBySize, size, path)) return;
+    // 旧条目可能已在导入时补算了哈希
+    for (auto it = m_byHash.begin(); it != m_byHash.end(); ++it) {
+        if (it.value() == path) {
+            m_byHash.erase(it);
+            return;
+        }
+    }
+}
+
+QString ContentIndex::lookup(qint64 size, quint64 hash)
+{
+    QStringList legacy;
+    {
+        QMutexLocker lock(&m_mutex);
+        auto it = m_byHash.constFind(hash);
+        if (it != m_byHash.constEnd()) return it.value();
+        legacy = m_unhashedBySize.values(size);
+    }
+    if (legacy.isEmpty()) return QString();
+
+    // 同样大小的旧条目：在工作线程里补算哈希（锁外进行），之后不再重复计算
+    QVector<QPair<QString, quint64>> hashed;
+    for (const QString &p : legacy) {
+        bool ok = false;
+        const quint64 h = ContentHash::ofFile(p, &ok);
+        if (ok) hashed.append(qMakePair(p, h));
+    }
+    QMutexLocker lock(&m_mutex);
+    for (const auto &ph : hashed) {
+        if (!eraseOne(m_unhashedBySize, size, ph.first)) continue;  // 其他线程已补算或已删除
+        m_byHash.insert(ph.second, ph.first);
+        m_learned.append(ph);
+    }
+    return m_byHash.value(hash);
+}
+
+QString ContentIndex::claim(const QString &path, quint64 hash)
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_byHash.constFind(hash);
+    if (it != m_byHash.constEnd()) return it.value();
+    m_byHash.insert(hash, path);
+    return QString();
+}
+
+QVector<QPair<QString, quint64>> ContentIndex::takeLearned()
+{
+    QMutexLocker lock(&m_mutex);
+    QVector<QPair<QString, quint64>> out;
+    out.swap(m_learned);
+    return out;
+}
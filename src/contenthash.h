@@ -0,0 +1,59 @@
+/*
+* 文件名：contenthash.h
+* 日期：2026-10-16
+* 该文件功能大致描述：文件内容哈希与按内容去重的索引。哈希为 64 位 XXH64（非加密，速度接近内存带宽），
+*                    文件通过内存映射读取，映射失败时回退为 1MB 的分块读取；ContentIndex 记录表情库中每个文件的内容哈希，
+*                    导入时据此跳过内容完全相同的文件。旧版本导入、尚无哈希的条目按文件大小分组，只有出现同样大小的新文件时才补算。
+* 该文件函数功能描述：
+*   - ContentHash：XXH64 流式计算（update()/digest()），ofFile() 计算整个文件，失败时 ok 为 false；0 保留表示“未知”
+*   - ContentIndex::add()/remove()/clear()：随表情库加载、删除维护（线程安全）
+*   - ContentIndex::lookup()：工作线程查询内容相同的已有文件，必要时补算同样大小的旧条目
+*   - ContentIndex::claim()：主线程按导入顺序登记新文件；已有相同内容时返回已有文件路径
+*   - ContentIndex::takeLearned()：取出补算得到的旧条目哈希，由 MainWindow 写回表情库
+* 与该文件相关联的其他文件：contenthash.cpp, importpipeline.cpp, mainwindow.cpp, emoji_meta.h
+*/
+
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QString>
+#include <QStringList>
+#include <QMultiHash>
+#include <QVector>
+#include <QPair>
+#include <QMutex>
+
+class ContentHash {
+public:
+    explicit ContentHash(quint64 seed = 0);
+    void update(const uchar *data, qint64 len);
+    quint64 digest() const;
+
+    static quint64 ofFile(const QString &path, bool *ok = nullptr);
+
+private:
+    quint64 m_v[4];
+    quint64 m_total = 0;
+    uchar m_buf[32];
+    int m_bufLen = 0;
+    quint64 m_seed;
+};
+
+class ContentIndex {
+public:
+    void clear();
+    void add(const QString &path, qint64 size, quint64 hash);
+    void remove(const QString &path, qint64 size, quint64 hash);
+
+    QString lookup(qint64 size, quint64 hash);
+    QString claim(const QString &path, quint64 hash);
+    QVector<QPair<QString, quint64>> takeLearned();
+
+private:
+    QMutex m_mutex;
+    QMultiHash<quint64, QString> m_byHash;
+    QMultiHash<qint64, QString> m_unhashedBySize;   // 尚无哈希的旧条目
+    QVector<QPair<QString, quint64>> m_learned;     // 补算出的旧条目哈希
+};
+
+#endif // CONTENTHASH_H
@@ -0,0 +1,270 @@
+#include "directorywalker.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+#include "trace.h"
+
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QThread>
+
+struct WalkJob {
+    QAtomicInt cancelled;
+    QAtomicInt outstanding;  // 尚未完成的目录任务；降到 0 时遍历结束
+    QAtomicInt files;
+    QAtomicInt dirs;
+    QMutex mutex;
+    QSet<QString> visited;   // 已进入的目录（规范路径），受 mutex 保护
+    WalkFilter filter;
+    int generation = 0;
+    QObject *receiver = nullptr;
+    QThreadPool *pool = nullptr;
+    QElapsedTimer timer;
+    bool firstBatchLogged = false;  // 只在主线程访问
+};
+
+namespace {
+
+class DirTask : public QRunnable {
+public:
+    DirTask(const QSharedPointer<WalkJob> &job, const QString &dir) : m_job(job), m_dir(dir) {}
+
+    void run() override
+    {
+        TRACE_SCOPE(Trace::Import, "DirTask");
+        WalkJob *job = m_job.data();
+        if (!job->cancelled.loadAcquire() && enter()) {
+            job->dirs.ref();
+            QStringList subdirs;
+            FoundFileList rest = DirectoryWalker::listDirectory(m_dir, job->filter, &subdirs,
+                                                                [this](FoundFileList &batch) { return post(batch); });
+            post(rest);
+            // 子目录各自成为任务：宽而浅的树与窄而深的树都能用满线程
+            for (const QString &sub : qAsConst(subdirs)) {
+                if (job->cancelled.loadAcquire()) break;
+                job->outstanding.ref();
+                job->pool->start(new DirTask(m_job, sub));
+            }
+        }
+        if (!job->outstanding.deref()) {
+            QMetaObject::invokeMethod(job->receiver, "onWalkFinished", Qt::QueuedConnection, Q_ARG(int, job->generation));
+        }
+    }
+
+private:
+    // 按规范路径去重：符号链接或目录联接指回祖先目录时不会再次进入
+    bool enter()
+    {
+        const QString canonical = QFileInfo(m_dir).canonicalFilePath();
+        if (canonical.isEmpty()) return false;
+        QMutexLocker lock(&m_job->mutex);
+        if (m_job->visited.contains(canonical)) {
+            DEBUG_LOG("Directory walk: skipping already visited" << m_dir);
+            return false;
+        }
+        m_job->visited.insert(canonical);
+        return true;
+    }
+
+    bool post(FoundFileList &batch)
+    {
+        if (m_job->cancelled.loadAcquire()) return false;
+        if (batch.isEmpty()) return true;
+        m_job->files.fetchAndAddRelaxed(batch.size());
+        QMetaObject::invokeMethod(m_job->receiver, "onFilesFound", Qt::QueuedConnection,
+                                  Q_ARG(int, m_job->generation), Q_ARG(FoundFileList, batch));
+        batch.clear();
+        return true;
+    }
+
+    QSharedPointer<WalkJob> m_job;
+    QString m_dir;
+};
+
+} // namespace
+
+WalkFilter::WalkFilter(const QString &root, const WalkOptions &options)
+    : m_rootPrefix(root.endsWith(QLatin1Char('/')) ? root.length() : root.length() + 1),
+      m_follow(options.followSymlinks),
+      m_recursive(options.recursive)
+{
+    const QStringList include = options.includeGlobs.isEmpty() ? defaultIncludeGlobs() : options.includeGlobs;
+    for (const QString &g : include) {
+        const QString t = g.trimmed().toCaseFolded();
+        if (!t.isEmpty()) m_include.append(t);
+    }
+    for (const QString &g : options.excludeGlobs) {
+        QString t = QDir::fromNativeSeparators(g.trimmed()).toCaseFolded();
+        if (t.isEmpty()) continue;
+        if (t.contains(QLatin1Char('/'))) {
+            while (t.startsWith(QLatin1Char('/'))) t.remove(0, 1);
+            m_excludePaths.append(t);
+        } else {
+            m_excludeNames.append(t);
+        }
+    }
+}
+
+QStringList WalkFilter::defaultIncludeGlobs()
+{
+    return {"*.png", "*.jpg", "*.jpeg", "*.gif", "*.webp", "*.bmp"};
+}
+
+bool WalkFilter::globMatch(const QString &pattern, const QString &text)
+{
+    // 贪心匹配 + 回溯到最近的 *：O(模式长度 × 文本长度) 最坏，通常线性；模式已预先折叠大小写
+    int p = 0, t = 0, star = -1, mark = 0;
+    const int pn = pattern.length(), tn = text.length();
+    while (t < tn) {
+        if (p < pn && (pattern.at(p) == QLatin1Char('?') || pattern.at(p) == text.at(t).toCaseFolded())) {
+            ++p;
+            ++t;
+        } else if (p < pn && pattern.at(p) == QLatin1Char('*')) {
+            star = p++;
+            mark = t;
+        } else if (star >= 0) {
+            p = star + 1;
+            t = ++mark;
+        } else {
+            return false;
+        }
+    }
+    while (p < pn && pattern.at(p) == QLatin1Char('*')) ++p;
+    return p == pn;
+}
+
+bool WalkFilter::excluded(const QString &name, const QString &absolutePath) const
+{
+    for (const QString &g : m_excludeNames) {
+        if (globMatch(g, name)) return true;
+    }
+    if (m_excludePaths.isEmpty()) return false;
+    const QString rel = absolutePath.mid(m_rootPrefix);
+    for (const QString &g : m_excludePaths) {
+        if (globMatch(g, rel)) return true;
+    }
+    return false;
+}
+
+bool WalkFilter::acceptsFile(const QString &name, const QString &absolutePath) const
+{
+    if (excluded(name, absolutePath)) return false;
+    for (const QString &g : m_include) {
+        if (globMatch(g, name)) return true;
+    }
+    return false;
+}
+
+bool WalkFilter::acceptsDir(const QString &name, const QString &absolutePath) const
+{
+    return !excluded(name, absolutePath);
+}
+
+DirectoryWalker::DirectoryWalker(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<FoundFileList>("FoundFileList");
+    qRegisterMetaType<WalkedTree>("WalkedTree");
+    // 列目录主要等待 I/O，线程数可以多于核心数
+    m_pool.setMaxThreadCount(qMax(4, QThread::idealThreadCount()));
+}
+
+DirectoryWalker::~DirectoryWalker()
+{
+    if (m_job) m_job->cancelled.storeRelease(1);
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+FoundFileList DirectoryWalker::listDirectory(const QString &dir, const WalkFilter &filter, QStringList *subdirs,
+                                             const std::function<bool(FoundFileList &)> &flush)
+{
+    FoundFileList files;
+    // QDirIterator 的 QFileInfo 带有目录项中的大小与修改时间（Windows 上来自 FindNextFile），不需要逐个 stat
+    QDirIterator it(dir, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo fi = it.fileInfo();
+        if (fi.isSymLink() && !filter.followSymlinks()) continue;
+        const QString path = it.filePath();
+        if (fi.isDir()) {
+            if (subdirs && filter.recursive() && filter.acceptsDir(fi.fileName(), path)) subdirs->append(path);
+            continue;
+        }
+        if (!filter.acceptsFile(fi.fileName(), path)) continue;
+        FoundFile f;
+        f.path = path;
+        f.mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+        f.size = fi.size();
+        files.append(f);
+        if (flush && files.size() >= ChunkSize && !flush(files)) break;
+    }
+    return files;
+}
+
+void DirectoryWalker::listTree(const QString &dir, const WalkFilter &filter, QSet<QString> *visited, WalkedTree *out)
+{
+    QStringList stack{dir};
+    while (!stack.isEmpty()) {
+        const QString d = stack.takeLast();
+        const QString canonical = QFileInfo(d).canonicalFilePath();
+        if (canonical.isEmpty() || visited->contains(canonical)) continue;  // 不存在，或构成环
+        visited->insert(canonical);
+        WalkedDir &walked = (*out)[d];
+        walked.canonical = canonical;
+        walked.files = listDirectory(d, filter, &walked.subdirs);
+        stack += walked.subdirs;
+    }
+}
+
+void DirectoryWalker::start(const QString &root, const WalkOptions &options)
+{
+    cancel();
+    const QString dir = QDir::cleanPath(QDir(root).absolutePath());
+    m_job.reset(new WalkJob);
+    m_job->filter = WalkFilter(dir, options);
+    m_job->generation = ++m_generation;
+    m_job->receiver = this;
+    m_job->pool = &m_pool;
+    m_job->outstanding.storeRelease(1);
+    m_job->timer.start();
+    DEBUG_LOG("Directory walk started:" << dir << (options.recursive ? "recursive" : "flat"));
+    m_pool.start(new DirTask(m_job, dir));
+}
+
+void DirectoryWalker::cancel()
+{
+    if (!m_job) return;
+    m_job->cancelled.storeRelease(1);
+    m_pool.clear();  // 未开始的目录任务直接丢弃；已排队的回传按代数忽略
+    ++m_generation;
+    const int files = m_job->files.loadAcquire();
+    const int dirs = m_job->dirs.loadAcquire();
+    m_job.reset();
+    DEBUG_LOG("Directory walk cancelled after" << files << "files in" << dirs << "folders");
+    emit finished(files, dirs, true);
+}
+
+void DirectoryWalker::onFilesFound(int generation, const FoundFileList &files)
+{
+    if (generation != m_generation || !m_job) return;
+    if (!m_job->firstBatchLogged) {
+        m_job->firstBatchLogged = true;
+        DEBUG_LOG("Directory walk: first" << files.size() << "files after" << m_job->timer.elapsed() << "ms");
+    }
+    emit filesFound(files);
+}
+
+void DirectoryWalker::onWalkFinished(int generation)
+{
+    if (generation != m_generation || !m_job) return;
+    const int files = m_job->files.loadAcquire();
+    const int dirs = m_job->dirs.loadAcquire();
+    DEBUG_LOG("Directory walk finished:" << files << "files in" << dirs << "folders," << m_job->timer.elapsed() << "ms");
+    m_job.reset();
+    emit finished(files, dirs, false);
+}
@@ -0,0 +1,112 @@
+/*
+* 文件名：directorywalker.h
+* 日期：2026-10-16
+* 该文件功能大致描述：导入文件夹用的并行目录遍历。每个目录是线程池中的一个任务，列出目录项后把子目录作为新任务提交，
+*                    找到的文件每 ChunkSize 个回传一次，主线程边找边导入，不必等整棵树列完。按规范路径记录访问过的目录，
+*                    符号链接/目录联接构成的环不会无限遍历；文件名包含/排除规则用通配符（* ?，不区分大小写）。
+*                    同一套列目录与过滤逻辑也以同步形式提供给 FolderWatcher 的后台重新扫描。
+* 该文件函数功能描述：
+*   - FoundFile 结构体：找到的文件（路径、修改时间、大小，来自目录项的 stat 信息，不打开文件）
+*   - WalkOptions 结构体：是否递归、是否跟随符号链接、包含/排除通配符
+*   - WalkFilter：编译后的过滤规则（只读，可在多个线程中同时使用）
+*   - DirectoryWalker::start()：开始遍历（上一次未完成的遍历被取消）
+*   - DirectoryWalker::cancel()：取消遍历，已回传的文件保留
+*   - DirectoryWalker::listDirectory()/listTree()：同步列出一个目录 / 一棵目录树（FolderWatcher 在后台线程使用）
+*   - filesFound()/finished()：信号，一批找到的文件 / 遍历结束
+* 与该文件相关联的其他文件：directorywalker.cpp, folderwatcher.h, folderwatcher.cpp, mainwindow.cpp
+*/
+
+#ifndef DIRECTORYWALKER_H
+#define DIRECTORYWALKER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include <QMetaType>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <functional>
+
+struct FoundFile {
+    QString path;
+    qint64 mtimeMs = 0;
+    qint64 size = 0;
+};
+typedef QVector<FoundFile> FoundFileList;
+Q_DECLARE_METATYPE(FoundFileList)
+
+struct WalkOptions {
+    bool recursive = true;
+    bool followSymlinks = false;
+    QStringList includeGlobs;  // 匹配文件名；为空时使用 defaultIncludeGlobs()
+    QStringList excludeGlobs;  // 匹配文件名或目录名；含 '/' 的规则匹配相对根目录的路径
+};
+
+class WalkFilter {
+public:
+    WalkFilter() = default;
+    WalkFilter(const QString &root, const WalkOptions &options);
+
+    bool acceptsFile(const QString &name, const QString &absolutePath) const;
+    bool acceptsDir(const QString &name, const QString &absolutePath) const;
+    bool followSymlinks() const { return m_follow; }
+    bool recursive() const { return m_recursive; }
+
+    static QStringList defaultIncludeGlobs();
+    static bool globMatch(const QString &pattern, const QString &text);  // * 与 ?，不区分大小写
+
+private:
+    bool excluded(const QString &name, const QString &absolutePath) const;
+
+    int m_rootPrefix = 0;        // 相对路径 = 绝对路径.mid(m_rootPrefix)
+    QStringList m_include;
+    QStringList m_excludeNames;  // 只匹配名称的排除规则
+    QStringList m_excludePaths;  // 匹配相对路径的排除规则
+    bool m_follow = false;
+    bool m_recursive = true;
+};
+
+struct WalkedDir {
+    QString canonical;    // 规范路径（解析符号链接后），用于检测环
+    FoundFileList files;  // 该目录下直接包含的文件
+    QStringList subdirs;  // 直接子目录（已按规则过滤；非递归时为空）
+};
+typedef QHash<QString, WalkedDir> WalkedTree;  // 目录绝对路径 → 内容
+Q_DECLARE_METATYPE(WalkedTree)
+
+struct WalkJob;  // 前置声明：一次遍历的共享状态（各目录任务共用）
+
+class DirectoryWalker : public QObject {
+    Q_OBJECT
+public:
+    static const int ChunkSize = 256;  // 每批回传的文件数
+
+    explicit DirectoryWalker(QObject *parent = nullptr);
+    ~DirectoryWalker() override;
+
+    void start(const QString &root, const WalkOptions &options);
+    void cancel();
+    bool isRunning() const { return !m_job.isNull(); }
+
+    // 同步接口：flush 不为空时每 ChunkSize 个文件调用一次（交出并清空 files），返回 false 时停止列目录
+    static FoundFileList listDirectory(const QString &dir, const WalkFilter &filter, QStringList *subdirs,
+                                       const std::function<bool(FoundFileList &)> &flush = nullptr);
+    static void listTree(const QString &dir, const WalkFilter &filter, QSet<QString> *visited, WalkedTree *out);
+
+signals:
+    void filesFound(const FoundFileList &files);
+    void finished(int files, int dirs, bool cancelled);
+
+private slots:
+    void onFilesFound(int generation, const FoundFileList &files);
+    void onWalkFinished(int generation);
+
+private:
+    QThreadPool m_pool;
+    QSharedPointer<WalkJob> m_job;  // 当前遍历，空表示空闲
+    int m_generation = 0;           // 取消后到达的回传据此丢弃
+};
+
+#endif // DIRECTORYWALKER_H
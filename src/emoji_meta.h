@@ -4,7 +4,7 @@
 * 该文件功能大致描述：定义 EmojiItem 数据结构，用于在内存中保存表情项的元数据与排序信息；提供全局调试宏定义。
 * 该文件函数功能描述：
 *   - EmojiItem 结构体：包含文件路径、文件名、缩略图、创建时间、文件大小、排序索引等字段
-*   - DEBUG_LOG 宏：用于全局调试输出，可通过 ENABLE_DEBUG 开关控制
+*   - DEBUG_LOG 宏：用于全局调试输出，可通过 ENABLE_DEBUG 开关控制（未定义时跟随 QT_DEBUG，release 构建关闭）
 * 与该文件相关联的其他文件：mainwindow.cpp, mainwindow.h, emojilistwidget.cpp, emojilistwidget.h, emojilistdelegate.cpp, emojilistdelegate.h
 */
 
@@ -15,12 +15,21 @@
 #include <QPixmap>
 #include <QDateTime>
 
-#define ENABLE_DEBUG 1
+// 调试输出默认只在调试构建中打开：release 构建的导入、删除、鼠标事件、排序不再逐条写 qDebug()；
+// 需要时以 DEFINES += ENABLE_DEBUG=1 打开。耗时请用 trace.h 的 TRACE_SCOPE 记录，而不是打印
+#ifndef ENABLE_DEBUG
+    #ifdef QT_DEBUG
+        #define ENABLE_DEBUG 1
+    #else
+        #define ENABLE_DEBUG 0
+    #endif
+#endif
+#include <QDebug>
 #if ENABLE_DEBUG
-    #include <QDebug>
     #define DEBUG_LOG(x) qDebug() << "[DEBUG]" << x
 #else
-    #define DEBUG_LOG(x)
+    // 关闭时仍把参数编译一遍（不执行）：只为日志计算的局部变量不会触发未使用警告，if (...) DEBUG_LOG(...); 也不会成为空语句
+    #define DEBUG_LOG(x) do { if (false) qDebug() << x; } while (0)
 #endif
 
 
@@ -31,6 +40,9 @@ struct EmojiItem {
     QDateTime createTime;
     qint64 fileSize;
     int orderIndex;       // UPGRADE: 持久化排序索引
+    quint64 contentHash = 0;  // 文件内容哈希（按内容去重），0 表示未知
+    quint64 perceptualHash = 0;  // 感知哈希（dHash，查找相似图）
+    bool hasPerceptualHash = false;
 };
 
 #endif // EMOJI_ITEM_H
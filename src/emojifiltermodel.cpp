@@ -0,0 +1,324 @@
+#include "emojifiltermodel.h"
+#include "searchindex.h"
+
+#include <algorithm>
+
+namespace {
+const int MaxIncrementalRows = 256;  // dataChanged 超过该行数时整体重新过滤
+}
+
+EmojiFilterModel::EmojiFilterModel(QObject *parent)
+    : QAbstractProxyModel(parent)
+{
+}
+
+void EmojiFilterModel::setSourceModel(QAbstractItemModel *source)
+{
+    beginResetModel();
+    for (const QMetaObject::Connection &c : m_connections) disconnect(c);
+    m_connections.clear();
+    QAbstractProxyModel::setSourceModel(source);
+    m_src = qobject_cast<EmojiListModel *>(source);
+    if (m_src) {
+        m_connections << connect(m_src, &QAbstractItemModel::rowsAboutToBeInserted, this, &EmojiFilterModel::onRowsAboutToBeInserted)
+                      << connect(m_src, &QAbstractItemModel::rowsInserted, this, &EmojiFilterModel::onRowsInserted)
+                      << connect(m_src, &QAbstractItemModel::rowsAboutToBeRemoved, this, &EmojiFilterModel::onRowsAboutToBeRemoved)
+                      << connect(m_src, &QAbstractItemModel::rowsRemoved, this, &EmojiFilterModel::onRowsRemoved)
+                      << connect(m_src, &QAbstractItemModel::layoutAboutToBeChanged, this, &EmojiFilterModel::onLayoutAboutToBeChanged)
+                      << connect(m_src, &QAbstractItemModel::layoutChanged, this, &EmojiFilterModel::onLayoutChanged)
+                      << connect(m_src, &QAbstractItemModel::modelAboutToBeReset, this, &EmojiFilterModel::onModelAboutToBeReset)
+                      << connect(m_src, &QAbstractItemModel::modelReset, this, &EmojiFilterModel::onModelReset)
+                      << connect(m_src, &QAbstractItemModel::dataChanged, this, &EmojiFilterModel::onDataChanged);
+    }
+    m_active = false;
+    m_pinned = false;
+    m_query.clear();
+    m_ids.clear();
+    m_rows.clear();
+    endResetModel();
+}
+
+void EmojiFilterModel::setFilterText(const QString &text)
+{
+    const QString q = SearchIndex::fold(text.trimmed());
+    if ((q == m_query && !m_pinned) || !m_src) return;
+
+    beginResetModel();
+    const bool wasPinned = m_pinned;
+    m_pinned = false;
+    if (q.isEmpty()) {
+        m_active = false;
+        m_ids.clear();
+        m_rows.clear();
+    } else if (m_active && !wasPinned && q.contains(m_query)) {
+        // 继续输入：结果只会变少，在上一次的结果里校验即可
+        QVector<int> kept;
+        kept.reserve(m_ids.size());
+        for (int id : m_ids) {
+            if (m_src->idMatches(id, q)) kept.append(id);
+        }
+        m_ids.swap(kept);
+        m_active = true;
+    } else {
+        m_ids = m_src->searchIds(q);
+        m_active = true;
+    }
+    m_query = q;
+    if (m_active) rebuildRows();
+    endResetModel();
+}
+
+void EmojiFilterModel::setIdFilter(const QVector<int> &ids)
+{
+    if (!m_src) return;
+    beginResetModel();
+    m_query.clear();
+    m_active = true;
+    m_pinned = true;
+    m_ids = ids;
+    rebuildRows();
+    endResetModel();
+}
+
+void EmojiFilterModel::rebuildRows()
+{
+    m_rows.clear();
+    m_rows.reserve(m_ids.size());
+    if (m_pinned) {
+        QVector<int> live;
+        live.reserve(m_ids.size());
+        for (int id : m_ids) {
+            const int row = m_src->rowOfId(id);
+            if (row < 0) continue;  // 已删除
+            m_rows.append(row);
+            live.append(id);
+        }
+        m_ids.swap(live);
+        return;
+    }
+    // m_ids 中可能有已删除、改名后不再匹配或重复加入的 ID：在这里一并剔除
+    for (int id : m_ids) {
+        const int row = m_src->rowOfId(id);
+        if (row >= 0 && m_src->idMatches(id, m_query)) m_rows.append(row);
+    }
+    std::sort(m_rows.begin(), m_rows.end());
+    m_rows.erase(std::unique(m_rows.begin(), m_rows.end()), m_rows.end());
+    m_ids.resize(m_rows.size());
+    for (int i = 0; i < m_rows.size(); ++i) m_ids[i] = m_src->idOfRow(m_rows.at(i));
+}
+
+int EmojiFilterModel::proxyRowOf(int sourceRow) const
+{
+    if (!m_active) return sourceRow;
+    if (m_pinned) return m_rows.indexOf(sourceRow);  // 结果集很小（相似图），线性查找即可
+    auto it = std::lower_bound(m_rows.constBegin(), m_rows.constEnd(), sourceRow);
+    return (it != m_rows.constEnd() && *it == sourceRow) ? int(it - m_rows.constBegin()) : -1;
+}
+
+QModelIndex EmojiFilterModel::index(int row, int column, const QModelIndex &parent) const
+{
+    return hasIndex(row, column, parent) ? createIndex(row, column) : QModelIndex();
+}
+
+QModelIndex EmojiFilterModel::parent(const QModelIndex &) const
+{
+    return QModelIndex();
+}
+
+int EmojiFilterModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !m_src) return 0;
+    return m_active ? m_rows.size() : m_src->rowCount();
+}
+
+int EmojiFilterModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 1;
+}
+
+QModelIndex EmojiFilterModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!proxyIndex.isValid() || !m_src) return QModelIndex();
+    return m_src->index(sourceRow(proxyIndex.row()), proxyIndex.column());
+}
+
+QModelIndex EmojiFilterModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid()) return QModelIndex();
+    const int row = proxyRowOf(sourceIndex.row());
+    return row < 0 ? QModelIndex() : index(row, sourceIndex.column());
+}
+
+void EmojiFilterModel::onRowsAboutToBeInserted(const QModelIndex &, int first, int last)
+{
+    if (!m_active) beginInsertRows(QModelIndex(), first, last);
+}
+
+void EmojiFilterModel::onRowsInserted(const QModelIndex &, int first, int last)
+{
+    if (!m_active) {
+        endInsertRows();
+        return;
+    }
+    // 插入点之后的源行号整体后移；代理行号不变
+    const int count = last - first + 1;
+    if (m_pinned) {
+        for (int &r : m_rows) {
+            if (r >= first) r += count;
+        }
+        return;  // 固定结果集不接收新条目
+    }
+    auto pos = std::lower_bound(m_rows.begin(), m_rows.end(), first);
+    for (auto it = pos; it != m_rows.end(); ++it) *it += count;
+
+    QVector<int> added;
+    for (int r = first; r <= last; ++r) {
+        const int id = m_src->idOfRow(r);
+        if (m_src->idMatches(id, m_query)) {
+            added.append(r);
+            m_ids.append(id);
+        }
+    }
+    if (added.isEmpty()) return;
+    const int at = int(pos - m_rows.begin());
+    beginInsertRows(QModelIndex(), at, at + added.size() - 1);
+    m_rows.insert(at, added.size(), 0);
+    std::copy(added.constBegin(), added.constEnd(), m_rows.begin() + at);
+    endInsertRows();
+}
+
+void EmojiFilterModel::onRowsAboutToBeRemoved(const QModelIndex &, int first, int last)
+{
+    if (!m_active) {
+        beginRemoveRows(QModelIndex(), first, last);
+        return;
+    }
+    if (m_pinned) {
+        beginResetModel();  // 删除的行在代理中不一定连续
+        return;
+    }
+    m_removeLo = int(std::lower_bound(m_rows.constBegin(), m_rows.constEnd(), first) - m_rows.constBegin());
+    m_removeHi = int(std::upper_bound(m_rows.constBegin(), m_rows.constEnd(), last) - m_rows.constBegin());
+    if (m_removeLo < m_removeHi) beginRemoveRows(QModelIndex(), m_removeLo, m_removeHi - 1);
+}
+
+void EmojiFilterModel::onRowsRemoved(const QModelIndex &, int first, int last)
+{
+    if (!m_active) {
+        endRemoveRows();
+        return;
+    }
+    if (m_pinned) {
+        rebuildRows();  // 按 ID 重新得到源行号，剔除已删除的条目，顺序不变
+        endResetModel();
+        return;
+    }
+    const int count = last - first + 1;
+    const bool removed = m_removeLo < m_removeHi;
+    m_rows.erase(m_rows.begin() + m_removeLo, m_rows.begin() + m_removeHi);
+    for (auto it = m_rows.begin() + m_removeLo; it != m_rows.end(); ++it) *it -= count;
+    m_removeLo = m_removeHi = -1;
+    if (removed) endRemoveRows();  // 删除的 ID 留在 m_ids 中，下次校验时剔除
+}
+
+void EmojiFilterModel::onLayoutAboutToBeChanged()
+{
+    emit layoutAboutToBeChanged();
+    m_layoutFrom = persistentIndexList();
+    m_layoutIds.clear();
+    m_layoutIds.reserve(m_layoutFrom.size());
+    for (const QModelIndex &idx : m_layoutFrom) m_layoutIds.append(m_src->idOfRow(sourceRow(idx.row())));
+}
+
+void EmojiFilterModel::onLayoutChanged()
+{
+    if (m_active) rebuildRows();  // 匹配集合不变，只是源行号变了
+    QModelIndexList to;
+    to.reserve(m_layoutFrom.size());
+    for (int id : m_layoutIds) {
+        const int row = proxyRowOf(m_src->rowOfId(id));
+        to.append(row < 0 ? QModelIndex() : index(row, 0));
+    }
+    changePersistentIndexList(m_layoutFrom, to);
+    m_layoutFrom.clear();
+    m_layoutIds.clear();
+    emit layoutChanged();
+}
+
+void EmojiFilterModel::onModelAboutToBeReset()
+{
+    beginResetModel();
+}
+
+void EmojiFilterModel::onModelReset()
+{
+    if (m_pinned) {
+        // 重新加载后槽位号重新分配，固定的 ID 已无意义
+        m_pinned = false;
+        m_active = false;
+        m_ids.clear();
+        m_rows.clear();
+    } else if (m_active) {
+        m_ids = m_src->searchIds(m_query);
+        rebuildRows();
+    }
+    endResetModel();
+}
+
+void EmojiFilterModel::insertMatch(int sourceRow)
+{
+    const int at = int(std::lower_bound(m_rows.constBegin(), m_rows.constEnd(), sourceRow) - m_rows.constBegin());
+    beginInsertRows(QModelIndex(), at, at);
+    m_rows.insert(at, sourceRow);
+    endInsertRows();
+}
+
+void EmojiFilterModel::removeMatch(int proxyRow)
+{
+    beginRemoveRows(QModelIndex(), proxyRow, proxyRow);
+    m_rows.remove(proxyRow);
+    endRemoveRows();
+}
+
+void EmojiFilterModel::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    const int first = topLeft.row(), last = bottomRight.row();
+    if (!m_active) {
+        emit dataChanged(index(first, 0), index(last, 0), roles);
+        return;
+    }
+    if (m_pinned) {
+        int lo = m_rows.size(), hi = -1;
+        for (int i = 0; i < m_rows.size(); ++i) {
+            if (m_rows.at(i) < first || m_rows.at(i) > last) continue;
+            lo = qMin(lo, i);
+            hi = qMax(hi, i);
+        }
+        if (lo <= hi) emit dataChanged(index(lo, 0), index(hi, 0), roles);
+        return;
+    }
+    if (roles.isEmpty() || roles.contains(Qt::DisplayRole)) {
+        // 改名可能让条目进入或离开过滤结果
+        if (last - first + 1 > MaxIncrementalRows) {
+            beginResetModel();
+            m_ids = m_src->searchIds(m_query);
+            rebuildRows();
+            endResetModel();
+            return;
+        }
+        for (int r = first; r <= last; ++r) {
+            const int id = m_src->idOfRow(r);
+            const bool match = m_src->idMatches(id, m_query);
+            const int row = proxyRowOf(r);
+            if (match && row < 0) {
+                insertMatch(r);
+                m_ids.append(id);  // 可能重复：rebuildRows() 时去重
+            } else if (!match && row >= 0) {
+                removeMatch(row);
+            }
+        }
+    }
+    const int lo = int(std::lower_bound(m_rows.constBegin(), m_rows.constEnd(), first) - m_rows.constBegin());
+    const int hi = int(std::upper_bound(m_rows.constBegin(), m_rows.constEnd(), last) - m_rows.constBegin());
+    if (lo < hi) emit dataChanged(index(lo, 0), index(hi - 1, 0), roles);
+}
@@ -0,0 +1,75 @@
+/*
+* 文件名：emojifiltermodel.h
+* 日期：2026-10-16
+* 该文件功能大致描述：表情列表的过滤代理。位于 EmojiListModel 与视图之间，按工具栏搜索框的文本只显示名称或路径匹配的条目；
+*                    匹配由模型内的 SearchIndex 回答，源模型的数据从不重建。未过滤时为一一映射，源模型的增删/重排原样转发；
+*                    过滤时保存匹配行（源行号，升序），源模型增删、改名、排序时增量维护。输入的文本是上一次查询的扩展时，
+*                    只在上一次的结果中继续缩小范围。另有固定结果集模式（查找相似/聚类相似）：按给定的 ID 顺序显示，
+*                    新插入的条目不加入，删除/排序后按原顺序保留剩余条目。
+* 该文件函数功能描述：
+*   - setFilterText()：设置过滤文本（空串表示不过滤），大小写不敏感的子串匹配；同时退出固定结果集模式
+*   - setIdFilter()：只显示给定的稳定 ID，按给定顺序（源模型重置时自动退出）
+*   - sourceRow()：代理行号 → 源行号（MainWindow 用于访问 EmojiListModel::item()）
+*   - mapToSource()/mapFromSource()/index()/rowCount() 等：QAbstractProxyModel 接口
+* 与该文件相关联的其他文件：emojifiltermodel.cpp, emojilistmodel.h, searchindex.h, mainwindow.cpp
+*/
+
+#ifndef EMOJIFILTERMODEL_H
+#define EMOJIFILTERMODEL_H
+
+#include <QAbstractProxyModel>
+#include <QVector>
+#include "emojilistmodel.h"
+
+class EmojiFilterModel : public QAbstractProxyModel {
+    Q_OBJECT
+public:
+    explicit EmojiFilterModel(QObject *parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel *source) override;
+    EmojiListModel *emojiModel() const { return m_src; }
+
+    void setFilterText(const QString &text);
+    void setIdFilter(const QVector<int> &ids);
+    bool isFiltering() const { return m_active; }
+    bool isPinned() const { return m_pinned; }
+    int sourceRow(int row) const { return m_active ? m_rows.at(row) : row; }
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override;
+
+private slots:
+    void onRowsAboutToBeInserted(const QModelIndex &parent, int first, int last);
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onLayoutAboutToBeChanged();
+    void onLayoutChanged();
+    void onModelAboutToBeReset();
+    void onModelReset();
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+
+private:
+    int proxyRowOf(int sourceRow) const;  // 过滤时二分查找；不匹配返回 -1
+    void rebuildRows();                   // 由匹配的 ID 重新得到源行号（过滤时同时重新校验匹配）
+    void insertMatch(int sourceRow);
+    void removeMatch(int proxyRow);
+
+    EmojiListModel *m_src = nullptr;
+    QVector<QMetaObject::Connection> m_connections;
+    QString m_query;                      // 折叠后的过滤文本
+    bool m_active = false;
+    bool m_pinned = false;                // 固定结果集：m_rows 按 m_ids 的顺序，不再升序
+    QVector<int> m_ids;                   // 匹配的稳定 ID；过滤时可能含已删除、不再匹配或重复的，rebuildRows() 时剔除
+    QVector<int> m_rows;                  // 匹配的源行号，升序（固定结果集时与 m_ids 一一对应）
+    int m_removeLo = -1;                  // 源模型删除期间：受影响的代理行区间
+    int m_removeHi = -1;
+    QModelIndexList m_layoutFrom;         // 源模型重排期间：持久化索引及其 ID
+    QVector<int> m_layoutIds;
+};
+
+#endif // EMOJIFILTERMODEL_H
@@ -1,11 +1,46 @@
 #include "emojilistdelegate.h"
+#include "emojilistmodel.h"
+#include "framecache.h"
+#include "animationclock.h"
+#include "trace.h"
 #include <QPainter>
+#include <QPainterPath>
 #include <QApplication>
 #include <QStyleOptionViewItem>
+#include <QFontMetrics>
+#include <QIcon>
+
+namespace {
+
+const int kScaledCacheKb = 64 * 1024;  // 预缩放缩略图缓存上限（KB）
+const int kMaxNames = 8192;            // 文本缓存条数上限，超出后整体清空
+
+// 预渲染一种状态的单元格背景（圆角底 + 可选边框），之后每次绘制只需一次 drawPixmap
+QPixmap renderBackground(const QSize &cell, qreal dpr, const QColor &fill, const QPen &border)
+{
+    QPixmap pm(cell * dpr);
+    pm.setDevicePixelRatio(dpr);
+    pm.fill(Qt::transparent);
+    QPainter p(&pm);
+    p.setRenderHint(QPainter::Antialiasing, true);
+    QPainterPath path;
+    path.addRoundedRect(QRect(QPoint(0, 0), cell).adjusted(4,4,-4,-4), 8, 8);
+    p.fillPath(path, QBrush(fill));
+    if (border.style() != Qt::NoPen) {
+        p.setPen(border);
+        p.drawPath(path);
+    }
+    return pm;
+}
+
+} // namespace
 
 EmojiListDelegate::EmojiListDelegate(QObject *parent)
-    : QStyledItemDelegate(parent)
-{}
+    : QStyledItemDelegate(parent),
+      m_textPen(QColor(80,80,80))
+{
+    m_scaled.setMaxCost(kScaledCacheKb);
+}
 
 QSize EmojiListDelegate::sizeHint(const QStyleOptionViewItem & /*option*/, const QModelIndex & /*index*/) const
 {
@@ -13,67 +48,106 @@ QSize EmojiListDelegate::sizeHint(const QStyleOptionViewItem & /*option*/, const
     return QSize(120, 120);
 }
 
-void EmojiListDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+void EmojiListDelegate::ensureBackgrounds(const QSize &cellSize, qreal dpr) const
 {
-    painter->save();
+    if (cellSize == m_bgSize && qFuzzyCompare(dpr, m_dpr)) return;
+    // 预缩放缩略图的目标尺寸由单元格尺寸与像素比决定，缓存只以原缩略图为键：两者任一变化都要全部失效
+    m_scaled.clear();
+    m_bgSize = cellSize;
+    m_dpr = dpr;
 
-    QRect rect = option.rect;
-    // 背景（圆角白底 + 毛玻璃感可用更复杂的绘制，这里绘制圆角背景）
     // 【优化】：区分三种状态 - 选中、悬停、普通
-    QColor bg;
-    if (option.state & QStyle::State_Selected) {
-        // 选中状态：更明显的背景色
-        bg = QColor(230, 240, 255, 240);  // 淡蓝色背景
-    } else if (option.state & QStyle::State_MouseOver) {
-        // 悬停状态：半透明白色
-        bg = QColor(255, 255, 255, 230);
-    } else {
-        // 普通状态：更透明的白色
-        bg = QColor(255, 255, 255, 245);
-    }
-    
-    QBrush brush(bg);
-    painter->setRenderHint(QPainter::Antialiasing, true);
+    // 普通状态：更透明的白色
+    m_bgNormal = renderBackground(cellSize, dpr, QColor(255, 255, 255, 245), QPen(Qt::NoPen));
+    // 悬停状态：半透明白色 + 较淡的蓝色边框
+    m_bgHover = renderBackground(cellSize, dpr, QColor(255, 255, 255, 230), QPen(QColor(0, 122, 255, 80), 2));
+    // 选中状态：淡蓝色背景 + iOS蓝色高亮边框，更粗更明显
+    m_bgSelected = renderBackground(cellSize, dpr, QColor(230, 240, 255, 240), QPen(QColor(0, 122, 255, 200), 2.5));
+}
 
-    QRect rBg = rect.adjusted(4,4,-4,-4);
-    QPainterPath path;
-    path.addRoundedRect(rBg, 8, 8);
-    painter->fillPath(path, brush);
+const QPixmap *EmojiListDelegate::scaledThumbnail(const QModelIndex &index, const QSize &target, qreal dpr) const
+{
+    // 命中：只读取一个 qint64，不取出 QPixmap
+    const qint64 key = index.data(EmojiListModel::ThumbnailKeyRole).toLongLong();
+    if (key) {
+        if (const QPixmap *hit = m_scaled.object(key)) return hit;
+    }
 
-    // 绘制缩略图（来自 DecorationRole）
+    // 未命中：取出缩略图（来自 DecorationRole），按单元格实际像素尺寸缩放一次
     QVariant dec = index.data(Qt::DecorationRole);
     QPixmap pix;
     if (dec.canConvert<QPixmap>()) pix = dec.value<QPixmap>();
     else if (dec.canConvert<QIcon>()) pix = dec.value<QIcon>().pixmap(96,96);
+    if (pix.isNull()) return nullptr;
 
-    if (!pix.isNull()) {
-        // 计算图片区域（居中）
-        QSize pixSz = pix.size();
-        QSize targetSz(rBg.width()-12, rBg.height()-36);
-        QPixmap scaled = pix.scaled(targetSz, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        QPoint center(rBg.left() + (rBg.width()-scaled.width())/2, rBg.top() + 8);
-        painter->drawPixmap(center, scaled);
-    }
+    QPixmap *scaled = new QPixmap(pix.scaled(target * dpr, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    scaled->setDevicePixelRatio(dpr);
+    const qint64 cacheKey = key ? key : pix.cacheKey();
+    m_scaled.insert(cacheKey, scaled, qMax(1, scaled->width() * scaled->height() * 4 / 1024));
+    return m_scaled.object(cacheKey);
+}
 
-    // 绘制文件名（可隐藏由 MainWindow 控制，存在 DisplayRoleTextHidden flag）
-    bool showName = index.data(Qt::UserRole + 10).toBool(); // UPGRADE: 控制是否显示文件名（由 MainWindow 设置）
-    if (showName) {
-        QString text = index.data(Qt::DisplayRole).toString();
-        QRect textRect(rBg.left()+6, rBg.bottom()-24, rBg.width()-12, 20);
-        painter->setPen(QColor(80,80,80));
-        painter->drawText(textRect, Qt::AlignCenter | Qt::TextSingleLine, text);
+const QPixmap *EmojiListDelegate::animationFrame(const QModelIndex &index, const QSize &target, qreal dpr) const
+{
+    if (!m_frames || !m_clock) return nullptr;
+    const QString path = index.data(EmojiListModel::FilePathRole).toString();  // 隐式共享，不复制字符串
+    if (!FrameCache::mayBeAnimated(path)) return nullptr;
+    // 帧已按单元格像素尺寸解码；未命中时帧缓存在后台解码，这一次先画静态缩略图
+    const AnimatedFrames *anim = m_frames->frames(path, target, dpr);
+    return anim ? &anim->frames.at(anim->frameAt(m_clock->now())) : nullptr;
+}
+
+const QStaticText &EmojiListDelegate::nameText(const QString &text, const QFont &font, int width) const
+{
+    if (width != m_nameWidth || font != m_nameFont) {
+        m_names.clear();
+        m_nameWidth = width;
+        m_nameFont = font;
     }
+    auto it = m_names.constFind(text);
+    if (it != m_names.constEnd()) return it.value();
+
+    if (m_names.size() >= kMaxNames) m_names.clear();
+    QStaticText st(QFontMetrics(font).elidedText(text, Qt::ElideMiddle, width));
+    st.setTextFormat(Qt::PlainText);
+    st.prepare(QTransform(), font);
+    return *m_names.insert(text, st);
+}
+
+void EmojiListDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    TRACE_SCOPE(Trace::Paint, "EmojiListDelegate::paint");
+    // 稳定状态下整个函数不分配堆内存：背景、缩略图、文本全部来自缓存，只有 drawPixmap/drawStaticText
+    const QRect rect = option.rect;
+    const qreal dpr = painter->device()->devicePixelRatioF();
+    ensureBackgrounds(rect.size(), dpr);
 
-    // 【优化】：高亮边框 - 区分选中和悬停状态
-    if (option.state & QStyle::State_Selected) {
-        // 选中状态：iOS蓝色高亮边框，更粗更明显
-        painter->setPen(QPen(QColor(0, 122, 255, 200), 2.5));
-        painter->drawPath(path);
-    } else if (option.state & QStyle::State_MouseOver) {
-        // 悬停状态：较淡的蓝色边框
-        painter->setPen(QPen(QColor(0, 122, 255, 80), 2));
-        painter->drawPath(path);
+    // 背景与高亮边框（预渲染）
+    const QPixmap &bg = (option.state & QStyle::State_Selected) ? m_bgSelected
+                      : (option.state & QStyle::State_MouseOver) ? m_bgHover
+                      : m_bgNormal;
+    painter->drawPixmap(rect.topLeft(), bg);
+
+    // 绘制缩略图（已按目标尺寸和像素比预缩放，居中）
+    const QRect rBg = rect.adjusted(4,4,-4,-4);
+    const QSize targetSz(rBg.width()-12, rBg.height()-36);
+    const QPixmap *thumb = animationFrame(index, targetSz, dpr);
+    if (!thumb) thumb = scaledThumbnail(index, targetSz, dpr);
+    if (thumb) {
+        const QSize logical = thumb->size() / dpr;
+        painter->drawPixmap(QPoint(rBg.left() + (rBg.width()-logical.width())/2, rBg.top() + 8), *thumb);
     }
 
-    painter->restore();
+    // 绘制文件名（可隐藏由 MainWindow 控制，存在 DisplayRoleTextHidden flag）
+    bool showName = index.data(EmojiListModel::ShowNameRole).toBool(); // UPGRADE: 控制是否显示文件名（由 MainWindow 设置）
+    if (showName) {
+        const QRect textRect(rBg.left()+6, rBg.bottom()-24, rBg.width()-12, 20);
+        const QStaticText &text = nameText(index.data(Qt::DisplayRole).toString(), painter->font(), textRect.width());
+        const QSizeF ts = text.size();
+        const QPen oldPen = painter->pen();
+        painter->setPen(m_textPen);
+        painter->drawStaticText(QPointF(textRect.left() + (textRect.width() - ts.width()) / 2,
+                                        textRect.top() + (textRect.height() - ts.height()) / 2), text);
+        painter->setPen(oldPen);
+    }
 }
@@ -13,13 +13,24 @@
 *   - paint()：重写绘制函数，绘制圆角背景、悬停/选中高亮边框、表情缩略图以及文件名（可选）
 *   - sizeHint()：返回每个列表项的尺寸提示
 *   - setShowNames()：控制是否显示文件名
-* 与该文件相关联的其他文件：emojilistdelegate.cpp, emojilistwidget.h, emojilistwidget.cpp, mainwindow.h, mainwindow.cpp
+*   - 绘制缓存：三种状态的背景（含边框）预渲染为 QPixmap；缩略图按单元格实际尺寸与设备像素比预缩放后缓存；
+*     省略后的文件名缓存为 QStaticText。稳定状态下绘制一个单元格不分配堆内存、不重采样。
+*   - setAnimation()：设置动图帧缓存与共享时钟；GIF/WebP 单元格按时钟时间绘制当前帧，帧尚未解码时先绘制静态缩略图
+* 与该文件相关联的其他文件：emojilistdelegate.cpp, framecache.h, animationclock.h, emojilistwidget.h, emojilistwidget.cpp, mainwindow.h, mainwindow.cpp
 */
 
 #ifndef EMOJILISTDELEGATE_H
 #define EMOJILISTDELEGATE_H
 
 #include <QStyledItemDelegate>
+#include <QCache>
+#include <QHash>
+#include <QPixmap>
+#include <QStaticText>
+#include <QPen>
+
+class FrameCache;
+class AnimationClock;
 
 class EmojiListDelegate : public QStyledItemDelegate {
     Q_OBJECT
@@ -27,6 +38,27 @@ public:
     explicit EmojiListDelegate(QObject *parent = nullptr);
     void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
     QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    void setAnimation(FrameCache *frames, AnimationClock *clock) { m_frames = frames; m_clock = clock; }
+
+private:
+    void ensureBackgrounds(const QSize &cellSize, qreal dpr) const;
+    const QPixmap *scaledThumbnail(const QModelIndex &index, const QSize &target, qreal dpr) const;
+    const QPixmap *animationFrame(const QModelIndex &index, const QSize &target, qreal dpr) const;
+    const QStaticText &nameText(const QString &text, const QFont &font, int width) const;
+
+    // 以下缓存只在 paint() 中按需填充，因此声明为 mutable
+    mutable QPixmap m_bgNormal;       // 普通状态背景
+    mutable QPixmap m_bgHover;        // 悬停状态背景 + 淡蓝边框
+    mutable QPixmap m_bgSelected;     // 选中状态背景 + 蓝色边框
+    mutable QSize m_bgSize;           // 背景缓存对应的单元格尺寸
+    mutable qreal m_dpr = 0;          // 缓存对应的设备像素比，变化时全部失效
+    mutable QCache<qint64, QPixmap> m_scaled;      // 原缩略图 cacheKey → 预缩放缩略图
+    mutable QHash<QString, QStaticText> m_names;   // 显示名 → 省略后的静态文本
+    mutable int m_nameWidth = -1;     // 文本缓存对应的可用宽度
+    mutable QFont m_nameFont;         // 文本缓存对应的字体
+    QPen m_textPen;                   // 预先构造，避免每次绘制创建 QPen
+    FrameCache *m_frames = nullptr;   // 动图帧缓存与共享时钟（由 MainWindow 持有，可为空）
+    AnimationClock *m_clock = nullptr;
 };
 
 #endif // EMOJILISTDELEGATE_H
@@ -0,0 +1,388 @@
+#include "emojilistmodel.h"
+#include "emojimimedata.h"
+#include "trace.h"
+
+#include <QPainter>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
+EmojiListModel::EmojiListModel(QObject *parent)
+    : QAbstractListModel(parent),
+      m_placeholder(96, 96)
+{
+    // 占位图只绘制一次：浅灰圆角块，滚动到未加载区域时几乎没有绘制成本
+    m_placeholder.fill(Qt::transparent);
+    QPainter p(&m_placeholder);
+    p.setRenderHint(QPainter::Antialiasing, true);
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(235, 235, 240));
+    p.drawRoundedRect(m_placeholder.rect().adjusted(8, 8, -8, -8), 10, 10);
+}
+
+int EmojiListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+QVariant EmojiListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) return QVariant();
+    const EmojiItem &it = item(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return it.fileName;
+    case Qt::DecorationRole:
+        // 直接返回 QPixmap，委托无需再从 QIcon 转换；未加载时返回占位图
+        return it.thumbnail.isNull() ? m_placeholder : it.thumbnail;
+    case FilePathRole:
+        return it.filePath;
+    case ShowNameRole:
+        return m_showNames;
+    case ThumbnailKeyRole:
+        return (it.thumbnail.isNull() ? m_placeholder : it.thumbnail).cacheKey();
+    default:
+        return QVariant();
+    }
+}
+
+bool EmojiListModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) return false;
+    if (role != Qt::DisplayRole && role != Qt::EditRole) return false;
+    const int slot = slotAt(index.row());
+    m_slots[slot].fileName = value.toString();  // 只改显示名，不重命名磁盘文件
+    m_sort.renameItem(slot, m_slots.at(slot).fileName);
+    if (m_searchBuilt) m_search.renameItem(slot, m_slots.at(slot).fileName);
+    if (m_sortedBy == SortByName) m_sortedBy = -1;
+    emit dataChanged(index, index, {Qt::DisplayRole, Qt::EditRole});
+    return true;
+}
+
+Qt::ItemFlags EmojiListModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsDragEnabled;
+}
+
+QStringList EmojiListModel::mimeTypes() const
+{
+    return EmojiMimeData(QStringList()).formats();
+}
+
+QMimeData *EmojiListModel::mimeData(const QModelIndexList &indexes) const
+{
+    // 默认实现会把每行的所有角色（包括缩略图）序列化；这里只记录路径，格式由接收方按需取
+    QStringList paths;
+    paths.reserve(indexes.size());
+    for (const QModelIndex &idx : indexes) {
+        if (idx.isValid() && idx.row() < m_rows.size()) paths.append(item(idx.row()).filePath);
+    }
+    return paths.isEmpty() ? nullptr : new EmojiMimeData(paths, m_images);  // 拖到接收方后解码也经共享缓存
+}
+
+int EmojiListModel::takeSlot(const EmojiItem &item)
+{
+    int slot;
+    if (!m_freeSlots.isEmpty()) {
+        slot = m_freeSlots.takeLast();
+        m_slots[slot] = item;
+    } else {
+        slot = m_slots.size();
+        m_slots.append(item);
+    }
+    m_slotsOfPath.insert(item.filePath, slot);
+    m_sort.setItem(slot, item);
+    if (m_searchBuilt) m_search.setItem(slot, item.fileName, item.filePath);
+    if (m_similarBuilt && item.hasPerceptualHash) m_similar.insert(slot, item.perceptualHash);
+    return slot;
+}
+
+bool EmojiListModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > m_rows.size()) return false;
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    // 反向显示时，可见的连续区间在存储中同样连续，只是位置从尾部算起
+    const int first = m_reversed ? m_rows.size() - row - count : row;
+    for (int r = first; r < first + count; ++r) {
+        const int slot = m_rows.at(r);
+        m_slotsOfPath.remove(m_slots.at(slot).filePath, slot);
+        m_slots[slot] = EmojiItem();  // 释放字符串与缩略图，槽位留待复用
+        m_freeSlots.append(slot);
+        m_sort.removeItem(slot);
+        if (m_searchBuilt) m_search.removeItem(slot);
+        if (m_similarBuilt) m_similar.remove(slot);
+    }
+    // 只移动 int 数组，条目本身不动；删除不破坏已排好的顺序
+    m_rows.erase(m_rows.begin() + first, m_rows.begin() + first + count);
+    m_rowIndexDirty = true;
+    endRemoveRows();
+    return true;
+}
+
+int EmojiListModel::removeRowSet(QVector<int> rows)
+{
+    TRACE_SCOPE(Trace::Model, "EmojiListModel::removeRowSet");
+    // 从下往上按连续区间删除，已删除的区间不影响上方区间的行号
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    int ranges = 0;
+    for (int i = 0; i < rows.size();) {
+        const int last = rows.at(i);
+        int first = last;
+        while (++i < rows.size() && rows.at(i) == first - 1) --first;
+        removeRows(first, last - first + 1);
+        ++ranges;
+    }
+    return ranges;
+}
+
+void EmojiListModel::setItems(const QVector<EmojiItem> &items)
+{
+    TRACE_SCOPE(Trace::Model, "EmojiListModel::setItems");
+    beginResetModel();
+    m_slots = items;
+    m_freeSlots.clear();
+    m_slotsOfPath.clear();
+    m_slotsOfPath.reserve(items.size());
+    m_rows.resize(items.size());
+    m_rowOfSlot.resize(items.size());
+    m_sort.clear();
+    m_search.clear();
+    m_searchBuilt = false;  // 搜索索引在第一次搜索时才建立，加载时不花时间
+    m_similar.clear();
+    m_similarBuilt = false;
+    for (int i = 0; i < items.size(); ++i) {
+        m_rows[i] = i;
+        m_rowOfSlot[i] = i;
+        m_slotsOfPath.insert(items.at(i).filePath, i);
+        m_sort.setItem(i, items.at(i));
+    }
+    m_rowIndexDirty = false;
+    m_reversed = false;
+    m_sortedBy = -1;
+    endResetModel();
+}
+
+void EmojiListModel::appendItems(const QVector<EmojiItem> &items)
+{
+    TRACE_SCOPE(Trace::Model, "EmojiListModel::appendItems");
+    if (items.isEmpty()) return;
+    const int first = m_rows.size();
+    beginInsertRows(QModelIndex(), first, first + items.size() - 1);
+    if (m_reversed) {
+        // 反向显示时，可见的末尾是存储的开头：这批条目按逆序放到存储前面（一批只移动一次）
+        QVector<int> added;
+        added.reserve(items.size());
+        for (const EmojiItem &it : items) added.prepend(takeSlot(it));
+        m_rows = added + m_rows;
+        m_rowIndexDirty = true;
+    } else {
+        for (const EmojiItem &it : items) {
+            const int slot = takeSlot(it);
+            // 追加不会移动已有行，行索引可以增量维护
+            if (!m_rowIndexDirty) {
+                if (m_rowOfSlot.size() <= slot) m_rowOfSlot.resize(slot + 1);
+                m_rowOfSlot[slot] = m_rows.size();
+            }
+            m_rows.append(slot);
+        }
+    }
+    m_sortedBy = -1;  // 新条目排在末尾，当前顺序不再是某个排序依据的结果
+    endInsertRows();
+}
+
+void EmojiListModel::sortItems(SortKey key, Qt::SortOrder order)
+{
+    TRACE_SCOPE(Trace::Model, "EmojiListModel::sortItems");
+    const bool descending = order == Qt::DescendingOrder;
+    if (m_sortedBy == key) {
+        setReversed(descending);  // 只切换升序/降序：不重新排序
+        return;
+    }
+
+    // 升序槽位序列由排序引擎缓存并增量维护；降序只是反向映射行号
+    const QVector<int> &sorted = m_sort.ascending(static_cast<SortEngine::Key>(key));
+    Q_ASSERT(sorted.size() == m_rows.size());
+    emit layoutAboutToBeChanged();
+
+    const QModelIndexList from = persistentIndexList();
+    QVector<int> fromSlots;
+    fromSlots.reserve(from.size());
+    for (const QModelIndex &idx : from) fromSlots.append(slotAt(idx.row()));
+
+    m_rows = sorted;
+    m_reversed = descending;
+    m_rowIndexDirty = true;
+    m_sortedBy = key;
+
+    // 同步持久化索引，保证选中项、当前项跟随条目移动
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (int slot : fromSlots) to.append(index(rowOfId(slot), 0));
+    changePersistentIndexList(from, to);
+
+    emit layoutChanged();
+}
+
+void EmojiListModel::setReversed(bool reversed)
+{
+    if (m_reversed == reversed) return;
+    emit layoutAboutToBeChanged();
+    m_reversed = reversed;  // O(1)：存储不动，只改变行号映射
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex &idx : from) to.append(index(m_rows.size() - 1 - idx.row(), 0));
+    changePersistentIndexList(from, to);
+    emit layoutChanged();
+}
+
+void EmojiListModel::applyPermutation(const QVector<int> &order)
+{
+    TRACE_SCOPE(Trace::Model, "EmojiListModel::applyPermutation");
+    Q_ASSERT(order.size() == m_rows.size());
+    emit layoutAboutToBeChanged();
+
+    QVector<int> reordered(m_rows.size());
+    QVector<int> newRowOf(m_rows.size());
+    for (int i = 0; i < order.size(); ++i) {
+        reordered[i] = slotAt(order.at(i));
+        newRowOf[order.at(i)] = i;
+    }
+    m_rows.swap(reordered);
+    m_reversed = false;
+    m_rowIndexDirty = true;
+    m_sortedBy = -1;
+
+    // 同步持久化索引，保证选中项、当前项跟随条目移动
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex &idx : from) {
+        to.append(index(newRowOf.at(idx.row()), 0));
+    }
+    changePersistentIndexList(from, to);
+
+    emit layoutChanged();
+}
+
+void EmojiListModel::setShowNames(bool show)
+{
+    if (m_showNames == show) return;
+    m_showNames = show;
+    if (!m_rows.isEmpty()) {
+        emit dataChanged(index(0, 0), index(m_rows.size() - 1, 0), {ShowNameRole});
+    }
+}
+
+void EmojiListModel::setThumbnail(int row, const QPixmap &thumb)
+{
+    if (row < 0 || row >= m_rows.size()) return;
+    m_slots[slotAt(row)].thumbnail = thumb;
+    const QModelIndex idx = index(row, 0);
+    emit dataChanged(idx, idx, {Qt::DecorationRole});
+}
+
+void EmojiListModel::setThumbnailForPath(const QString &path, const QPixmap &thumb)
+{
+    for (auto it = m_slotsOfPath.constFind(path); it != m_slotsOfPath.constEnd() && it.key() == path; ++it) {
+        setThumbnail(rowOfId(it.value()), thumb);
+    }
+}
+
+void EmojiListModel::setContentHashForPath(const QString &path, quint64 hash)
+{
+    for (auto it = m_slotsOfPath.constFind(path); it != m_slotsOfPath.constEnd() && it.key() == path; ++it) {
+        m_slots[it.value()].contentHash = hash;
+    }
+}
+
+void EmojiListModel::setPerceptualHashForPath(const QString &path, quint64 hash)
+{
+    for (auto it = m_slotsOfPath.constFind(path); it != m_slotsOfPath.constEnd() && it.key() == path; ++it) {
+        EmojiItem &item = m_slots[it.value()];
+        item.perceptualHash = hash;
+        item.hasPerceptualHash = true;
+        if (m_similarBuilt) m_similar.insert(it.value(), hash);
+    }
+}
+
+QStringList EmojiListModel::pathsWithoutPerceptualHash() const
+{
+    QStringList paths;
+    for (int slot : m_rows) {
+        if (!m_slots.at(slot).hasPerceptualHash) paths.append(m_slots.at(slot).filePath);
+    }
+    return paths;
+}
+
+void EmojiListModel::ensureRowIndex() const
+{
+    if (!m_rowIndexDirty) return;
+    // 一次 O(n) 的 int 数组重建；批量删除/排序之后只在第一次查找时发生
+    m_rowOfSlot.fill(-1, m_slots.size());
+    for (int r = 0; r < m_rows.size(); ++r) m_rowOfSlot[m_rows.at(r)] = r;
+    m_rowIndexDirty = false;
+}
+
+int EmojiListModel::rowOfId(int id) const
+{
+    ensureRowIndex();
+    const int stored = (id >= 0 && id < m_rowOfSlot.size()) ? m_rowOfSlot.at(id) : -1;
+    return (stored >= 0 && m_reversed) ? m_rows.size() - 1 - stored : stored;
+}
+
+int EmojiListModel::rowOfPath(const QString &path) const
+{
+    auto it = m_slotsOfPath.constFind(path);
+    return it == m_slotsOfPath.constEnd() ? -1 : rowOfId(it.value());
+}
+
+void EmojiListModel::ensureSearchIndex() const
+{
+    if (m_searchBuilt) return;
+    m_search.clear();
+    for (int r = 0; r < m_rows.size(); ++r) {
+        const int slot = m_rows.at(r);
+        m_search.setItem(slot, m_slots.at(slot).fileName, m_slots.at(slot).filePath);
+    }
+    m_searchBuilt = true;
+}
+
+QVector<int> EmojiListModel::searchIds(const QString &folded) const
+{
+    ensureSearchIndex();
+    return m_search.search(folded);
+}
+
+bool EmojiListModel::idMatches(int id, const QString &folded) const
+{
+    ensureSearchIndex();
+    return m_search.matches(id, folded);
+}
+
+void EmojiListModel::ensureSimilarityIndex() const
+{
+    if (m_similarBuilt) return;
+    m_similar.clear();
+    for (int slot : m_rows) {
+        const EmojiItem &it = m_slots.at(slot);
+        if (it.hasPerceptualHash) m_similar.insert(slot, it.perceptualHash);
+    }
+    m_similarBuilt = true;
+}
+
+QVector<SimilarityIndex::Match> EmojiListModel::similarIds(int id, int radius) const
+{
+    if (id < 0 || id >= m_slots.size() || !m_slots.at(id).hasPerceptualHash) return {};
+    ensureSimilarityIndex();
+    return m_similar.findSimilar(m_slots.at(id).perceptualHash, radius);
+}
+
+QVector<QVector<int>> EmojiListModel::similarClusters(int radius) const
+{
+    ensureSimilarityIndex();
+    return m_similar.clusters(radius);
+}
@@ -0,0 +1,123 @@
+/*
+* 文件名：emojilistmodel.h
+* 日期：2026-10-16
+* 该文件功能大致描述：表情列表模型。以一段连续的 QVector<EmojiItem>（按槽位存放）作为唯一数据存储，向视图/委托提供
+*                    DisplayRole（显示名）、DecorationRole（缩略图）、UserRole（文件路径）、UserRole+10（是否显示文件名）。
+*                    取代原先 m_list + QStandardItemModel 的双份存储；排序以 layoutChanged 置换完成，不再重建模型。
+*                    行号 → 槽位是一个 int 数组，条目本身不随删除/排序移动；槽位号即条目在生命周期内的稳定 ID。
+*                    路径 → 槽位、槽位 → 行号都有哈希/数组索引，按路径或 ID 查找行号为 O(1)。
+*                    排序由 SortEngine 缓存的升序槽位序列完成；降序只是反向映射行号，切换升序/降序为 O(1)。
+* 该文件函数功能描述：
+*   - setItems()：整体替换数据（加载 JSON 时使用）
+*   - appendItems()：批量追加，一批只发一次 rowsInserted
+*   - removeRows()：删除连续的若干行
+*   - removeRowSet()：删除任意行集合，合并为连续区间，每个区间一次 beginRemoveRows/endRemoveRows
+*   - sortItems()：按日期/大小/名称排序；排序依据未变时只调用 setReversed()
+*   - setReversed()：切换升序/降序显示（存储不动）
+*   - applyPermutation()：按给定顺序重排行，并同步持久化索引（选中状态保持）
+*   - setShowNames()：切换是否显示文件名
+*   - mimeTypes()/mimeData()：拖出时只提供文件路径（EmojiMimeData），各格式在接收方请求时才生成，不序列化缩略图
+*   - setImageCache()：拖出的图像格式经共享的 ImageCache 解码（与复制到剪贴板同一份缓存）
+*   - setThumbnail()/hasThumbnail()：按需加载的缩略图回填；尚未加载的行 DecorationRole 返回共享的占位图
+*   - rowOfPath()/rowOfId()/idOfRow()：按文件路径或稳定 ID 查找行号
+*   - searchIds()/idMatches()：按显示名/路径的子串搜索（SearchIndex，第一次搜索时建立，之后随增删改名增量更新）
+*   - setPerceptualHashForPath()/pathsWithoutPerceptualHash()：补记感知哈希 / 列出尚无感知哈希的条目
+*   - similarIds()/similarClusters()：按感知哈希查找相似条目、聚类相似条目（SimilarityIndex，第一次使用时建立，之后增量更新）
+* 与该文件相关联的其他文件：emojilistmodel.cpp, sortengine.h, sortengine.cpp, searchindex.h, searchindex.cpp, similarityindex.h, emoji_meta.h, emojimimedata.h, mainwindow.h, mainwindow.cpp, emojilistdelegate.cpp
+*/
+
+#ifndef EMOJILISTMODEL_H
+#define EMOJILISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QMultiHash>
+#include <QStringList>
+#include <QPixmap>
+#include "emoji_meta.h"
+#include "sortengine.h"
+#include "searchindex.h"
+#include "similarityindex.h"
+
+class ImageCache;
+
+class EmojiListModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    enum Roles {
+        FilePathRole = Qt::UserRole,
+        ShowNameRole = Qt::UserRole + 10, // 委托读取：是否绘制文件名
+        ThumbnailKeyRole = Qt::UserRole + 11  // 委托读取：当前缩略图的 QPixmap::cacheKey()，命中缓存时无需取出 QPixmap
+    };
+
+    enum SortKey {
+        SortByDate = 0,  // 与工具栏“排序”下拉框的下标一致
+        SortBySize = 1,
+        SortByName = 2
+    };
+
+    explicit EmojiListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+    QStringList mimeTypes() const override;
+    QMimeData *mimeData(const QModelIndexList &indexes) const override;
+
+    const EmojiItem &item(int row) const { return m_slots.at(slotAt(row)); }
+
+    void setItems(const QVector<EmojiItem> &items);
+    void appendItems(const QVector<EmojiItem> &items);
+    int removeRowSet(QVector<int> rows);  // 返回删除的区间数
+    void sortItems(SortKey key, Qt::SortOrder order);
+    void setReversed(bool reversed);
+    void applyPermutation(const QVector<int> &order);  // order[新行] = 旧行
+    void setShowNames(bool show);
+    bool showNames() const { return m_showNames; }
+    void setImageCache(ImageCache *images) { m_images = images; }
+
+    bool hasThumbnail(int row) const { return !item(row).thumbnail.isNull(); }
+    void setThumbnail(int row, const QPixmap &thumb);
+    void setThumbnailForPath(const QString &path, const QPixmap &thumb);  // 同一路径的所有行
+    void setContentHashForPath(const QString &path, quint64 hash);         // 不影响显示，不发信号
+    void setPerceptualHashForPath(const QString &path, quint64 hash);      // 同上
+    QStringList pathsWithoutPerceptualHash() const;
+
+    int rowOfPath(const QString &path) const;
+    int idOfRow(int row) const { return slotAt(row); }
+    int rowOfId(int id) const;
+
+    QVector<int> searchIds(const QString &folded) const;  // 参数需经 SearchIndex::fold()
+    bool idMatches(int id, const QString &folded) const;
+
+    QVector<SimilarityIndex::Match> similarIds(int id, int radius = SimilarityIndex::DefaultRadius) const;  // 含自身（距离 0）
+    QVector<QVector<int>> similarClusters(int radius = SimilarityIndex::ClusterRadius) const;
+
+private:
+    int slotAt(int row) const { return m_rows.at(m_reversed ? m_rows.size() - 1 - row : row); }
+    int takeSlot(const EmojiItem &item);
+    void ensureRowIndex() const;
+    void ensureSearchIndex() const;
+    void ensureSimilarityIndex() const;
+
+    QVector<EmojiItem> m_slots;           // 唯一的数据存储；删除后的空槽位进入 m_freeSlots 复用
+    QVector<int> m_freeSlots;
+    QVector<int> m_rows;                  // 存储位置 → 槽位；m_reversed 时显示顺序为其逆序
+    bool m_reversed = false;
+    int m_sortedBy = -1;                  // 当前顺序恰为某排序依据的结果时记录该依据，否则为 -1
+    SortEngine m_sort;                    // 排序键与各排序依据的缓存置换
+    mutable SearchIndex m_search;         // 名称/路径搜索索引
+    mutable bool m_searchBuilt = false;
+    mutable SimilarityIndex m_similar;    // 感知哈希索引（只含已有感知哈希的条目）
+    mutable bool m_similarBuilt = false;
+    QMultiHash<QString, int> m_slotsOfPath;  // 文件路径 → 槽位（允许同一文件导入多次）
+    mutable QVector<int> m_rowOfSlot;     // 槽位 → 存储位置；删除/重排后标记失效，下次查找时一次性重建
+    mutable bool m_rowIndexDirty = false;
+    QPixmap m_placeholder;                // 未加载缩略图时的占位图（所有行共享一份）
+    bool m_showNames = false;
+    ImageCache *m_images = nullptr;       // 共享的原图缓存（由 MainWindow 持有，可为空）
+};
+
+#endif // EMOJILISTMODEL_H
@@ -1,5 +1,5 @@
 #include "emojilistwidget.h"
-#include <QStandardItemModel>
+#include <QAbstractItemModel>
 #include <QClipboard>
 #include <QApplication>
 #include <QMenu>
@@ -9,7 +9,14 @@
 #include <QMimeData>
 #include <QDropEvent>
 #include <QFont>
+#include <QScrollBar>
+#include <QtMath>
+#include <QImageReader>
 #include "emoji_meta.h"  // for DEBUG_LOG
+#include "framecache.h"
+#include "animationclock.h"
+#include "imagecache.h"
+#include "trace.h"
 
 EmojiListWidget::EmojiListWidget(QWidget *parent)
     : QListView(parent)
@@ -23,11 +30,137 @@ EmojiListWidget::EmojiListWidget(QWidget *parent)
     setSelectionMode(QAbstractItemView::ExtendedSelection);
     setEditTriggers(QAbstractItemView::NoEditTriggers);
     setMouseTracking(true);
+
+    m_rangeTimer.setSingleShot(true);
+    m_rangeTimer.setInterval(16);
+    connect(&m_rangeTimer, &QTimer::timeout, this, &EmojiListWidget::updateVisibleRange);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &EmojiListWidget::onScrollValueChanged);
+    m_hoverTimer.setSingleShot(true);
+    m_hoverTimer.setInterval(120);
+    connect(&m_hoverTimer, &QTimer::timeout, this, &EmojiListWidget::onHoverDwell);
+    m_scrollClock.start();
     DEBUG_LOG("EmojiListWidget initialized with IconMode, drag-drop enabled");
 }
 
+void EmojiListWidget::setModel(QAbstractItemModel *model)
+{
+    // 只断开自己建立的连接，QListView 内部与模型的连接保持不变
+    for (const QMetaObject::Connection &c : qAsConst(m_modelConnections)) disconnect(c);
+    m_modelConnections.clear();
+    QListView::setModel(model);
+    if (!model) return;
+    // 行数或顺序变化后可见内容随之改变
+    m_modelConnections
+        << connect(model, &QAbstractItemModel::rowsInserted, this, &EmojiListWidget::scheduleVisibleRangeUpdate)
+        << connect(model, &QAbstractItemModel::rowsRemoved, this, &EmojiListWidget::scheduleVisibleRangeUpdate)
+        << connect(model, &QAbstractItemModel::layoutChanged, this, &EmojiListWidget::scheduleVisibleRangeUpdate)
+        << connect(model, &QAbstractItemModel::modelReset, this, &EmojiListWidget::scheduleVisibleRangeUpdate);
+}
+
+void EmojiListWidget::setAnimation(FrameCache *frames, AnimationClock *clock)
+{
+    m_frames = frames;
+    m_clock = clock;
+    connect(m_clock, &AnimationClock::tick, this, &EmojiListWidget::onAnimationTick);
+    connect(m_frames, &FrameCache::framesReady, this, &EmojiListWidget::onFramesReady);
+}
+
+void EmojiListWidget::onFramesReady()
+{
+    // 新解码的动图要从静态缩略图换成动画帧；对应的行不一定还可见，直接重绘视口
+    viewport()->update();
+    if (m_clock) m_clock->scheduleAt(m_clock->now());
+}
+
+void EmojiListWidget::onAnimationTick()
+{
+    if (!m_frames || !model() || m_visibleFirst < 0) return;
+    const qint64 now = m_clock->now();
+    const int last = qMin(m_visibleLast, model()->rowCount() - 1);
+    qint64 next = -1;
+    for (int r = m_visibleFirst; r <= last; ++r) {
+        const QModelIndex idx = model()->index(r, 0);
+        const AnimatedFrames *anim = m_frames->cached(idx.data(Qt::UserRole).toString());
+        if (!anim) continue;  // 静态图或尚未解码
+        if (anim->nextChange(m_lastTick) <= now) viewport()->update(visualRect(idx));
+        const qint64 due = anim->nextChange(now);
+        if (next < 0 || due < next) next = due;
+    }
+    m_lastTick = now;
+    if (next >= 0) m_clock->scheduleAt(next);  // 没有可见动图时不再预约，时钟停止
+}
+
+void EmojiListWidget::updateGeometries()
+{
+    QListView::updateGeometries();
+    scheduleVisibleRangeUpdate();
+}
+
+void EmojiListWidget::onScrollValueChanged(int value)
+{
+    // 指数平滑估计滚动速度；停顿超过 200ms 视为重新开始
+    const qint64 dt = qMax<qint64>(1, m_scrollClock.restart());
+    const qreal instant = qreal(value - m_lastScrollValue) / dt;
+    m_scrollVelocity = dt > 200 ? instant : 0.7 * m_scrollVelocity + 0.3 * instant;
+    m_lastScrollValue = value;
+    scheduleVisibleRangeUpdate();
+}
+
+void EmojiListWidget::scheduleVisibleRangeUpdate()
+{
+    if (!m_rangeTimer.isActive()) m_rangeTimer.start();
+}
+
+int EmojiListWidget::firstRowEndingAfter(int y) const
+{
+    // IconMode + LeftToRight 换行布局下，行号越大 y 越大，可二分
+    int lo = 0, hi = model()->rowCount();
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (visualRect(model()->index(mid, 0)).bottom() < y) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void EmojiListWidget::updateVisibleRange()
+{
+    TRACE_SCOPE(Trace::Input, "updateVisibleRange");
+    if (!model()) return;
+    const int n = model()->rowCount();
+    if (n == 0) {
+        m_visibleFirst = m_visibleLast = -1;
+        return;
+    }
+
+    const QRect vp = viewport()->rect();
+    const int first = qMin(firstRowEndingAfter(vp.top()), n - 1);
+    int last = qMax(first, firstRowEndingAfter(vp.bottom() + 1) - 1);
+    // 最后一排可能与视口底边相交：继续向后包含顶边仍在视口内的行
+    while (last + 1 < n && visualRect(model()->index(last + 1, 0)).top() <= vp.bottom()) ++last;
+
+    // 预取窗口：沿滚动方向至少一屏，速度越快越远（预估 300ms 后的位置），最多四屏；反方向保留半屏
+    const int perScreen = last - first + 1;
+    const qreal rowsPerPixel = qreal(perScreen) / qMax(1, vp.height());
+    const int ahead = qMin(perScreen * 4, perScreen + qCeil(qAbs(m_scrollVelocity) * 300 * rowsPerPixel));
+    const int behind = perScreen / 2;
+    int prefetchFirst, prefetchLast;
+    if (m_scrollVelocity >= 0) {
+        prefetchFirst = first - behind;
+        prefetchLast = last + ahead;
+    } else {
+        prefetchFirst = first - ahead;
+        prefetchLast = last + behind;
+    }
+    m_visibleFirst = first;
+    m_visibleLast = last;
+    if (m_clock) m_clock->scheduleAt(m_clock->now());  // 可见范围变化：重新检查哪些可见行是动图
+    emit visibleRowsChanged(first, last, qMax(0, prefetchFirst), qMin(n - 1, prefetchLast));
+}
+
 void EmojiListWidget::mousePressEvent(QMouseEvent *event)
 {
+    TRACE_SCOPE(Trace::Input, "mousePressEvent");
     QModelIndex idx = indexAt(event->pos());
     if (idx.isValid() && event->button() == Qt::LeftButton) {
         DEBUG_LOG("Mouse pressed on item at row:" << idx.row());
@@ -44,6 +177,17 @@ void EmojiListWidget::mousePressEvent(QMouseEvent *event)
 // 【新增】：鼠标移动事件 - 判断是否开始拖动
 void EmojiListWidget::mouseMoveEvent(QMouseEvent *event)
 {
+    TRACE_SCOPE(Trace::Input, "mouseMoveEvent");
+    // 悬停预热：停在同一单元格上 120ms 后才在后台解码原图
+    if (m_images && !(event->buttons() & Qt::LeftButton)) {
+        const QString path = indexAt(event->pos()).data(Qt::UserRole).toString();
+        if (path != m_hoverPath) {
+            m_hoverPath = path;
+            if (path.isEmpty()) m_hoverTimer.stop();
+            else m_hoverTimer.start();
+        }
+    }
+
     // 如果鼠标移动距离超过 5 像素，则标记为拖动中
     if (m_pressedIndex.isValid() && !m_isDragging) {
         QPoint delta = event->pos() - m_pressPos;
@@ -58,6 +202,7 @@ void EmojiListWidget::mouseMoveEvent(QMouseEvent *event)
 // 【新增】：鼠标释放事件 - 判断是否为纯点击
 void EmojiListWidget::mouseReleaseEvent(QMouseEvent *event)
 {
+    TRACE_SCOPE(Trace::Input, "mouseReleaseEvent");
     // 如果记录了按下位置且未进行拖动，则发出点击信号
     if (m_pressedIndex.isValid() && !m_isDragging && event->button() == Qt::LeftButton) {
         DEBUG_LOG("Item clicked (no drag) at row:" << m_pressedIndex.row());
@@ -80,8 +225,8 @@ void EmojiListWidget::mouseDoubleClickEvent(QMouseEvent *event)
         QString path = idx.data(Qt::UserRole).toString();
         
         // 【优化】：双击前检查图片是否可加载，避免无效图片弹出错误提示后无法交互
-        QPixmap testLoad(path);
-        if (testLoad.isNull()) {
+        // 只读文件头：大图的解码由预览对话框在后台分块完成，这里不阻塞界面
+        if (!QImageReader(path).canRead()) {
             DEBUG_LOG("Double-click blocked: image cannot be loaded:" << path);
             return;  // 无法加载的图片不响应双击
         }
@@ -144,6 +289,7 @@ void EmojiListWidget::contextMenuEvent(QContextMenuEvent *event)
     QAction *previewAct = menu.addAction(tr("  预览"));
     QAction *renameAct = menu.addAction(tr("  重命名"));
     QAction *copyPathAct = menu.addAction(tr("  复制路径"));
+    QAction *similarAct = menu.addAction(tr("  查找相似"));
     
     menu.addSeparator();
     
@@ -154,6 +300,7 @@ void EmojiListWidget::contextMenuEvent(QContextMenuEvent *event)
     previewAct->setFont(menuFont);
     renameAct->setFont(menuFont);
     copyPathAct->setFont(menuFont);
+    similarAct->setFont(menuFont);
     
     // 删除项使用稍粗字体但不要太粗
     QFont delFont("Microsoft YaHei UI", 11, QFont::DemiBold);  // 使用DemiBold而不是Bold
@@ -167,11 +314,25 @@ void EmojiListWidget::contextMenuEvent(QContextMenuEvent *event)
         emit requestRename(idx);
     } else if (chosen == copyPathAct) {
         emit requestCopyPath(idx.data(Qt::UserRole).toString());
+    } else if (chosen == similarAct) {
+        emit requestFindSimilar(idx);
     } else if (chosen == delAct) {
         emit requestDeleteIndex(idx);
     }
 }
 
+void EmojiListWidget::leaveEvent(QEvent *event)
+{
+    m_hoverTimer.stop();
+    m_hoverPath.clear();
+    QListView::leaveEvent(event);
+}
+
+void EmojiListWidget::onHoverDwell()
+{
+    if (m_images && !m_hoverPath.isEmpty()) m_images->prefetch(m_hoverPath);
+}
+
 void EmojiListWidget::dragMoveEvent(QDragMoveEvent *event)
 {
     // Allow dragging inside
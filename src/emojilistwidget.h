@@ -1,13 +1,17 @@
 /*
 * 文件名：emojilistwidget.h
 * 日期：2025-10-21
-* 该文件功能大致描述：自定义列表视图，响应双击（预览）、单击（复制到剪贴板）、右键菜单（删除/重命名/复制路径/预览）以及拖放排序功能。
+* 该文件功能大致描述：自定义列表视图，响应双击（预览）、单击（复制到剪贴板）、右键菜单（删除/重命名/复制路径/预览/查找相似）以及拖放排序功能。
 * 该文件函数功能描述：
-*   - mouseDoubleClickEvent()：双击预览图片，并在双击前检测图片是否可加载，防止无效图片弹出错误提示
+*   - mouseDoubleClickEvent()：双击预览图片，并在双击前检测图片是否可加载（只读文件头，不解码），防止无效图片弹出错误提示
+*   - setImageCache()/onHoverDwell()：鼠标在单元格上停留片刻后预热该图的原图，复制/拖出的图像与预览直接命中
 *   - mousePressEvent()/mouseReleaseEvent()/mouseMoveEvent()：处理鼠标事件，区分点击与拖动操作
-*   - contextMenuEvent()：右键菜单，提供预览、重命名、复制路径、删除等功能
+*   - contextMenuEvent()：右键菜单，提供预览、重命名、复制路径、查找相似、删除等功能
 *   - dragMoveEvent()：处理拖放移动事件
-* 与该文件相关联的其他文件：emojilistwidget.cpp, emojilistdelegate.h, emojilistdelegate.cpp, mainwindow.h, mainwindow.cpp
+*   - updateVisibleRange()：计算可见行范围，并按滚动方向与速度给出预取窗口，发出 visibleRowsChanged() 供按需加载缩略图
+*   - setAnimation()/onAnimationTick()：动图缩略图。共享时钟每次 tick 只检查可见行，重绘帧已切换的单元格，
+*                                       并预约下一次最早的帧切换；没有可见的动图时不再预约
+* 与该文件相关联的其他文件：emojilistwidget.cpp, imagecache.h, framecache.h, animationclock.h, emojilistdelegate.h, emojilistdelegate.cpp, mainwindow.h, mainwindow.cpp
 */
 
 #ifndef EMOJILISTWIDGET_H
@@ -16,18 +20,30 @@
 #include <QListView>
 #include <QMouseEvent>
 #include <QMenu>
+#include <QTimer>
+#include <QElapsedTimer>
+
+class FrameCache;
+class AnimationClock;
+class ImageCache;
 
 class EmojiListWidget : public QListView {
     Q_OBJECT
 public:
     explicit EmojiListWidget(QWidget *parent = nullptr);
+    void setModel(QAbstractItemModel *model) override;
+    void setAnimation(FrameCache *frames, AnimationClock *clock);
+    void setImageCache(ImageCache *images) { m_images = images; }
 
 signals:
     void requestDeleteIndex(const QModelIndex &index);
     void requestPreview(const QString &path);
     void requestRename(const QModelIndex &index);
     void requestCopyPath(const QString &path);
+    void requestFindSimilar(const QModelIndex &index);
     void itemClickedIndex(const QModelIndex &index); // UPGRADE: 单击事件（用来复制图片到剪贴板）
+    // 可见行 [first, last]，以及包含它的预取窗口 [prefetchFirst, prefetchLast]（沿滚动方向延伸）
+    void visibleRowsChanged(int first, int last, int prefetchFirst, int prefetchLast);
 
 protected:
     void mouseDoubleClickEvent(QMouseEvent *event) override;
@@ -36,8 +52,34 @@ protected:
     void mouseReleaseEvent(QMouseEvent *event) override;  // 【新增】：判断是否为点击
     void contextMenuEvent(QContextMenuEvent *event) override;
     void dragMoveEvent(QDragMoveEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+    void updateGeometries() override;  // 布局/尺寸变化后重新计算可见范围
+
+private slots:
+    void onScrollValueChanged(int value);
+    void scheduleVisibleRangeUpdate();
+    void updateVisibleRange();
+    void onAnimationTick();
+    void onFramesReady();
+    void onHoverDwell();
 
 private:
+    int firstRowEndingAfter(int y) const;  // 二分查找：第一个底边 >= y 的行
+
+    QTimer m_rangeTimer;              // 合并同一帧内的多次范围更新
+    QElapsedTimer m_scrollClock;
+    int m_lastScrollValue = 0;
+    qreal m_scrollVelocity = 0;       // 平滑后的滚动速度（像素/毫秒，向下为正）
+    QList<QMetaObject::Connection> m_modelConnections;
+    int m_visibleFirst = -1;          // 最近一次计算的可见行范围（动画 tick 只检查这些行）
+    int m_visibleLast = -1;
+    FrameCache *m_frames = nullptr;
+    AnimationClock *m_clock = nullptr;
+    qint64 m_lastTick = 0;            // 上一次 tick 的动画时间
+    ImageCache *m_images = nullptr;   // 共享的原图缓存（由 MainWindow 持有）
+    QTimer m_hoverTimer;              // 悬停停留计时：划过的单元格不预热
+    QString m_hoverPath;
+
     QModelIndex m_pressedIndex;  // 【新增】：记录按下时的项索引
     QPoint m_pressPos;  // 【新增】：记录按下时的位置
     bool m_isDragging = false;  // 【新增】：标记是否正在拖动
@@ -0,0 +1,77 @@
+#include "emojimimedata.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+
+#include <QImageReader>
+#include <QFile>
+#include <QUrl>
+
+namespace {
+
+const char kUriList[] = "text/uri-list";
+const char kQtImage[] = "application/x-qt-image";
+
+// 文件头识别出的格式 → MIME 类型；只列出聊天软件常见能接收的格式
+QString encodedMimeType(const QByteArray &format)
+{
+    if (format == "png") return QStringLiteral("image/png");
+    if (format == "jpeg" || format == "jpg") return QStringLiteral("image/jpeg");
+    if (format == "gif") return QStringLiteral("image/gif");
+    if (format == "webp") return QStringLiteral("image/webp");
+    if (format == "bmp") return QStringLiteral("image/bmp");
+    return QString();
+}
+
+} // namespace
+
+EmojiMimeData::EmojiMimeData(const QStringList &paths, ImageCache *images)
+    : m_paths(paths),
+      m_images(images)
+{
+    // 只读文件头（几十字节），不解码
+    if (m_paths.size() == 1) m_encodedType = encodedMimeType(QImageReader::imageFormat(m_paths.first()));
+}
+
+QStringList EmojiMimeData::formats() const
+{
+    QStringList out;
+    if (m_paths.size() == 1) {
+        // 原始字节排在最前：支持的接收方直接拿到原文件（GIF 保留动画）
+        if (!m_encodedType.isEmpty()) out << m_encodedType;
+        out << QLatin1String(kQtImage);
+    }
+    out << QLatin1String(kUriList);
+    return out;
+}
+
+bool EmojiMimeData::hasFormat(const QString &mimeType) const
+{
+    return formats().contains(mimeType);
+}
+
+QVariant EmojiMimeData::retrieveData(const QString &mimeType, QVariant::Type type) const
+{
+    if (mimeType == QLatin1String(kUriList)) {
+        QList<QVariant> urls;
+        urls.reserve(m_paths.size());
+        for (const QString &p : m_paths) urls.append(QUrl::fromLocalFile(p));
+        return urls;  // QMimeData 负责按需转换为字节
+    }
+    if (m_paths.size() != 1) return QVariant();
+
+    if (!m_encodedType.isEmpty() && mimeType == m_encodedType) {
+        if (m_encoded.isEmpty()) {
+            QFile f(m_paths.first());
+            if (f.open(QIODevice::ReadOnly)) m_encoded = f.readAll();
+            DEBUG_LOG("Mime payload: read" << m_encoded.size() << "bytes as" << mimeType);
+        }
+        return m_encoded;
+    }
+    if (mimeType == QLatin1String(kQtImage)) {
+        if (m_image.isNull()) {
+            m_image = m_images ? m_images->get(m_paths.first()) : QImageReader(m_paths.first()).read();
+            DEBUG_LOG("Mime payload: decoded image for" << m_paths.first());
+        }
+        return m_image;
+    }
+    return QMimeData::retrieveData(mimeType, type);
+}
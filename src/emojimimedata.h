@@ -0,0 +1,44 @@
+/*
+* 文件名：emojimimedata.h
+* 日期：2026-10-16
+* 该文件功能大致描述：单击复制、Ctrl+C 复制、拖出到其他程序时使用的剪贴板/拖放数据。只记录文件路径，各格式在接收方
+*                    真正请求时才生成（retrieveData）：文件 URL 列表；单个文件时另有原始编码字节（如 image/gif，直接读文件，
+*                    不解码，动图与原始画质得以保留）和解码后的图像（application/x-qt-image，经共享的 ImageCache）。
+*                    多选时只提供 URL 列表，不需要预先解码 N 张图。
+* 该文件函数功能描述：
+*   - EmojiMimeData()：由文件路径构造；单个文件时读取文件头确定原始格式（不解码）
+*   - paths()：记录的文件路径
+*   - formats()/hasFormat()：声明可提供的格式
+*   - retrieveData()：按需生成某个格式的数据，结果缓存在对象中
+* 与该文件相关联的其他文件：emojimimedata.cpp, imagecache.h, emojilistmodel.cpp, mainwindow.cpp
+*/
+
+#ifndef EMOJIMIMEDATA_H
+#define EMOJIMIMEDATA_H
+
+#include <QMimeData>
+#include <QStringList>
+#include <QPointer>
+#include "imagecache.h"
+
+class EmojiMimeData : public QMimeData {
+    Q_OBJECT
+public:
+    explicit EmojiMimeData(const QStringList &paths, ImageCache *images = nullptr);
+
+    QStringList paths() const { return m_paths; }
+    QStringList formats() const override;
+    bool hasFormat(const QString &mimeType) const override;
+
+protected:
+    QVariant retrieveData(const QString &mimeType, QVariant::Type type) const override;
+
+private:
+    QStringList m_paths;
+    QString m_encodedType;            // 单个文件的原始格式（如 image/gif），无法识别时为空
+    QPointer<ImageCache> m_images;    // 解码原图时使用（可为空）
+    mutable QByteArray m_encoded;     // 已读取的原始字节
+    mutable QImage m_image;           // 已解码的图像
+};
+
+#endif // EMOJIMIMEDATA_H
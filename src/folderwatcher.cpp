@@ -0,0 +1,412 @@
+#include "folderwatcher.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+
+#include <QFileSystemWatcher>
+#include <QRunnable>
+#include <QDir>
+#include <QFileInfo>
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <functional>
+
+namespace {
+
+// 重新列出一个目录（不递归）：只读目录项与其中的 stat 信息，不打开文件
+class ScanTask : public QRunnable {
+public:
+    ScanTask(QObject *receiver, const QAtomicInt *closing, const QString &root, const QString &dir, const WalkFilter &filter)
+        : m_receiver(receiver), m_closing(closing), m_root(root), m_dir(dir), m_filter(filter) {}
+
+    void run() override
+    {
+        if (m_closing->loadAcquire()) return;
+        WalkedTree tree;
+        const QFileInfo fi(m_dir);
+        const bool ok = fi.isDir();
+        if (ok) {
+            WalkedDir &walked = tree[m_dir];
+            walked.canonical = fi.canonicalFilePath();
+            walked.files = DirectoryWalker::listDirectory(m_dir, m_filter, &walked.subdirs);
+        }
+        QMetaObject::invokeMethod(m_receiver, "onScanned", Qt::QueuedConnection, Q_ARG(QString, m_root),
+                                  Q_ARG(QString, m_dir), Q_ARG(WalkedTree, tree), Q_ARG(bool, ok));
+    }
+
+private:
+    QObject *m_receiver;
+    const QAtomicInt *m_closing;
+    QString m_root;
+    QString m_dir;
+    WalkFilter m_filter;
+};
+
+// 新出现的子目录：整棵遍历；visited 预先放入已监视目录的规范路径，指回它们的链接不会重复遍历
+class TreeTask : public QRunnable {
+public:
+    TreeTask(QObject *receiver, const QAtomicInt *closing, const QString &root, const QString &dir,
+             const WalkFilter &filter, const QSet<QString> &visited)
+        : m_receiver(receiver), m_closing(closing), m_root(root), m_dir(dir), m_filter(filter), m_visited(visited) {}
+
+    void run() override
+    {
+        if (m_closing->loadAcquire()) return;
+        WalkedTree tree;
+        DirectoryWalker::listTree(m_dir, m_filter, &m_visited, &tree);
+        QMetaObject::invokeMethod(m_receiver, "onScanned", Qt::QueuedConnection, Q_ARG(QString, m_root),
+                                  Q_ARG(QString, m_dir), Q_ARG(WalkedTree, tree), Q_ARG(bool, true));
+    }
+
+private:
+    QObject *m_receiver;
+    const QAtomicInt *m_closing;
+    QString m_root;
+    QString m_dir;
+    WalkFilter m_filter;
+    QSet<QString> m_visited;
+};
+
+// 快照写盘：QHash 隐式共享，主线程继续修改时自动分离，写线程看到的是提交时的内容
+class SaveTask : public QRunnable {
+public:
+    typedef std::function<void()> Fn;
+    explicit SaveTask(const Fn &fn) : m_fn(fn) {}
+    void run() override { m_fn(); }
+
+private:
+    Fn m_fn;
+};
+
+QString parentOf(const QString &dir)
+{
+    return dir.left(dir.lastIndexOf(QLatin1Char('/')));
+}
+
+QString childPath(const QString &dir, const QString &name)
+{
+    return dir.endsWith(QLatin1Char('/')) ? dir + name : dir + QLatin1Char('/') + name;
+}
+
+QStringList toStringList(const QJsonValue &v)
+{
+    QStringList out;
+    for (const QJsonValue &s : v.toArray()) out.append(s.toString());
+    return out;
+}
+
+} // namespace
+
+FolderWatcher::FolderWatcher(const QString &statePath, QObject *parent)
+    : QObject(parent),
+      m_statePath(statePath),
+      m_fsWatcher(new QFileSystemWatcher(this))
+{
+    qRegisterMetaType<WalkedTree>("WalkedTree");
+    m_pool.setMaxThreadCount(1);
+    m_debounce.setSingleShot(true);
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(SaveDelayMs);
+    connect(&m_debounce, &QTimer::timeout, this, &FolderWatcher::onDebounce);
+    connect(&m_saveTimer, &QTimer::timeout, this, &FolderWatcher::save);
+    connect(m_fsWatcher, &QFileSystemWatcher::directoryChanged, this, &FolderWatcher::onDirectoryChanged);
+}
+
+FolderWatcher::~FolderWatcher()
+{
+    // 排队中的扫描直接返回（快照以最后一次应用的结果为准），已排队的写盘照常完成
+    m_closing.storeRelease(1);
+    m_pool.waitForDone();
+    if (m_saveTimer.isActive()) {
+        m_saveTimer.stop();
+        save();
+        m_pool.waitForDone();
+    }
+}
+
+QString FolderWatcher::normalized(const QString &dir)
+{
+    return QDir::cleanPath(QDir(dir).absolutePath());
+}
+
+bool FolderWatcher::isWatched(const QString &dir) const
+{
+    return m_rootOf.contains(normalized(dir));
+}
+
+void FolderWatcher::addDir(Folder &folder, const QString &root, const QString &dir)
+{
+    if (!folder.dirs.contains(dir)) folder.dirs.insert(dir, DirState());
+    if (m_rootOf.contains(dir)) return;
+    m_rootOf.insert(dir, root);
+    if (QFileInfo(dir).isDir()) m_fsWatcher->addPath(dir);
+}
+
+void FolderWatcher::removeDirTree(Folder &folder, const QString &dir, QStringList *removed)
+{
+    const QString prefix = childPath(dir, QString());
+    QStringList unwatched;
+    for (auto it = folder.dirs.begin(); it != folder.dirs.end();) {
+        if (it.key() != dir && !it.key().startsWith(prefix)) {
+            ++it;
+            continue;
+        }
+        for (auto f = it.value().files.constBegin(); f != it.value().files.constEnd(); ++f) {
+            removed->append(childPath(it.key(), f.key()));
+        }
+        m_rootOf.remove(it.key());
+        m_dirty.remove(it.key());
+        unwatched.append(it.key());
+        it = folder.dirs.erase(it);
+    }
+    if (!unwatched.isEmpty()) m_fsWatcher->removePaths(unwatched);
+}
+
+void FolderWatcher::load()
+{
+    QFile f(m_statePath);
+    if (!f.open(QIODevice::ReadOnly)) return;
+    const QJsonArray folders = QJsonDocument::fromJson(f.readAll()).object().value("folders").toArray();
+    QStringList toScan;
+    for (const QJsonValue &v : folders) {
+        const QJsonObject obj = v.toObject();
+        const QString root = normalized(obj.value("path").toString());
+        if (root.isEmpty() || m_rootOf.contains(root)) continue;
+        Folder &folder = m_folders[root];
+        folder.options.recursive = obj.value("recursive").toBool(false);
+        folder.options.followSymlinks = obj.value("followSymlinks").toBool(false);
+        folder.options.includeGlobs = toStringList(obj.value("include"));
+        folder.options.excludeGlobs = toStringList(obj.value("exclude"));
+        folder.filter = WalkFilter(root, folder.options);
+
+        auto readFiles = [](const QJsonArray &files, Snapshot *snap) {
+            snap->reserve(files.size());
+            for (const QJsonValue &fv : files) {
+                const QJsonArray a = fv.toArray();  // [文件名, 修改时间, 大小]
+                Stamp s;
+                s.mtimeMs = qint64(a.at(1).toDouble());
+                s.size = qint64(a.at(2).toDouble());
+                snap->insert(a.at(0).toString(), s);
+            }
+        };
+        addDir(folder, root, root);
+        if (obj.contains("dirs")) {
+            for (const QJsonValue &dv : obj.value("dirs").toArray()) {
+                const QJsonObject dobj = dv.toObject();
+                const QString rel = dobj.value("path").toString();
+                const QString dir = rel.isEmpty() ? root : childPath(root, rel);
+                addDir(folder, root, dir);
+                DirState &st = folder.dirs[dir];
+                readFiles(dobj.value("files").toArray(), &st.files);
+                for (const QString &name : toStringList(dobj.value("subdirs"))) st.subdirs.append(childPath(dir, name));
+            }
+        } else {
+            readFiles(obj.value("files").toArray(), &folder.dirs[root].files);  // 旧格式：只有根目录
+        }
+        toScan += folder.dirs.keys();
+    }
+    for (const QString &dir : qAsConst(toScan)) scan(dir);  // 补扫：程序关闭期间的变化
+    DEBUG_LOG("Watched folders loaded:" << m_folders.size() << "roots," << m_rootOf.size() << "directories");
+}
+
+bool FolderWatcher::watch(const QString &path, const WalkOptions &options, const FoundFileList &baseline)
+{
+    const QString root = normalized(path);
+    if (m_rootOf.contains(root)) return false;
+    Folder &folder = m_folders[root];
+    folder.options = options;
+    folder.filter = WalkFilter(root, options);
+    addDir(folder, root, root);
+    for (const FoundFile &file : baseline) {
+        const int slash = file.path.lastIndexOf(QLatin1Char('/'));
+        const QString dir = file.path.left(slash);
+        addDir(folder, root, dir);
+        Stamp s;
+        s.mtimeMs = file.mtimeMs;
+        s.size = file.size;
+        folder.dirs[dir].files.insert(file.path.mid(slash + 1), s);
+    }
+    // 遍历期间发生的变化、只含子目录的目录与各目录的子目录列表，由一次补扫得到（与导入时的快照比较，不会重复报告）
+    const QStringList dirs = folder.dirs.keys();
+    for (const QString &dir : dirs) scan(dir);
+    scheduleSave();
+    DEBUG_LOG("Watching folder:" << root << (options.recursive ? "recursive," : "flat,") << dirs.size() << "directories");
+    return true;
+}
+
+void FolderWatcher::unwatch(const QString &path)
+{
+    const QString root = normalized(path);
+    auto folder = m_folders.find(root);
+    if (folder == m_folders.end()) return;
+    QStringList dirs = folder.value().dirs.keys();
+    for (const QString &dir : qAsConst(dirs)) {
+        m_rootOf.remove(dir);
+        m_dirty.remove(dir);
+    }
+    m_fsWatcher->removePaths(dirs);
+    m_folders.erase(folder);
+    scheduleSave();
+    DEBUG_LOG("Stopped watching folder:" << root);
+}
+
+void FolderWatcher::onDirectoryChanged(const QString &path)
+{
+    const QString dir = normalized(path);
+    if (!m_rootOf.contains(dir)) return;
+    m_dirty.insert(dir);
+    // 复制一批文件会产生成百上千个事件：等安静下来再扫描，但持续有事件时不无限推迟
+    if (!m_firstEvent.isValid()) m_firstEvent.start();
+    if (m_firstEvent.elapsed() >= MaxDelayMs) onDebounce();
+    else m_debounce.start(DebounceMs);
+}
+
+void FolderWatcher::onDebounce()
+{
+    m_debounce.stop();
+    m_firstEvent.invalidate();
+    const QSet<QString> dirty = m_dirty;
+    for (const QString &dir : dirty) {
+        if (m_scanning.contains(dir)) continue;  // 扫描完成后再扫一次
+        scan(dir);
+    }
+}
+
+void FolderWatcher::scan(const QString &dir)
+{
+    const QString root = m_rootOf.value(dir);
+    if (root.isEmpty()) return;
+    m_dirty.remove(dir);
+    m_scanning.insert(dir);
+    m_pool.start(new ScanTask(this, &m_closing, root, dir, m_folders.value(root).filter));
+}
+
+void FolderWatcher::walkNew(const QString &root, const QString &dir)
+{
+    if (m_scanning.contains(dir)) return;
+    const Folder &folder = m_folders[root];
+    QSet<QString> visited;
+    visited.reserve(folder.dirs.size());
+    for (const DirState &st : folder.dirs) {
+        if (!st.canonical.isEmpty()) visited.insert(st.canonical);
+    }
+    m_scanning.insert(dir);
+    m_pool.start(new TreeTask(this, &m_closing, root, dir, folder.filter, visited));
+}
+
+void FolderWatcher::onScanned(const QString &root, const QString &dir, const WalkedTree &tree, bool ok)
+{
+    m_scanning.remove(dir);
+    auto found = m_folders.find(root);
+    if (found == m_folders.end()) return;  // 扫描期间已取消监视
+    Folder &folder = found.value();
+    // 新子目录的遍历结果：期间父目录已被删除则丢弃
+    if (!folder.dirs.contains(dir) && (dir == root || !folder.dirs.contains(parentOf(dir)))) return;
+    if (!ok) {
+        // 目录暂时不可访问（如网络盘断开）：保留快照，不当作全部删除；真正删除的子目录由父目录的扫描发现
+        DEBUG_LOG("Watched folder unavailable:" << dir);
+    } else {
+        QStringList added, changed, removed, goneDirs, newDirs;
+        bool structureChanged = false;
+        for (auto w = tree.constBegin(); w != tree.constEnd(); ++w) {
+            const QString &d = w.key();
+            if (!folder.dirs.contains(d)) {
+                addDir(folder, root, d);
+                structureChanged = true;
+            }
+            DirState &st = folder.dirs[d];
+            Snapshot fresh;
+            fresh.reserve(w.value().files.size());
+            const int prefix = childPath(d, QString()).length();
+            for (const FoundFile &f : w.value().files) {
+                const QString name = f.path.mid(prefix);
+                auto it = st.files.constFind(name);
+                if (it == st.files.constEnd()) added.append(f.path);
+                else if (it->mtimeMs != f.mtimeMs || it->size != f.size) changed.append(f.path);
+                Stamp s;
+                s.mtimeMs = f.mtimeMs;
+                s.size = f.size;
+                fresh.insert(name, s);
+            }
+            for (auto it = st.files.constBegin(); it != st.files.constEnd(); ++it) {
+                if (!fresh.contains(it.key())) removed.append(childPath(d, it.key()));
+            }
+            st.files.swap(fresh);
+            // 子目录：消失的连同其下所有目录移除，新出现的整棵遍历
+            QSet<QString> present;
+            for (const QString &sub : w.value().subdirs) {
+                present.insert(sub);
+                if (!tree.contains(sub) && !folder.dirs.contains(sub)) newDirs.append(sub);
+            }
+            for (const QString &sub : qAsConst(st.subdirs)) {
+                if (!present.contains(sub)) goneDirs.append(sub);
+            }
+            if (st.subdirs != w.value().subdirs) structureChanged = true;
+            st.subdirs = w.value().subdirs;
+            st.canonical = w.value().canonical;
+        }
+        for (const QString &sub : qAsConst(goneDirs)) removeDirTree(folder, sub, &removed);
+        for (const QString &sub : qAsConst(newDirs)) walkNew(root, sub);
+        // 目录被删除后重建时 QFileSystemWatcher 会自动移除它，重新加入
+        if (dir == root && !m_fsWatcher->directories().contains(root)) m_fsWatcher->addPath(root);
+        if (!added.isEmpty() || !changed.isEmpty() || !removed.isEmpty()) {
+            DEBUG_LOG("Watched folder changed:" << dir << "added" << added.size()
+                      << "changed" << changed.size() << "removed" << removed.size());
+            scheduleSave();
+            emit changesReady(added, changed, removed);
+        } else if (structureChanged) {
+            scheduleSave();
+        }
+    }
+    if (m_dirty.contains(dir)) m_debounce.start(DebounceMs);
+}
+
+void FolderWatcher::scheduleSave()
+{
+    if (!m_saveTimer.isActive()) m_saveTimer.start();
+}
+
+void FolderWatcher::save()
+{
+    const QHash<QString, Folder> folders = m_folders;
+    const QString statePath = m_statePath;
+    m_pool.start(new SaveTask([folders, statePath]() {
+        QJsonArray arr;
+        for (auto it = folders.constBegin(); it != folders.constEnd(); ++it) {
+            const QString &root = it.key();
+            const int rootPrefix = childPath(root, QString()).length();
+            QJsonArray dirs;
+            for (auto d = it.value().dirs.constBegin(); d != it.value().dirs.constEnd(); ++d) {
+                QJsonArray files;
+                for (auto f = d.value().files.constBegin(); f != d.value().files.constEnd(); ++f) {
+                    files.append(QJsonArray{f.key(), double(f.value().mtimeMs), double(f.value().size)});
+                }
+                QJsonArray subdirs;
+                const int dirPrefix = childPath(d.key(), QString()).length();
+                for (const QString &sub : d.value().subdirs) subdirs.append(sub.mid(dirPrefix));
+                QJsonObject dobj;
+                dobj.insert("path", d.key() == root ? QString() : d.key().mid(rootPrefix));
+                dobj.insert("subdirs", subdirs);
+                dobj.insert("files", files);
+                dirs.append(dobj);
+            }
+            const WalkOptions &o = it.value().options;
+            QJsonObject obj;
+            obj.insert("path", root);
+            obj.insert("recursive", o.recursive);
+            obj.insert("followSymlinks", o.followSymlinks);
+            obj.insert("include", QJsonArray::fromStringList(o.includeGlobs));
+            obj.insert("exclude", QJsonArray::fromStringList(o.excludeGlobs));
+            obj.insert("dirs", dirs);
+            arr.append(obj);
+        }
+        QJsonObject root;
+        root.insert("version", 2);
+        root.insert("folders", arr);
+        QSaveFile out(statePath);
+        if (!out.open(QIODevice::WriteOnly)) return;
+        out.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        if (!out.commit()) DEBUG_LOG("Failed to save watched folders:" << statePath);
+    }));
+}
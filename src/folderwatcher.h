@@ -0,0 +1,96 @@
+/*
+* 文件名：folderwatcher.h
+* 日期：2026-10-16
+* 该文件功能大致描述：监视导入过的文件夹。通过"添加文件夹"导入的目录被记为监视源（连同导入时的递归与包含/排除规则），
+*                    QFileSystemWatcher 报告目录变化后先去抖（连续的事件合并为一次，最长推迟 MaxDelayMs），再在后台线程
+*                    只重新列出发生变化的那个目录，与上次记录的快照（修改时间 + 大小）比较，把新增、修改、删除的文件交给
+*                    MainWindow，由它分批应用到表情库与导入流水线。递归监视时每个子目录单独记录快照：新出现的子目录整棵遍历，
+*                    消失的子目录连同其下的文件一并报告删除。监视的目录及其快照保存在 ~/.emoji_watched.json 中，
+*                    下次启动时先补扫一次，程序关闭期间的变化同样能发现。
+* 该文件函数功能描述：
+*   - load()：读取保存的监视目录与快照，开始监视并补扫
+*   - watch()：添加监视目录；baseline 为导入时遍历得到的文件（作为初始快照，随后补扫一次遍历期间的变化）
+*   - unwatch()：移除监视目录（已导入的条目不受影响）
+*   - folders()/isWatched()：当前监视的根目录 / 某目录是否已被监视（含递归监视的子目录）
+*   - changesReady()：信号，一次扫描后的差异（新增、修改、删除），均为绝对路径
+* 与该文件相关联的其他文件：folderwatcher.cpp, directorywalker.h, directorywalker.cpp, mainwindow.h, mainwindow.cpp
+*/
+
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include "directorywalker.h"
+
+class QFileSystemWatcher;
+
+class FolderWatcher : public QObject {
+    Q_OBJECT
+public:
+    static const int DebounceMs = 500;    // 最后一个事件之后等待的时间
+    static const int MaxDelayMs = 5000;   // 事件持续不断时最长推迟
+    static const int SaveDelayMs = 2000;  // 快照写盘合并
+
+    explicit FolderWatcher(const QString &statePath, QObject *parent = nullptr);
+    ~FolderWatcher() override;
+
+    void load();
+    bool watch(const QString &dir, const WalkOptions &options, const FoundFileList &baseline);
+    void unwatch(const QString &dir);
+    QStringList folders() const { return m_folders.keys(); }
+    bool isWatched(const QString &dir) const;
+
+signals:
+    void changesReady(const QStringList &added, const QStringList &changed, const QStringList &removed);
+
+private slots:
+    void onDirectoryChanged(const QString &dir);
+    void onDebounce();
+    void onScanned(const QString &root, const QString &dir, const WalkedTree &tree, bool ok);
+    void save();
+
+private:
+    struct Stamp {
+        qint64 mtimeMs = 0;
+        qint64 size = 0;
+    };
+    typedef QHash<QString, Stamp> Snapshot;  // 文件名 → 修改时间、大小
+    struct DirState {
+        QString canonical;
+        Snapshot files;       // 该目录下直接包含的文件
+        QStringList subdirs;  // 上次列出的直接子目录（绝对路径）
+    };
+    struct Folder {
+        WalkOptions options;
+        WalkFilter filter;
+        QHash<QString, DirState> dirs;  // 目录绝对路径 → 状态（含根目录）
+    };
+
+    static QString normalized(const QString &dir);
+    void addDir(Folder &folder, const QString &root, const QString &dir);
+    void removeDirTree(Folder &folder, const QString &dir, QStringList *removed);
+    void scan(const QString &dir);
+    void walkNew(const QString &root, const QString &dir);
+    void scheduleSave();
+
+    QString m_statePath;
+    QFileSystemWatcher *m_fsWatcher;
+    QHash<QString, Folder> m_folders;   // 监视的根目录 → 目录快照
+    QHash<QString, QString> m_rootOf;   // 已监视的目录 → 所属根目录
+    QSet<QString> m_dirty;              // 有事件、等待扫描的目录
+    QSet<QString> m_scanning;           // 正在后台扫描的目录（扫描期间的新事件在完成后再扫一次）
+    QTimer m_debounce;
+    QElapsedTimer m_firstEvent;         // 本轮第一个未处理事件的时间
+    QTimer m_saveTimer;
+    QAtomicInt m_closing;               // 析构时置位：排队中的扫描不再执行
+    QThreadPool m_pool;                 // 单线程：扫描与写快照依次执行
+};
+
+#endif // FOLDERWATCHER_H
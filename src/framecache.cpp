@@ -0,0 +1,139 @@
+#include "framecache.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+
+#include <QRunnable>
+#include <QImageReader>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+
+const int kMinDelayMs = 20;       // 与浏览器一致：过小的帧间隔按 100ms 播放
+const int kDefaultDelayMs = 100;
+
+class DecodeTask : public QRunnable {
+public:
+    DecodeTask(QObject *receiver, const QString &path, const QSize &box)
+        : m_receiver(receiver), m_path(path), m_box(box) {}
+
+    void run() override
+    {
+        DecodedAnimation out;
+        out.path = m_path;
+        out.box = m_box;
+        QImageReader reader(m_path);
+        if (reader.supportsAnimation() && reader.imageCount() != 1) {
+            QSize size = reader.size();
+            const bool scaledDecode = size.isValid() && reader.supportsOption(QImageIOHandler::ScaledSize);
+            if (size.isValid()) {
+                size.scale(m_box, Qt::KeepAspectRatio);
+                if (scaledDecode) reader.setScaledSize(size);  // 每帧直接解码为单元格尺寸
+            }
+            qint64 bytes = 0;
+            while (out.frames.size() < FrameCache::MaxFrames && bytes < FrameCache::MaxBytesPerAnimation) {
+                QImage frame = reader.read();
+                if (frame.isNull()) break;
+                if (frame.size() != size && size.isValid()) {
+                    frame = frame.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                }
+                const int delay = reader.nextImageDelay();
+                out.delays.append(delay < kMinDelayMs ? kDefaultDelayMs : delay);
+                bytes += qint64(frame.bytesPerLine()) * frame.height();
+                out.frames.append(frame);
+            }
+            if (out.frames.size() < 2) {  // 实际只有一帧：按静态图处理
+                out.frames.clear();
+                out.delays.clear();
+            }
+        }
+        QMetaObject::invokeMethod(m_receiver, "onDecoded", Qt::QueuedConnection, Q_ARG(DecodedAnimation, out));
+    }
+
+private:
+    QObject *m_receiver;
+    QString m_path;
+    QSize m_box;
+};
+
+} // namespace
+
+int AnimatedFrames::frameAt(qint64 t) const
+{
+    const int ms = int(t % ends.last());
+    return int(std::upper_bound(ends.constBegin(), ends.constEnd(), ms) - ends.constBegin());
+}
+
+qint64 AnimatedFrames::nextChange(qint64 t) const
+{
+    return t - t % ends.last() + ends.at(frameAt(t));
+}
+
+FrameCache::FrameCache(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<DecodedAnimation>("DecodedAnimation");
+    setBudget(DefaultBudgetBytes);
+    // 动图解码只占用少量线程，不与缩略图加载争抢
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 4));
+}
+
+FrameCache::~FrameCache()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+bool FrameCache::mayBeAnimated(const QString &path)
+{
+    return path.endsWith(QLatin1String(".gif"), Qt::CaseInsensitive)
+        || path.endsWith(QLatin1String(".webp"), Qt::CaseInsensitive);
+}
+
+const AnimatedFrames *FrameCache::frames(const QString &path, const QSize &box, qreal dpr)
+{
+    if (box != m_box || !qFuzzyCompare(dpr, m_dpr)) {
+        m_cache.clear();  // 单元格尺寸或像素比变化：已解码的帧全部失效
+        m_box = box;
+        m_dpr = dpr;
+    }
+    if (const AnimatedFrames *hit = m_cache.object(path)) return hit;
+    if (m_static.contains(path) || m_pending.contains(path)) return nullptr;
+    m_pending.insert(path);
+    m_pool.start(new DecodeTask(this, path, box * dpr));
+    return nullptr;
+}
+
+void FrameCache::clear()
+{
+    m_pool.clear();
+    m_cache.clear();
+    m_static.clear();
+    m_pending.clear();
+}
+
+void FrameCache::onDecoded(const DecodedAnimation &result)
+{
+    if (!m_pending.remove(result.path)) return;  // clear() 之后才完成的任务
+    if (result.frames.isEmpty()) {
+        m_static.insert(result.path);
+        return;
+    }
+    if (result.box != m_box * m_dpr) return;  // 解码期间尺寸已变化，下次绘制时重新提交
+
+    AnimatedFrames *anim = new AnimatedFrames;
+    anim->frames.reserve(result.frames.size());
+    anim->ends.reserve(result.frames.size());
+    qint64 bytes = 0;
+    int end = 0;
+    for (int i = 0; i < result.frames.size(); ++i) {
+        QPixmap pm = QPixmap::fromImage(result.frames.at(i));
+        pm.setDevicePixelRatio(m_dpr);
+        bytes += qint64(pm.width()) * pm.height() * 4;
+        anim->frames.append(pm);
+        end += result.delays.at(i);
+        anim->ends.append(end);
+    }
+    m_cache.insert(result.path, anim, int(qMax<qint64>(1, bytes / 1024)));
+    DEBUG_LOG("Animated thumbnail decoded:" << result.path << result.frames.size() << "frames," << bytes / 1024 << "KB");
+    emit framesReady(result.path);
+}
@@ -0,0 +1,75 @@
+/*
+* 文件名：framecache.h
+* 日期：2026-10-16
+* 该文件功能大致描述：动图缩略图的全局帧缓存。GIF/WebP 单元格第一次可见时在后台解码全部帧，解码时直接缩小到单元格像素尺寸
+*                    （QImageReader::setScaledSize，不支持时逐帧缩放），按总字节数上限做 LRU 淘汰；只有一帧的文件记为静态图，不再解码。
+*                    某一时刻显示哪一帧由 AnimationClock 的时间决定，同一文件在所有单元格中同步播放。
+* 该文件函数功能描述：
+*   - AnimatedFrames::frameAt()/nextChange()：动画时间 → 帧下标 / 下一次切换帧的时刻
+*   - mayBeAnimated()：按扩展名判断是否可能是动图（gif/webp），不读文件
+*   - frames()：查找帧序列；未命中时提交后台解码并返回 nullptr（委托先画静态缩略图），已知为静态图也返回 nullptr
+*   - cached()：只查缓存，不提交解码（时钟 tick 时使用）
+*   - framesReady()：信号，某个文件的帧已解码完毕
+* 与该文件相关联的其他文件：framecache.cpp, animationclock.h, emojilistdelegate.cpp, emojilistwidget.cpp, mainwindow.cpp
+*/
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <QObject>
+#include <QImage>
+#include <QPixmap>
+#include <QVector>
+#include <QCache>
+#include <QSet>
+#include <QThreadPool>
+
+struct AnimatedFrames {
+    QVector<QPixmap> frames;
+    QVector<int> ends;  // 各帧结束时刻（毫秒，自一轮开始累计）；ends.last() 为一轮时长
+
+    int frameAt(qint64 t) const;
+    qint64 nextChange(qint64 t) const;
+};
+
+struct DecodedAnimation {  // 工作线程的解码结果（QImage，主线程再转为 QPixmap）
+    QString path;
+    QSize box;
+    QVector<QImage> frames;  // 为空表示静态图或无法解码
+    QVector<int> delays;
+};
+Q_DECLARE_METATYPE(DecodedAnimation)
+
+class FrameCache : public QObject {
+    Q_OBJECT
+public:
+    static const qint64 DefaultBudgetBytes = 96LL * 1024 * 1024;
+    static const int MaxFrames = 300;                          // 单个动图最多保留的帧数
+    static const qint64 MaxBytesPerAnimation = 16LL * 1024 * 1024;
+
+    explicit FrameCache(QObject *parent = nullptr);
+    ~FrameCache() override;
+
+    static bool mayBeAnimated(const QString &path);
+    void setBudget(qint64 bytes) { m_cache.setMaxCost(int(qMax<qint64>(1, bytes / 1024))); }
+
+    const AnimatedFrames *frames(const QString &path, const QSize &box, qreal dpr);
+    const AnimatedFrames *cached(const QString &path) const { return m_cache.object(path); }
+    void clear();
+
+signals:
+    void framesReady(const QString &path);
+
+private slots:
+    void onDecoded(const DecodedAnimation &result);
+
+private:
+    QThreadPool m_pool;
+    QCache<QString, AnimatedFrames> m_cache;  // 开销单位 KB
+    QSet<QString> m_static;                   // 已知只有一帧（或无法解码）的文件
+    QSet<QString> m_pending;
+    QSize m_box;                              // 帧的像素尺寸与像素比；变化时全部失效
+    qreal m_dpr = 0;
+};
+
+#endif // FRAMECACHE_H
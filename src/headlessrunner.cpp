@@ -0,0 +1,358 @@
+#include "headlessrunner.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+#include "librarystore.h"
+#include "sqlitecatalog.h"
+#include "thumbnailcache.h"
+#include "thumbnailer.h"
+#include "contenthash.h"
+#include "trace.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QRunnable>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QHash>
+#include <QTimer>
+#include <QThread>
+#include <QTextStream>
+
+namespace {
+
+// 校验一块已有条目：文件是否还在；在的话确保缩略图缓存中有它（命中只需 stat，未命中时解码并写入缓存）
+class WarmTask : public QRunnable {
+public:
+    WarmTask(HeadlessRunner *runner, ThumbnailCache *cache, const QStringList &paths)
+        : m_runner(runner), m_cache(cache), m_paths(paths) {}
+
+    void run() override
+    {
+        int hits = 0, generated = 0, failed = 0;
+        QStringList missing;
+        for (const QString &p : qAsConst(m_paths)) {
+            const QFileInfo fi(p);
+            if (!fi.exists()) {
+                missing.append(p);
+                continue;
+            }
+            if (!m_cache) continue;
+            if (!m_cache->lookup(fi).isNull()) {
+                ++hits;
+            } else if (ImportPipeline::makeThumbnail(fi, m_cache).isNull()) {
+                ++failed;
+            } else {
+                ++generated;
+            }
+        }
+        // runner 析构时会等待线程池，因此这里的指针在任务运行期间一直有效
+        QMetaObject::invokeMethod(m_runner, "onWarmChunk", Qt::QueuedConnection,
+                                  Q_ARG(int, hits), Q_ARG(int, generated), Q_ARG(int, failed),
+                                  Q_ARG(QStringList, missing));
+    }
+
+private:
+    HeadlessRunner *m_runner;
+    ThumbnailCache *m_cache;  // 为空表示只校验
+    QStringList m_paths;
+};
+
+// 与 MainWindow::toRecord 相同，只是直接从导入结果构造
+LibraryRecord toRecord(const ImportedEmoji &imported)
+{
+    LibraryRecord rec;
+    rec.path = imported.filePath;
+    rec.name = imported.fileName;
+    rec.time = imported.createTime;
+    rec.size = imported.fileSize;
+    rec.hash = imported.contentHash;
+    rec.phash = imported.perceptualHash;
+    rec.hasPhash = imported.hasPerceptualHash;
+    return rec;
+}
+
+QStringList splitGlobs(const QString &text)
+{
+    QStringList globs;
+    for (const QString &g : text.split(';')) {
+        if (!g.trimmed().isEmpty()) globs.append(g.trimmed());  // 空段在这里跳过（不用已弃用的 QString::SkipEmptyParts）
+    }
+    return globs;
+}
+
+} // namespace
+
+HeadlessRunner::HeadlessRunner(QObject *parent)
+    : QObject(parent),
+      m_thumbCache(new ThumbnailCache),
+      m_contentIndex(new ContentIndex),
+      m_importer(new ImportPipeline(this)),
+      m_walker(new DirectoryWalker(this))
+{
+    m_warmPool.setMaxThreadCount(QThread::idealThreadCount());
+    m_importer->setContentIndex(m_contentIndex);
+    connect(m_walker, &DirectoryWalker::filesFound, this, &HeadlessRunner::onWalkFilesFound);
+    connect(m_walker, &DirectoryWalker::finished, this, &HeadlessRunner::onWalkFinished);
+    connect(m_importer, &ImportPipeline::batchReady, this, &HeadlessRunner::onImportBatch);
+    connect(m_importer, &ImportPipeline::finished, this, &HeadlessRunner::onImportFinished);
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+    m_warmPool.clear();
+    m_warmPool.waitForDone();
+    delete m_store;  // 等待写线程把剩余的修改写完
+}
+
+bool HeadlessRunner::isRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--headless") == 0) return true;
+    }
+    return false;
+}
+
+int HeadlessRunner::run(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("EmojiManager headless mode: import files and folders, pre-generate thumbnails, "
+                                     "verify the library. Defaults are the locations the GUI uses.");
+    parser.addHelpOption();
+    QCommandLineOption headlessOpt("headless", "Run without a window.");
+    QCommandLineOption libraryOpt("library", "Library file: emoji_data.json (snapshot + journal) or a .db catalog.", "file");
+    QCommandLineOption thumbsOpt("thumbs", "Thumbnail cache directory.", "dir", QDir::home().filePath(".emoji_thumbs"));
+    QCommandLineOption noThumbsOpt("no-thumbnails", "Only verify existing entries; do not pre-generate their thumbnails.");
+    QCommandLineOption pruneOpt("prune", "Remove entries whose file no longer exists.");
+    QCommandLineOption flatOpt("no-recursive", "Do not descend into subfolders.");
+    QCommandLineOption followOpt("follow-symlinks", "Follow symbolic links and junctions while walking folders.");
+    QCommandLineOption includeOpt("include", "File name globs to import, separated by ';'.", "globs",
+                                  WalkFilter::defaultIncludeGlobs().join(';'));
+    QCommandLineOption excludeOpt("exclude", "File or folder globs to skip, separated by ';'.", "globs");
+    parser.addOptions({headlessOpt, libraryOpt, thumbsOpt, noThumbsOpt, pruneOpt, flatOpt, followOpt, includeOpt, excludeOpt});
+    parser.addPositionalArgument("paths", "Files and folders to import.", "[paths...]");
+    parser.process(app);
+
+    for (const QString &p : parser.positionalArguments()) {
+        const QFileInfo fi(p);
+        if (!fi.exists()) {
+            QTextStream(stderr) << "not found: " << p << "\n";
+            return 2;
+        }
+        m_inputs.append(fi.absoluteFilePath());
+    }
+    m_walkOptions.recursive = !parser.isSet(flatOpt);
+    m_walkOptions.followSymlinks = parser.isSet(followOpt);
+    m_walkOptions.includeGlobs = splitGlobs(parser.value(includeOpt));
+    m_walkOptions.excludeGlobs = splitGlobs(parser.value(excludeOpt));
+    m_thumbnails = !parser.isSet(noThumbsOpt);
+    m_prune = parser.isSet(pruneOpt);
+
+    // 导入总会生成缩略图（与界面相同），因此缓存无论是否预热已有条目都要打开
+    if (!m_thumbCache->open(parser.value(thumbsOpt))) {
+        QTextStream(stderr) << "cannot open thumbnail cache: " << parser.value(thumbsOpt) << "\n";
+        return 1;
+    }
+    m_importer->setThumbnailCache(m_thumbCache);
+    m_store = openLibrary(parser.value(libraryOpt));
+    if (!m_store) return 1;
+    connect(m_store, &LibraryBackend::writeFailed, this, [this](const QString &path) {
+        fail(QString("cannot write %1").arg(path));
+    });
+
+    QTimer::singleShot(0, this, &HeadlessRunner::start);
+    app.exec();
+    return m_exitCode;
+}
+
+LibraryBackend *HeadlessRunner::openLibrary(const QString &path)
+{
+    const QString jsonFile = QDir::home().filePath("emoji_data.json");
+    if (path.isEmpty()) {
+        // 与 MainWindow::openLibrary 的选择相同：界面随后打开的正是这里写入的存储
+        if (qgetenv("EMOJI_STORAGE") != "json" && SqliteCatalog::isAvailable()) {
+            SqliteCatalog *catalog = new SqliteCatalog(QDir::home().filePath("emoji_catalog.db"), jsonFile);
+            if (catalog->open()) return catalog;
+            delete catalog;
+        }
+        return new LibraryStore(jsonFile);
+    }
+    if (path.endsWith(".db", Qt::CaseInsensitive)) {
+        // 指定的目录首次打开时，从同一目录下的 emoji_data.json 导入（与默认位置的规则一致）
+        SqliteCatalog *catalog = new SqliteCatalog(path, QFileInfo(path).dir().filePath("emoji_data.json"));
+        if (catalog->open()) return catalog;
+        delete catalog;
+        QTextStream(stderr) << "cannot open catalog: " << path << "\n";
+        return nullptr;
+    }
+    return new LibraryStore(path);
+}
+
+void HeadlessRunner::start()
+{
+    m_clock.start();
+    TRACE_SCOPE(Trace::Library, "HeadlessRunner::start");
+    m_records = m_store->load();
+    m_loaded = m_records.size();
+    for (const LibraryRecord &rec : qAsConst(m_records)) {
+        m_contentIndex->add(rec.path, rec.size, rec.hash);
+    }
+    QTextStream(stdout) << "library: " << m_loaded << " entries (" << m_clock.elapsed() << " ms)\n";
+
+    // 先校验已有条目：移除的文件不再参与去重，同一图片换了位置重新导入时不会被当作重复跳过
+    QStringList paths;
+    paths.reserve(m_records.size());
+    for (const LibraryRecord &rec : qAsConst(m_records)) paths.append(rec.path);
+    ThumbnailCache *cache = m_thumbnails ? m_thumbCache.data() : nullptr;
+    for (int i = 0; i < paths.size(); i += WarmChunkSize) {
+        m_warmPool.start(new WarmTask(this, cache, paths.mid(i, WarmChunkSize)));
+        ++m_warmPending;
+    }
+    if (m_warmPending == 0) startImport();
+}
+
+void HeadlessRunner::onWarmChunk(int hits, int generated, int failed, const QStringList &missing)
+{
+    m_warmHits += hits;
+    m_warmGenerated += generated;
+    m_warmFailed += failed;
+    m_missing += missing;
+    if (--m_warmPending > 0) return;
+
+    m_warmMs = m_clock.elapsed();
+    QTextStream out(stdout);
+    out << "verified: " << m_loaded << " entries, " << m_missing.size() << " missing";
+    if (m_thumbnails) {
+        out << "; thumbnails: " << m_warmHits << " cached, " << m_warmGenerated << " generated, "
+            << m_warmFailed << " undecodable";
+    }
+    out << " (" << m_warmMs << " ms, " << m_warmPool.maxThreadCount() << " threads)\n";
+
+    if (m_prune && !m_missing.isEmpty()) {
+        QSet<QString> gone;
+        gone.reserve(m_missing.size());
+        for (const QString &p : qAsConst(m_missing)) gone.insert(p);
+        QVector<LibraryRecord> kept;
+        kept.reserve(m_records.size() - gone.size());
+        for (const LibraryRecord &rec : qAsConst(m_records)) {
+            if (gone.contains(rec.path)) m_contentIndex->remove(rec.path, rec.size, rec.hash);
+            else kept.append(rec);
+        }
+        m_records.swap(kept);
+        m_store->recordRemove(m_missing);
+        m_changed = true;
+    }
+    startImport();
+}
+
+void HeadlessRunner::startImport()
+{
+    m_importStartMs = m_clock.elapsed();
+    QStringList files;
+    for (const QString &p : qAsConst(m_inputs)) {
+        if (QFileInfo(p).isDir()) m_folders.append(p);
+        else files.append(p);
+    }
+    // 单独列出的文件与界面的“添加文件”一样，不按通配符过滤
+    m_importer->enqueue(files);
+    startNextFolder();
+    maybeFinishImport();
+}
+
+void HeadlessRunner::startNextFolder()
+{
+    if (m_folders.isEmpty() || m_walker->isRunning()) return;
+    const QString dir = m_folders.takeFirst();
+    DEBUG_LOG("Headless: walking" << dir);
+    m_walker->start(dir, m_walkOptions);
+}
+
+void HeadlessRunner::onWalkFilesFound(const FoundFileList &files)
+{
+    QStringList paths;
+    paths.reserve(files.size());
+    for (const FoundFile &f : files) paths.append(f.path);
+    m_importer->enqueue(paths);
+}
+
+void HeadlessRunner::onWalkFinished(int files, int dirs, bool cancelled)
+{
+    DEBUG_LOG("Headless: walk finished," << files << "files in" << dirs << "folders, cancelled:" << cancelled);
+    startNextFolder();
+    maybeFinishImport();
+}
+
+void HeadlessRunner::onImportBatch(const QList<ImportedEmoji> &batch)
+{
+    for (const ImportedEmoji &imported : batch) {
+        if (!imported.duplicateOf.isEmpty()) {
+            ++m_duplicates;
+            continue;
+        }
+        if (imported.thumbnailSkipped) {
+            // 疑似重复而未解码，最终不是重复：界面中会按需加载，这里直接补上，保证打开时命中缓存
+            ImportPipeline::makeThumbnail(QFileInfo(imported.filePath), m_thumbCache.data());
+        } else if (imported.thumbnail.isNull()) {
+            ++m_importFailed;
+        }
+        const LibraryRecord rec = toRecord(imported);
+        m_store->recordAdd(rec);
+        m_records.append(rec);
+        ++m_imported;
+        m_changed = true;
+    }
+}
+
+void HeadlessRunner::onImportFinished(bool cancelled)
+{
+    Q_UNUSED(cancelled);
+    maybeFinishImport();
+}
+
+void HeadlessRunner::maybeFinishImport()
+{
+    // 遍历与导入交替进行：导入队列暂时排空不代表结束，要等所有文件夹遍历完、最后一批插入完
+    if (m_finished || !m_folders.isEmpty() || m_walker->isRunning() || m_importer->isRunning()) return;
+    m_finished = true;
+    finish();
+}
+
+void HeadlessRunner::finish()
+{
+    TRACE_SCOPE(Trace::Library, "HeadlessRunner::finish");
+    QTextStream out(stdout);
+    if (!m_inputs.isEmpty()) {
+        out << "imported: " << m_imported << " new, " << m_duplicates << " duplicates skipped, "
+            << m_importFailed << " undecodable (" << m_clock.elapsed() - m_importStartMs << " ms)\n";
+    }
+
+    // 导入过程中为旧条目补算的内容哈希：与 MainWindow::onImportFinished 相同，写回表情库
+    const QVector<QPair<QString, quint64>> learned = m_contentIndex->takeLearned();
+    QHash<QString, quint64> learnedByPath;
+    for (const auto &ph : learned) {
+        m_store->recordHash(ph.first, ph.second);
+        learnedByPath.insert(ph.first, ph.second);
+        m_changed = true;
+    }
+    // JSON 库写一份压缩快照，界面打开时不必重放整段日志；索引目录的修改已逐条写入
+    if (m_changed && !m_store->isIndexed()) {
+        if (!learnedByPath.isEmpty()) {
+            for (LibraryRecord &rec : m_records) rec.hash = learnedByPath.value(rec.path, rec.hash);
+        }
+        m_store->writeSnapshot(m_records);
+    }
+    m_store->flush();
+    m_thumbCache->flush();
+
+    out << "library: " << m_records.size() << " entries";
+    if (!m_prune && !m_missing.isEmpty()) out << " (" << m_missing.size() << " missing, use --prune to remove)";
+    else if (m_prune) out << " (" << m_missing.size() << " pruned)";
+    out << "; total " << m_clock.elapsed() << " ms\n";
+    DEBUG_LOG("Thumbnail decode stats:\n" << qPrintable(Thumbnailer::statsReport()));
+    QCoreApplication::exit(m_exitCode);
+}
+
+void HeadlessRunner::fail(const QString &message)
+{
+    QTextStream(stderr) << message << "\n";
+    m_exitCode = 1;
+}
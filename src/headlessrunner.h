@@ -0,0 +1,96 @@
+/*
+* 文件名：headlessrunner.h
+* 日期：2026-10-16
+* 该文件功能大致描述：无界面的命令行模式（EmojiManager --headless ...），只用 QCoreApplication，不创建窗口。
+*                    用于在构建机或脚本中预先准备表情库：校验已有条目（文件是否还在，可选移除）、在所有核心上并行预生成缩略图、
+*                    导入文件与文件夹，最后输出统计。存储（LibraryStore / SqliteCatalog）、导入流水线、目录遍历、缩略图缓存
+*                    与按内容去重都与 MainWindow 使用同一套实现和同样的默认位置，准备好的表情库在界面中打开时直接命中缓存。
+*                    界面运行时不要同时对同一个表情库使用该模式（两边的写入互不知晓）。
+* 该文件函数功能描述：
+*   - HeadlessRunner::isRequested()：命令行中是否有 --headless（在创建 QApplication 之前判断）
+*   - HeadlessRunner::run()：解析参数并执行，事件循环结束后返回退出码
+*   - start()：读取表情库 → 校验与预热（warm）→ 导入（import）→ 写回与统计（finish），各阶段依次进行
+*   - onWarmChunk()：后台任务回传一块已有条目的校验与缩略图结果
+*   - onWalkFilesFound()/onWalkFinished()/onImportBatch()/onImportFinished()：与 MainWindow 相同的文件夹遍历 + 导入流水线
+* 与该文件相关联的其他文件：headlessrunner.cpp, main.cpp, importpipeline.h, directorywalker.h, librarystore.h, sqlitecatalog.h, thumbnailcache.h, contenthash.h
+*/
+
+#ifndef HEADLESSRUNNER_H
+#define HEADLESSRUNNER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+#include "librarybackend.h"
+#include "directorywalker.h"
+#include "importpipeline.h"
+
+class ThumbnailCache;
+class ContentIndex;
+class QCoreApplication;
+
+class HeadlessRunner : public QObject {
+    Q_OBJECT
+public:
+    static const int WarmChunkSize = 64;  // 每个预热任务处理的条目数
+
+    explicit HeadlessRunner(QObject *parent = nullptr);
+    ~HeadlessRunner() override;
+
+    static bool isRequested(int argc, char *argv[]);
+    int run(QCoreApplication &app);
+
+private slots:
+    void start();
+    void onWarmChunk(int hits, int generated, int failed, const QStringList &missing);
+    void onWalkFilesFound(const FoundFileList &files);
+    void onWalkFinished(int files, int dirs, bool cancelled);
+    void onImportBatch(const QList<ImportedEmoji> &batch);
+    void onImportFinished(bool cancelled);
+
+private:
+    LibraryBackend *openLibrary(const QString &path);
+    void startImport();
+    void startNextFolder();
+    void maybeFinishImport();
+    void finish();
+    void fail(const QString &message);
+
+    // 命令行参数
+    QStringList m_inputs;         // 要导入的文件与文件夹
+    WalkOptions m_walkOptions;
+    bool m_thumbnails = true;     // 为已有条目预生成缩略图
+    bool m_prune = false;         // 从表情库中移除已不存在的文件
+
+    LibraryBackend *m_store = nullptr;
+    QSharedPointer<ThumbnailCache> m_thumbCache;
+    QSharedPointer<ContentIndex> m_contentIndex;
+    ImportPipeline *m_importer;
+    DirectoryWalker *m_walker;
+    QThreadPool m_warmPool;       // 预热任务：线程数 = 核心数
+
+    QVector<LibraryRecord> m_records;  // 当前表情库（按持久化顺序），结束时据此写快照
+    QStringList m_folders;             // 尚未遍历的文件夹（逐个遍历，避免两次遍历互相取消）
+    int m_warmPending = 0;
+    int m_exitCode = 0;
+    bool m_changed = false;
+    bool m_finished = false;
+    QElapsedTimer m_clock;
+
+    // 统计
+    int m_loaded = 0;
+    int m_warmHits = 0;
+    int m_warmGenerated = 0;
+    int m_warmFailed = 0;
+    QStringList m_missing;
+    int m_imported = 0;
+    int m_importFailed = 0;       // 无法解码（界面中显示占位图）
+    int m_duplicates = 0;
+    qint64 m_warmMs = 0;
+    qint64 m_importStartMs = 0;
+};
+
+#endif // HEADLESSRUNNER_H
@@ -0,0 +1,140 @@
+#include "imagecache.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+
+#include <QRunnable>
+#include <QImageReader>
+#include <QFileInfo>
+#include <QDateTime>
+
+namespace {
+
+class PrefetchTask : public QRunnable {
+public:
+    PrefetchTask(QObject *receiver, const QAtomicInt *latest, int generation,
+                 const QString &path, qint64 mtimeMs, qint64 size)
+        : m_receiver(receiver), m_latest(latest), m_generation(generation),
+          m_path(path), m_mtimeMs(mtimeMs), m_size(size) {}
+
+    void run() override
+    {
+        // 鼠标已移到别的单元格：不再解码，只回报以清除排队标记
+        QImage image;
+        const bool decoded = m_latest->loadAcquire() == m_generation;
+        if (decoded) image = QImageReader(m_path).read();
+        // cache 析构时会等待线程池，因此这里的指针在任务运行期间一直有效
+        QMetaObject::invokeMethod(m_receiver, "onDecoded", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_path), Q_ARG(qint64, m_mtimeMs),
+                                  Q_ARG(qint64, m_size), Q_ARG(QImage, image), Q_ARG(bool, decoded));
+    }
+
+private:
+    QObject *m_receiver;
+    const QAtomicInt *m_latest;
+    int m_generation;
+    QString m_path;
+    qint64 m_mtimeMs;
+    qint64 m_size;
+};
+
+} // namespace
+
+ImageCache::ImageCache(QObject *parent)
+    : QObject(parent)
+{
+    setBudget(DefaultBudgetBytes);
+    m_pool.setMaxThreadCount(1);  // 预热只针对鼠标下的那一张图
+}
+
+ImageCache::~ImageCache()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+const ImageCache::Entry *ImageCache::lookup(const QString &path, qint64 mtimeMs, qint64 size) const
+{
+    const Entry *e = m_cache.object(path);
+    return (e && e->mtimeMs == mtimeMs && e->size == size) ? e : nullptr;
+}
+
+void ImageCache::store(const QString &path, qint64 mtimeMs, qint64 size, const QImage &image,
+                       const QImage &overview, bool failed)
+{
+    Entry *e = new Entry;
+    e->image = image;
+    e->overview = overview;
+    e->failed = failed;
+    e->mtimeMs = mtimeMs;
+    e->size = size;
+    // 小图的总览图就是原图本身（隐式共享），只计一次
+    qint64 bytes = image.sizeInBytes();
+    if (overview.cacheKey() != image.cacheKey()) bytes += overview.sizeInBytes();
+    // 超过整个上限的图不会被缓存（QCache 直接丢弃），调用方仍拿到本次解码的结果
+    m_cache.insert(path, e, int(qMax<qint64>(1, bytes / 1024)));
+}
+
+QImage ImageCache::get(const QString &path)
+{
+    const QFileInfo fi(path);  // 只 stat，用来判断文件是否被替换
+    const qint64 mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+    const Entry *e = lookup(path, mtimeMs, fi.size());
+    if (e && e->hasOriginal()) {
+        ++m_hits;
+        return e->image;
+    }
+    ++m_misses;
+    const QImage image = QImageReader(path).read();
+    store(path, mtimeMs, fi.size(), image, e ? e->overview : QImage(), image.isNull());
+    DEBUG_LOG("Image cache miss:" << path << "hits:" << m_hits << "misses:" << m_misses);
+    return image;
+}
+
+bool ImageCache::find(const QString &path, QImage *image, QImage *overview)
+{
+    const QFileInfo fi(path);
+    const Entry *e = lookup(path, fi.lastModified().toMSecsSinceEpoch(), fi.size());
+    if (!e || e->failed) return false;
+    if (image) *image = e->image;
+    if (overview) *overview = e->overview;
+    return true;
+}
+
+void ImageCache::insert(const QString &path, const QImage &image, const QImage &overview)
+{
+    if (image.isNull() && overview.isNull()) return;
+    const QFileInfo fi(path);
+    const qint64 mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+    const Entry *e = lookup(path, mtimeMs, fi.size());
+    // 只补上缺少的部分：例如悬停时已解码了原图，预览再放入总览图
+    const QImage mergedImage = image.isNull() && e ? e->image : image;
+    const QImage mergedOverview = overview.isNull() && e ? e->overview : overview;
+    store(path, mtimeMs, fi.size(), mergedImage, mergedOverview, false);
+}
+
+void ImageCache::prefetch(const QString &path)
+{
+    if (path.isEmpty() || (path == m_latestPath && m_pending.contains(path))) return;
+    const QFileInfo fi(path);
+    const qint64 mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+    const Entry *e = lookup(path, mtimeMs, fi.size());
+    if (e && e->hasOriginal()) return;
+    const int generation = m_latest.fetchAndAddOrdered(1) + 1;  // 之前排队的预热已经过时
+    m_pending.insert(path);
+    m_latestPath = path;
+    m_pool.start(new PrefetchTask(this, &m_latest, generation, path, mtimeMs, fi.size()));
+}
+
+void ImageCache::clear()
+{
+    m_latest.fetchAndAddOrdered(1);
+    m_cache.clear();
+}
+
+void ImageCache::onDecoded(const QString &path, qint64 mtimeMs, qint64 size, const QImage &image, bool decoded)
+{
+    m_pending.remove(path);
+    if (!decoded) return;
+    const Entry *e = lookup(path, mtimeMs, size);
+    if (e && e->hasOriginal()) return;  // 预热期间已被 get() 同步解码
+    store(path, mtimeMs, size, image, e ? e->overview : QImage(), image.isNull());
+}
@@ -0,0 +1,73 @@
+/*
+* 文件名：imagecache.h
+* 日期：2026-10-16
+* 该文件功能大致描述：进程内共享的原图解码缓存。单击/Ctrl+C 复制与拖出（EmojiMimeData）在接收方请求图像时从这里取原图，
+*                    预览（TiledImageView）把后台解码的原图与总览图也放在这里，同一张图只解码一次；按总字节数上限做 LRU 淘汰，
+*                    常用的表情一直留在缓存中。鼠标在单元格上停留时在后台预先解码，粘贴或打开预览时通常已命中。条目记录文件修改时间与大小，文件被替换后自动重新解码；
+*                    无法解码的文件也会记录（开销很小），不再反复尝试。条目以 QImage 保存，可以直接交给工作线程使用。
+*                    其他模块在别处解码出的原图（及缩小的总览图）可以按实际字节数放进来，共用同一个内存上限。
+* 该文件函数功能描述：
+*   - get()：取原图；未命中时在调用线程（主线程）同步解码并放入缓存，失败返回空图
+*   - find()：只查缓存，不解码；可同时取出总览图
+*   - insert()：放入别处解码好的原图和/或总览图，按两者的字节数计入上限（已有的部分保留）
+*   - prefetch()：后台预热一张图（只保留最新的一个请求，鼠标快速划过时不会排起长队）
+*   - clear()：清空缓存
+* 与该文件相关联的其他文件：imagecache.cpp, emojilistwidget.cpp, emojimimedata.cpp, emojilistmodel.cpp, tiledimageview.cpp, mainwindow.cpp
+*/
+
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QObject>
+#include <QImage>
+#include <QCache>
+#include <QSet>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+class ImageCache : public QObject {
+    Q_OBJECT
+public:
+    static const qint64 DefaultBudgetBytes = 256LL * 1024 * 1024;
+
+    explicit ImageCache(QObject *parent = nullptr);
+    ~ImageCache() override;
+
+    void setBudget(qint64 bytes) { m_cache.setMaxCost(int(qMax<qint64>(1, bytes / 1024))); }
+    QImage get(const QString &path);
+    bool find(const QString &path, QImage *image, QImage *overview = nullptr);
+    void insert(const QString &path, const QImage &image, const QImage &overview = QImage());
+    void prefetch(const QString &path);
+    void clear();
+
+    int hits() const { return m_hits; }
+    int misses() const { return m_misses; }
+
+private slots:
+    void onDecoded(const QString &path, qint64 mtimeMs, qint64 size, const QImage &image, bool decoded);
+
+private:
+    struct Entry {
+        QImage image;         // 完整解码的原图；为空且 failed 为 false 时表示只有总览图
+        QImage overview;      // 缩小的总览图（预览大图时使用），可为空
+        bool failed = false;  // 无法解码
+        qint64 mtimeMs = 0;
+        qint64 size = 0;
+
+        bool hasOriginal() const { return failed || !image.isNull(); }  // 原图已解码（或已知无法解码）
+    };
+
+    const Entry *lookup(const QString &path, qint64 mtimeMs, qint64 size) const;
+    void store(const QString &path, qint64 mtimeMs, qint64 size, const QImage &image,
+               const QImage &overview, bool failed);
+
+    QThreadPool m_pool;
+    QCache<QString, Entry> m_cache;  // 开销单位 KB
+    QSet<QString> m_pending;         // 已提交预热、尚未回报的文件
+    QAtomicInt m_latest;             // 最新一次预热的代数；排队中的旧任务据此放弃
+    QString m_latestPath;
+    int m_hits = 0;
+    int m_misses = 0;
+};
+
+#endif // IMAGECACHE_H
@@ -0,0 +1,179 @@
+#include "importpipeline.h"
+#include "thumbnailcache.h"
+#include "thumbnailer.h"
+#include "contenthash.h"
+#include "perceptualhash.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+#include "trace.h"
+
+#include <QRunnable>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QHash>
+#include <QAtomicInt>
+#include <QFileInfo>
+#include <QThread>
+
+// 一次导入任务的共享状态：工作线程只写 ready，其余字段只在主线程访问
+struct ImportJob {
+    QMutex mutex;
+    QHash<int, ImportedEmoji> ready;  // seq → 已完成的结果（乱序到达）
+    QAtomicInt cancelled;
+    QSharedPointer<ThumbnailCache> cache;  // 任务持有，保证工作线程使用期间不被释放
+    QSharedPointer<ContentIndex> index;
+    int total = 0;    // 已提交的文件数（主线程）
+    int nextSeq = 0;  // 下一个要插入的序号（主线程），保证与提交顺序一致
+};
+
+namespace {
+
+const int kFlushIntervalMs = 16;  // 约一帧
+const int kMaxBatch = 256;        // 单帧最多插入条数，避免大批量时卡住一帧
+
+// stat 阶段：读取文件信息，文件不存在则整条跳过
+bool statStage(ImportedEmoji &e, QFileInfo &fi)
+{
+    fi.setFile(e.filePath);
+    e.exists = fi.exists();
+    if (!e.exists) return false;
+    e.fileName = fi.fileName();
+    e.createTime = fi.created();
+    e.fileSize = fi.size();
+    return true;
+}
+
+class ImportTask : public QRunnable {
+public:
+    ImportTask(const QSharedPointer<ImportJob> &job, int seq, const QString &path)
+        : m_job(job), m_seq(seq), m_path(path) {}
+
+    void run() override
+    {
+        if (m_job->cancelled.loadAcquire()) return;
+        ImportedEmoji e = ImportPipeline::process(m_path, m_job->cache.data(), m_job->index.data());
+        QMutexLocker lock(&m_job->mutex);
+        m_job->ready.insert(m_seq, e);
+    }
+
+private:
+    QSharedPointer<ImportJob> m_job;  // 持有共享状态，取消后工作线程仍可安全写入
+    int m_seq;
+    QString m_path;
+};
+
+} // namespace
+
+ImportPipeline::ImportPipeline(QObject *parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+    m_flushTimer.setInterval(kFlushIntervalMs);
+    connect(&m_flushTimer, &QTimer::timeout, this, &ImportPipeline::flush);
+}
+
+ImportPipeline::~ImportPipeline()
+{
+    if (m_job) m_job->cancelled.storeRelease(1);
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+ImportedEmoji ImportPipeline::process(const QString &path, ThumbnailCache *cache, ContentIndex *index)
+{
+    TRACE_SCOPE(Trace::Import, "ImportPipeline::process");
+    ImportedEmoji e;
+    e.filePath = path;
+    QFileInfo fi;
+    if (!statStage(e, fi)) return e;
+    // hash 阶段：内容与表情库中已有文件相同时不再解码（再次导入同一文件夹只需读一遍文件）
+    e.contentHash = ContentHash::ofFile(path);
+    if (index && e.contentHash) {
+        e.duplicateOf = index->lookup(e.fileSize, e.contentHash);
+        if (!e.duplicateOf.isEmpty()) {
+            e.thumbnailSkipped = true;
+            return e;
+        }
+    }
+    e.thumbnail = makeThumbnail(fi, cache);
+    // phash 阶段：缩略图只有 180px，整数累加即可，代价远小于解码
+    e.perceptualHash = PerceptualHash::dHash(e.thumbnail, &e.hasPerceptualHash);
+    return e;
+}
+
+QImage ImportPipeline::makeThumbnail(const QFileInfo &fi, ThumbnailCache *cache)
+{
+    TRACE_SCOPE(Trace::Thumbnail, "makeThumbnail");
+    if (cache) {
+        QImage cached = cache->lookup(fi);
+        if (!cached.isNull()) return cached;  // 缓存命中：不读原图
+    }
+    // decode + scale 阶段：由 Thumbnailer 尽量直接解码到目标尺寸，不支持的格式再回退为解码后缩放
+    QImage thumb = Thumbnailer::generate(fi.filePath(), QSize(ThumbnailSize, ThumbnailSize));
+    if (thumb.isNull()) {
+        DEBUG_LOG("Decode failed, placeholder will be used:" << fi.filePath());
+        return QImage();
+    }
+    if (cache) cache->insert(fi, thumb);
+    return thumb;
+}
+
+void ImportPipeline::enqueue(const QStringList &paths)
+{
+    if (paths.isEmpty()) return;
+    if (!m_job) {
+        m_job = QSharedPointer<ImportJob>::create();
+        m_job->cache = m_cache;
+        m_job->index = m_index;
+        m_flushTimer.start();
+    }
+    DEBUG_LOG("Import pipeline: enqueue" << paths.size() << "files, threads:" << m_pool.maxThreadCount());
+    for (const QString &p : paths) {
+        m_pool.start(new ImportTask(m_job, m_job->total++, p));
+    }
+    emit progress(m_job->nextSeq, m_job->total);
+}
+
+void ImportPipeline::cancel()
+{
+    if (!m_job) return;
+    DEBUG_LOG("Import pipeline: cancelled at" << m_job->nextSeq << "/" << m_job->total);
+    m_job->cancelled.storeRelease(1);
+    m_pool.clear();  // 丢弃尚未开始的任务；正在运行的任务结束后写入已失效的 job
+    m_job.reset();
+    m_flushTimer.stop();
+    emit finished(true);
+}
+
+void ImportPipeline::flush()
+{
+    QSharedPointer<ImportJob> job = m_job;  // 信号处理期间可能调用 cancel()
+    if (!job) return;
+
+    QList<ImportedEmoji> batch;
+    const int before = job->nextSeq;
+    {
+        QMutexLocker lock(&job->mutex);
+        auto it = job->ready.find(job->nextSeq);
+        while (it != job->ready.end() && job->nextSeq - before < kMaxBatch) {
+            if (it->exists) {
+                // 按提交顺序登记内容哈希：同一批里内容相同的文件，保留先提交的那个（与串行导入一致）
+                if (job->index && it->contentHash) it->duplicateOf = job->index->claim(it->filePath, it->contentHash);
+                batch.append(*it);  // 不存在的文件与串行路径一样直接跳过
+            }
+            job->ready.erase(it);
+            it = job->ready.find(++job->nextSeq);
+        }
+    }
+    if (job->nextSeq == before) return;
+
+    if (!batch.isEmpty()) emit batchReady(batch);
+    if (job != m_job) return;  // 已在 batchReady 处理中被取消
+    emit progress(job->nextSeq, job->total);
+
+    if (job->nextSeq >= job->total) {
+        DEBUG_LOG("Import pipeline: finished," << job->total << "files");
+        m_job.reset();
+        m_flushTimer.stop();
+        emit finished(false);
+    }
+}
@@ -0,0 +1,83 @@
+/*
+* 文件名：importpipeline.h
+* 日期：2026-10-16
+* 该文件功能大致描述：多线程分阶段导入流水线。stat（读取文件信息）、decode（按目标尺寸解码）、scale（回退缩放）三个阶段在私有线程池中并行执行，
+*                    insert（插入模型）阶段在主线程按帧批量执行，并保证插入顺序与串行导入完全一致。
+* 该文件函数功能描述：
+*   - ImportedEmoji 结构体：工作线程产出的中间结果（只含 QImage，不含 QPixmap，保证线程安全）
+*   - enqueue()：提交一批文件路径；流水线运行中再次提交会追加到队尾，顺序不变
+*   - cancel()：取消尚未插入的条目，已插入的条目保留
+*   - process()：同步执行 stat → hash → decode → scale → phash 各阶段（单文件串行路径，供工作线程复用）；命中缩略图缓存时跳过 decode/scale，
+*               内容与表情库中已有文件相同时跳过 decode/scale；感知哈希由刚得到的缩略图计算，不再读原图
+*   - makeThumbnail()：decode + scale 两个阶段（先查缓存），导入流水线与 ThumbnailLoader 共用
+*   - setThumbnailCache()：设置持久化缩略图缓存（可为空）
+*   - setContentIndex()：设置按内容去重的索引（可为空）；insert 阶段按提交顺序登记，重复文件标记 duplicateOf
+*   - batchReady()/progress()/finished()：信号，分别用于批量插入、状态栏进度、导入结束
+* 与该文件相关联的其他文件：importpipeline.cpp, thumbnailer.h, thumbnailcache.h, contenthash.h, perceptualhash.h, mainwindow.h, mainwindow.cpp, emoji_meta.h
+*/
+
+#ifndef IMPORTPIPELINE_H
+#define IMPORTPIPELINE_H
+
+#include <QObject>
+#include <QImage>
+#include <QDateTime>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <QSharedPointer>
+
+class ThumbnailCache;
+class ContentIndex;
+class QFileInfo;
+struct ImportJob;  // 前置声明：一次导入任务的共享状态（工作线程与主线程共用）
+
+// 工作线程产出的导入结果，在主线程 insert 阶段转换为 EmojiItem
+struct ImportedEmoji {
+    QString filePath;
+    QString fileName;
+    QImage thumbnail;     // 已缩放的缩略图；为空表示解码失败（插入时使用占位图）
+    QDateTime createTime;
+    qint64 fileSize = 0;
+    bool exists = false;  // stat 阶段结果：文件不存在时整条跳过（与串行路径一致）
+    quint64 contentHash = 0;   // 文件内容哈希，0 表示未能读取
+    QString duplicateOf;       // 非空：内容与该文件相同，插入阶段应跳过
+    bool thumbnailSkipped = false;  // 疑似重复而未生成缩略图（最终未判定为重复时由视图按需加载）
+    quint64 perceptualHash = 0;     // 由缩略图计算的 dHash
+    bool hasPerceptualHash = false;
+};
+
+class ImportPipeline : public QObject {
+    Q_OBJECT
+public:
+    explicit ImportPipeline(QObject *parent = nullptr);
+    ~ImportPipeline() override;
+
+    void enqueue(const QStringList &paths);
+    void cancel();
+    bool isRunning() const { return !m_job.isNull(); }
+    void setThumbnailCache(const QSharedPointer<ThumbnailCache> &cache) { m_cache = cache; }
+    void setContentIndex(const QSharedPointer<ContentIndex> &index) { m_index = index; }
+
+    static ImportedEmoji process(const QString &path, ThumbnailCache *cache = nullptr, ContentIndex *index = nullptr);
+    static QImage makeThumbnail(const QFileInfo &fi, ThumbnailCache *cache = nullptr);
+
+    static const int ThumbnailSize = 180;  // 与原 appendEmojiItem 的缩略图尺寸一致
+
+signals:
+    void batchReady(const QList<ImportedEmoji> &batch);  // 每帧最多一次，按提交顺序
+    void progress(int done, int total);
+    void finished(bool cancelled);
+
+private slots:
+    void flush();  // insert 阶段：把已完成的连续前缀交给主线程
+
+private:
+    QThreadPool m_pool;                  // 私有线程池，cancel() 时可以安全 clear()
+    QTimer m_flushTimer;                 // 约 60fps 的批量插入节拍
+    QSharedPointer<ImportJob> m_job;     // 当前任务，空表示空闲
+    QSharedPointer<ThumbnailCache> m_cache;
+    QSharedPointer<ContentIndex> m_index;
+};
+
+#endif // IMPORTPIPELINE_H
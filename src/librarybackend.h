@@ -0,0 +1,84 @@
+/*
+* 文件名：librarybackend.h
+* 日期：2026-10-16
+* 该文件功能大致描述：表情库存储接口。MainWindow 只通过该接口读写表情库元数据，具体实现有两种：
+*                    LibraryStore（emoji_data.json 快照 + 追加日志，全部读入内存）与 SqliteCatalog（带索引的 SQLite 目录，可分页读取）。
+* 该文件函数功能描述：
+*   - LibraryRecord 结构体：持久化的条目元数据（不含缩略图，可以安全地传给写线程）；order 为持久化的排序键
+*   - LibraryQuery 结构体：排序 / 名称过滤 / 分页查询条件
+*   - load()：按持久化顺序读取全部记录
+*   - loadAsync()/loaded()：在后台读取全部记录，读完后以信号交回（冷启动时不阻塞界面线程）；默认实现在事件循环的下一轮同步读取
+*   - query()/count()：按条件查询一页记录 / 记录总数；isIndexed() 为 true 时由索引回答，可以只读第一页就显示
+*   - recordAdd()/recordRemove()/recordRename()/recordHash()/recordPerceptualHash()：记录单条修改（后台合并写入）
+*   - writeSnapshot()：以给定顺序整体重写（排序后使用）；snapshotPending() 表示是否有值得整体重写的积压修改
+*   - flush()：立即把合并中的修改交给写线程
+*   - snapshotWanted()/writeFailed()：信号，请求 MainWindow 提供数据写快照 / 后台写入失败
+* 与该文件相关联的其他文件：librarystore.h, librarystore.cpp, sqlitecatalog.h, sqlitecatalog.cpp, mainwindow.h, mainwindow.cpp
+*/
+
+#ifndef LIBRARYBACKEND_H
+#define LIBRARYBACKEND_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QVector>
+#include <QMetaType>
+#include <QTimer>
+
+struct LibraryRecord {
+    QString path;
+    QString name;
+    QDateTime time;
+    qint64 size = 0;
+    int order = -1;  // 持久化排序键（只在读取时填写；写入时以调用顺序为准）
+    quint64 hash = 0;  // 文件内容哈希，0 表示未知（旧版本导入的条目）
+    quint64 phash = 0;  // 感知哈希（dHash）；纯色图的 dHash 可以为 0，是否已知看 hasPhash
+    bool hasPhash = false;
+};
+Q_DECLARE_METATYPE(LibraryRecord)
+
+struct LibraryQuery {
+    enum SortKey {
+        ByOrder,  // 持久化顺序（用户上次排序后的顺序）
+        ByDate,
+        BySize,
+        ByName
+    };
+    SortKey sortKey = ByOrder;
+    Qt::SortOrder sortOrder = Qt::AscendingOrder;
+    QString nameContains;   // 为空时不过滤，不区分大小写
+    int afterOrder = -1;    // 只在 ByOrder 升序时使用：返回 order 大于该值的记录（翻页不受中途删除影响）
+    int offset = 0;
+    int limit = -1;         // -1 表示不限
+};
+
+class LibraryBackend : public QObject {
+    Q_OBJECT
+public:
+    explicit LibraryBackend(QObject *parent = nullptr) : QObject(parent) {}
+    ~LibraryBackend() override {}
+
+    virtual bool isIndexed() const = 0;
+    virtual QVector<LibraryRecord> load() = 0;
+    virtual void loadAsync() { QTimer::singleShot(0, this, [this]() { emit loaded(load()); }); }
+    virtual QVector<LibraryRecord> query(const LibraryQuery &q) = 0;
+    virtual int count() = 0;
+
+    virtual void recordAdd(const LibraryRecord &rec) = 0;
+    virtual void recordRemove(const QStringList &paths) = 0;
+    virtual void recordRename(const QString &path, const QString &name) = 0;
+    virtual void recordHash(const QString &path, quint64 hash) = 0;  // 为旧条目补记内容哈希
+    virtual void recordPerceptualHash(const QString &path, quint64 phash) = 0;  // 补记感知哈希
+    virtual void writeSnapshot(const QVector<LibraryRecord> &records) = 0;
+    virtual bool snapshotPending() const = 0;
+    virtual void flush() = 0;
+
+signals:
+    void loaded(const QVector<LibraryRecord> &records);
+    void snapshotWanted();
+    void writeFailed(const QString &path);
+};
+
+#endif // LIBRARYBACKEND_H
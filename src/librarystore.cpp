@@ -0,0 +1,378 @@
+#include "librarystore.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+#include "trace.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QHash>
+#include <algorithm>
+
+namespace {
+
+// JSON 数字是 double，放不下 64 位哈希，以 16 进制字符串保存
+QString hashToJson(quint64 hash)
+{
+    return QString::number(hash, 16);
+}
+
+quint64 hashFromJson(const QJsonValue &v)
+{
+    return v.toString().toULongLong(nullptr, 16);
+}
+
+// 读取快照并重放日志；只读文件、不访问 LibraryStore 的成员，可以在写线程中执行
+QVector<LibraryRecord> readLibrary(const QString &snapshotPath, const QString &journalPath, int *replayedOut)
+{
+    TRACE_SCOPE(Trace::Library, "readLibrary");
+    QVector<LibraryRecord> list;
+    QVector<int> orders;
+    QFile f(snapshotPath);
+    if (f.open(QIODevice::ReadOnly)) {
+        const QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+        f.close();
+        if (doc.isArray()) {
+            const QJsonArray arr = doc.array();
+            list.reserve(arr.size());
+            orders.reserve(arr.size());
+            for (const QJsonValue &v : arr) {
+                const QJsonObject o = v.toObject();
+                LibraryRecord rec;
+                rec.path = o["path"].toString();
+                rec.name = o["name"].toString();
+                rec.time = QDateTime::fromString(o["time"].toString(), Qt::ISODate);
+                rec.size = static_cast<qint64>(o["size"].toDouble());
+                rec.hash = hashFromJson(o["hash"]);
+                rec.hasPhash = o.contains("phash");
+                rec.phash = hashFromJson(o["phash"]);
+                list.append(rec);
+                orders.append(o["order"].toInt());
+            }
+        } else {
+            DEBUG_LOG("Invalid JSON format, expected array");
+        }
+    } else {
+        DEBUG_LOG("JSON file does not exist or cannot be opened, starting with empty list");
+    }
+
+    // sort by orderIndex to restore original ordering
+    QVector<int> perm(list.size());
+    for (int i = 0; i < perm.size(); ++i) perm[i] = i;
+    std::stable_sort(perm.begin(), perm.end(), [&orders](int a, int b){ return orders[a] < orders[b]; });
+    QVector<LibraryRecord> ordered;
+    ordered.reserve(list.size());
+    for (int i : perm) ordered.append(list.at(i));
+    list.swap(ordered);
+
+    // 重放日志：快照之后的每一次修改
+    QHash<QString, int> indexOf;
+    indexOf.reserve(list.size());
+    for (int i = list.size() - 1; i >= 0; --i) indexOf.insert(list.at(i).path, i);  // 同路径取第一条
+    QVector<bool> removed(list.size(), false);
+    int replayed = 0;
+
+    QFile j(journalPath);
+    if (j.open(QIODevice::ReadOnly)) {
+        while (!j.atEnd()) {
+            const QByteArray line = j.readLine().trimmed();
+            if (line.isEmpty()) continue;
+            QJsonParseError err;
+            const QJsonObject o = QJsonDocument::fromJson(line, &err).object();
+            if (err.error != QJsonParseError::NoError) {
+                DEBUG_LOG("Journal: truncated record ignored at line" << replayed + 1);
+                break;  // 崩溃时最后一行可能只写了一半
+            }
+            const QString op = o["op"].toString();
+            if (op == "add") {
+                LibraryRecord rec;
+                rec.path = o["path"].toString();
+                rec.name = o["name"].toString();
+                rec.time = QDateTime::fromString(o["time"].toString(), Qt::ISODate);
+                rec.size = static_cast<qint64>(o["size"].toDouble());
+                rec.hash = hashFromJson(o["hash"]);
+                rec.hasPhash = o.contains("phash");
+                rec.phash = hashFromJson(o["phash"]);
+                if (!indexOf.contains(rec.path)) indexOf.insert(rec.path, list.size());
+                list.append(rec);
+                removed.append(false);
+            } else if (op == "del") {
+                for (const QJsonValue &p : o["paths"].toArray()) {
+                    auto hit = indexOf.find(p.toString());
+                    if (hit == indexOf.end()) continue;
+                    removed[hit.value()] = true;
+                    indexOf.erase(hit);
+                }
+            } else if (op == "hash") {
+                const int idx = indexOf.value(o["path"].toString(), -1);
+                if (idx >= 0) list[idx].hash = hashFromJson(o["hash"]);
+            } else if (op == "phash") {
+                const int idx = indexOf.value(o["path"].toString(), -1);
+                if (idx >= 0) {
+                    list[idx].phash = hashFromJson(o["phash"]);
+                    list[idx].hasPhash = true;
+                }
+            } else if (op == "rename") {
+                const int idx = indexOf.value(o["path"].toString(), -1);
+                if (idx >= 0) list[idx].name = o["name"].toString();
+            }
+            ++replayed;
+        }
+    }
+
+    QVector<LibraryRecord> out;
+    out.reserve(list.size());
+    for (int i = 0; i < list.size(); ++i) {
+        if (removed.at(i)) continue;
+        out.append(list.at(i));
+        out.last().order = out.size() - 1;
+    }
+
+    *replayedOut = replayed;
+    return out;
+}
+
+} // namespace
+
+// 运行在写线程中：只做文件 IO，所有数据都以值的形式传入
+class JournalWriter : public QObject {
+    Q_OBJECT
+public:
+    JournalWriter(const QString &snapshotPath, const QString &journalPath)
+        : m_snapshotPath(snapshotPath), m_journal(journalPath) {}
+
+public slots:
+    void appendLines(const QByteArray &lines)
+    {
+        TRACE_SCOPE(Trace::Library, "JournalWriter::appendLines");
+        if (!m_journal.isOpen() && !m_journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            emit failed(m_journal.fileName());
+            return;
+        }
+        if (m_journal.write(lines) != lines.size() || !m_journal.flush()) {
+            emit failed(m_journal.fileName());
+        }
+    }
+
+    void writeSnapshot(const QVector<LibraryRecord> &records)
+    {
+        TRACE_SCOPE(Trace::Library, "JournalWriter::writeSnapshot");
+        QJsonArray arr;
+        for (int i = 0; i < records.size(); ++i) {
+            const LibraryRecord &it = records.at(i);
+            QJsonObject obj;
+            obj["path"] = it.path;
+            obj["name"] = it.name;
+            obj["time"] = it.time.toString(Qt::ISODate);
+            obj["size"] = static_cast<double>(it.size);
+            if (it.hash) obj["hash"] = hashToJson(it.hash);
+            if (it.hasPhash) obj["phash"] = hashToJson(it.phash);
+            obj["order"] = i;
+            arr.append(obj);
+        }
+        // 先原子替换快照，成功后再清空日志；中途崩溃时旧快照 + 日志仍然完整
+        QSaveFile f(m_snapshotPath);
+        if (!f.open(QIODevice::WriteOnly)
+            || f.write(QJsonDocument(arr).toJson(QJsonDocument::Compact)) < 0
+            || !f.commit()) {
+            DEBUG_LOG("Failed to write snapshot:" << m_snapshotPath);
+            emit failed(m_snapshotPath);
+            return;
+        }
+        if (m_journal.isOpen()) m_journal.resize(0);
+        else QFile::resize(m_journal.fileName(), 0);
+        DEBUG_LOG("Snapshot written:" << records.size() << "items");
+    }
+
+    void sync() {}  // 阻塞调用，用于等待之前投递的写入全部完成
+
+    void read()
+    {
+        int replayed = 0;
+        const QVector<LibraryRecord> records = readLibrary(m_snapshotPath, m_journal.fileName(), &replayed);
+        emit recordsRead(records, replayed);
+    }
+
+signals:
+    void failed(const QString &path);
+    void recordsRead(const QVector<LibraryRecord> &records, int replayed);
+
+private:
+    QString m_snapshotPath;
+    QFile m_journal;
+};
+
+LibraryStore::LibraryStore(const QString &snapshotPath, QObject *parent)
+    : LibraryBackend(parent),
+      m_snapshotPath(snapshotPath),
+      m_journalPath(snapshotPath.endsWith(".json") ? snapshotPath.left(snapshotPath.size() - 5) + ".journal"
+                                                   : snapshotPath + ".journal"),
+      m_writer(new JournalWriter(m_snapshotPath, m_journalPath))
+{
+    qRegisterMetaType<QVector<LibraryRecord>>("QVector<LibraryRecord>");
+
+    m_writer->moveToThread(&m_thread);
+    connect(m_writer, &JournalWriter::failed, this, &LibraryStore::writeFailed);
+    connect(m_writer, &JournalWriter::recordsRead, this, &LibraryStore::onRecordsRead);
+    m_thread.setObjectName("LibraryWriter");
+    m_thread.start(QThread::LowPriority);
+
+    m_coalesceTimer.setSingleShot(true);
+    m_coalesceTimer.setInterval(CoalesceMs);
+    connect(&m_coalesceTimer, &QTimer::timeout, this, &LibraryStore::flush);
+
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(IdleSnapshotMs);
+    connect(&m_idleTimer, &QTimer::timeout, this, [this]() {
+        if (m_journalRecords > 0) emit snapshotWanted();
+    });
+}
+
+LibraryStore::~LibraryStore()
+{
+    flush();
+    // 等待队列中的写入完成后再退出写线程
+    QMetaObject::invokeMethod(m_writer, "sync", Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+    delete m_writer;
+}
+
+QVector<LibraryRecord> LibraryStore::load()
+{
+    // 确保之前投递的写入都已落盘，再从磁盘读取
+    flush();
+    QMetaObject::invokeMethod(m_writer, "sync", Qt::BlockingQueuedConnection);
+    int replayed = 0;
+    const QVector<LibraryRecord> out = readLibrary(m_snapshotPath, m_journalPath, &replayed);
+    m_journalRecords = replayed;
+    if (replayed > 0) {
+        DEBUG_LOG("Journal replayed:" << replayed << "records");
+        m_idleTimer.start();  // 稍后把快照 + 日志合并为新快照
+    }
+    return out;
+}
+
+void LibraryStore::loadAsync()
+{
+    // 读取排在之前投递的写入之后（同一个写线程），读到的就是最新状态；
+    // 已在文件中的日志行会在重放时重新计数，之后新追加的照常累加
+    flush();
+    m_journalRecords = 0;
+    QMetaObject::invokeMethod(m_writer, "read", Qt::QueuedConnection);
+}
+
+void LibraryStore::onRecordsRead(const QVector<LibraryRecord> &records, int replayed)
+{
+    m_journalRecords += replayed;
+    if (replayed > 0) {
+        DEBUG_LOG("Journal replayed:" << replayed << "records");
+        m_idleTimer.start();
+    }
+    emit loaded(records);
+}
+
+QVector<LibraryRecord> LibraryStore::query(const LibraryQuery &q)
+{
+    // 没有索引：每次查询都要读入、过滤并排序全部记录
+    QVector<LibraryRecord> all = load();
+    QVector<LibraryRecord> hits;
+    hits.reserve(all.size());
+    for (const LibraryRecord &rec : all) {
+        if (q.afterOrder >= 0 && rec.order <= q.afterOrder) continue;
+        if (!q.nameContains.isEmpty() && !rec.name.contains(q.nameContains, Qt::CaseInsensitive)) continue;
+        hits.append(rec);
+    }
+    auto less = [&q](const LibraryRecord &a, const LibraryRecord &b) {
+        switch (q.sortKey) {
+        case LibraryQuery::ByDate: return a.time < b.time;
+        case LibraryQuery::BySize: return a.size < b.size;
+        case LibraryQuery::ByName: return a.name.compare(b.name, Qt::CaseInsensitive) < 0;
+        default: return a.order < b.order;
+        }
+    };
+    std::stable_sort(hits.begin(), hits.end(), less);
+    if (q.sortOrder == Qt::DescendingOrder) std::reverse(hits.begin(), hits.end());
+    const int from = qMin(q.offset, hits.size());
+    const int n = q.limit < 0 ? hits.size() - from : qMin(q.limit, hits.size() - from);
+    return hits.mid(from, n);
+}
+
+void LibraryStore::append(const QByteArray &line)
+{
+    m_pending += line;
+    m_pending += '\n';
+    ++m_journalRecords;
+    if (!m_coalesceTimer.isActive()) m_coalesceTimer.start();
+    m_idleTimer.start();
+}
+
+void LibraryStore::recordAdd(const LibraryRecord &rec)
+{
+    QJsonObject o;
+    o["op"] = "add";
+    o["path"] = rec.path;
+    o["name"] = rec.name;
+    o["time"] = rec.time.toString(Qt::ISODate);
+    o["size"] = static_cast<double>(rec.size);
+    if (rec.hash) o["hash"] = hashToJson(rec.hash);
+    if (rec.hasPhash) o["phash"] = hashToJson(rec.phash);
+    append(QJsonDocument(o).toJson(QJsonDocument::Compact));
+}
+
+void LibraryStore::recordRemove(const QStringList &paths)
+{
+    if (paths.isEmpty()) return;
+    QJsonObject o;
+    o["op"] = "del";
+    o["paths"] = QJsonArray::fromStringList(paths);
+    append(QJsonDocument(o).toJson(QJsonDocument::Compact));
+}
+
+void LibraryStore::recordRename(const QString &path, const QString &name)
+{
+    QJsonObject o;
+    o["op"] = "rename";
+    o["path"] = path;
+    o["name"] = name;
+    append(QJsonDocument(o).toJson(QJsonDocument::Compact));
+}
+
+void LibraryStore::recordHash(const QString &path, quint64 hash)
+{
+    QJsonObject o;
+    o["op"] = "hash";
+    o["path"] = path;
+    o["hash"] = hashToJson(hash);
+    append(QJsonDocument(o).toJson(QJsonDocument::Compact));
+}
+
+void LibraryStore::recordPerceptualHash(const QString &path, quint64 phash)
+{
+    QJsonObject o;
+    o["op"] = "phash";
+    o["path"] = path;
+    o["phash"] = hashToJson(phash);
+    append(QJsonDocument(o).toJson(QJsonDocument::Compact));
+}
+
+void LibraryStore::writeSnapshot(const QVector<LibraryRecord> &records)
+{
+    flush();  // 之前的日志先入队，快照写完后会一并被截断
+    QMetaObject::invokeMethod(m_writer, "writeSnapshot", Qt::QueuedConnection,
+                              Q_ARG(QVector<LibraryRecord>, records));
+    m_journalRecords = 0;
+    m_idleTimer.stop();
+}
+
+void LibraryStore::flush()
+{
+    m_coalesceTimer.stop();
+    if (m_pending.isEmpty()) return;
+    QMetaObject::invokeMethod(m_writer, "appendLines", Qt::QueuedConnection, Q_ARG(QByteArray, m_pending));
+    m_pending.clear();
+}
+
+#include "librarystore.moc"
@@ -0,0 +1,73 @@
+/*
+* 文件名：librarystore.h
+* 日期：2026-10-16
+* 该文件功能大致描述：表情库持久化。快照仍是 emoji_data.json（格式不变），每次修改只向 emoji_data.journal 追加一行小记录；
+*                    同一时间段内的修改合并后交给后台写线程，主线程不做任何文件 IO。空闲或窗口隐藏时在后台写出压缩快照并清空日志；
+*                    启动时读取快照并重放日志，进程崩溃后不丢失已写入日志的修改。
+* 该文件函数功能描述：
+*   - LibraryBackend 接口的 JSON 实现（isIndexed() 为 false：查询需要先读入全部记录）
+*   - load()：读取快照 + 重放日志，返回按顺序排列的记录；日志非空时稍后请求一次快照
+*   - loadAsync()：同样的读取放到写线程中执行（排在已投递的写入之后），读完后发出 loaded()
+*   - query()/count()：在读入的全部记录上线性过滤、排序、分页（作为 SqliteCatalog 的对照实现）
+*   - recordAdd()/recordRemove()/recordRename()/recordHash()/recordPerceptualHash()：追加日志记录（合并后在后台写入）
+*   - writeSnapshot()：在后台写出完整快照并截断日志
+*   - flush()：立即把合并中的日志记录交给写线程
+*   - snapshotWanted()：信号，空闲一段时间且日志有新记录时发出，由 MainWindow 提供数据调用 writeSnapshot()
+*   - writeFailed()：信号，后台写入失败
+* 与该文件相关联的其他文件：librarystore.cpp, librarybackend.h, mainwindow.h, mainwindow.cpp, emoji_meta.h
+*/
+
+#ifndef LIBRARYSTORE_H
+#define LIBRARYSTORE_H
+
+#include "librarybackend.h"
+#include <QByteArray>
+#include <QTimer>
+#include <QThread>
+
+class JournalWriter;  // 前置声明：运行在写线程中的对象
+
+class LibraryStore : public LibraryBackend {
+    Q_OBJECT
+public:
+    explicit LibraryStore(const QString &snapshotPath, QObject *parent = nullptr);
+    ~LibraryStore() override;
+
+    QString snapshotPath() const { return m_snapshotPath; }
+    QString journalPath() const { return m_journalPath; }
+
+    bool isIndexed() const override { return false; }
+    QVector<LibraryRecord> load() override;
+    void loadAsync() override;
+    QVector<LibraryRecord> query(const LibraryQuery &q) override;
+    int count() override { return load().size(); }
+
+    void recordAdd(const LibraryRecord &rec) override;
+    void recordRemove(const QStringList &paths) override;
+    void recordRename(const QString &path, const QString &name) override;
+    void recordHash(const QString &path, quint64 hash) override;
+    void recordPerceptualHash(const QString &path, quint64 phash) override;
+    void writeSnapshot(const QVector<LibraryRecord> &records) override;
+    bool snapshotPending() const override { return m_journalRecords > 0 || !m_pending.isEmpty(); }
+    void flush() override;
+
+    static const int CoalesceMs = 100;   // 合并窗口：这段时间内的修改一次写入
+    static const int IdleSnapshotMs = 5000;  // 空闲多久后写快照
+
+private slots:
+    void onRecordsRead(const QVector<LibraryRecord> &records, int replayed);
+
+private:
+    void append(const QByteArray &line);
+
+    QString m_snapshotPath;
+    QString m_journalPath;
+    QThread m_thread;
+    JournalWriter *m_writer;
+    QByteArray m_pending;       // 合并中的日志行
+    QTimer m_coalesceTimer;
+    QTimer m_idleTimer;
+    int m_journalRecords = 0;   // 上次快照之后的日志记录数
+};
+
+#endif // LIBRARYSTORE_H
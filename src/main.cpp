@@ -1,40 +1,81 @@
 #include "mainwindow.h"
 #include <QApplication>
+#include <QTimer>
 #include "splashiconwidget.h"
+#include "startupprofile.h"
+#include "trace.h"
+#include "headlessrunner.h"
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <cstdio>
+#endif
 /*
 * 文件名：main.cpp
 * 日期：2025-10-21
 * 该文件功能描述：程序入口，先显示可点击的 SVG 启动图标（SplashIconWidget），点击后打开主窗口，关闭主窗口后再次显示启动图标。
-* 与该文件相关联的其他文件：splashiconwidget.h/cpp, mainwindow.h/cpp, resources.qrc
+*                启动图标绘制出来之后才构造主窗口（表情库在后台读取），用户看到图标的时间不受表情库大小影响；
+*                若在主窗口构造之前就点击了图标，则立即构造。各启动阶段由 StartupProfile 计时。
+*                带 --headless 参数时只创建 QCoreApplication，交给 HeadlessRunner 批量导入与预热缩略图，不显示任何窗口。
+* 与该文件相关联的其他文件：splashiconwidget.h/cpp, mainwindow.h/cpp, startupprofile.h/cpp, trace.h/cpp, headlessrunner.h/cpp, resources.qrc
 */
 int main(int argc, char *argv[])
 {
+    // 命令行模式：没有窗口，也不加载 GUI 平台插件，可以在无显示器的构建机上运行
+    if (HeadlessRunner::isRequested(argc, argv)) {
+#ifdef Q_OS_WIN
+        // 程序按 GUI 子系统链接，没有自己的控制台；从命令行启动时把输出接到父进程的控制台
+        if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+            freopen("CONOUT$", "w", stdout);
+            freopen("CONOUT$", "w", stderr);
+        }
+#endif
+        QCoreApplication app(argc, argv);
+        QCoreApplication::setApplicationName("EmojiManager");
+        HeadlessRunner runner;
+        return runner.run(app);
+    }
+
+    StartupProfile::start();
     QApplication a(argc, argv);
+    DEBUG_LOG("Application started");
 
-    // 调试宏，可根据需要打开或关闭
-#define ENABLE_DEBUG 1
-#ifdef ENABLE_DEBUG
-    qDebug("Application started");
-#endif
+    // 环境变量 EMOJI_TRACE=<文件> 从启动开始录制追踪，退出时写出 Chrome trace JSON（运行中也可按 Ctrl+Shift+T 开关）
+    const QString tracePath = QString::fromLocal8Bit(qgetenv("EMOJI_TRACE"));
+    if (!tracePath.isEmpty()) {
+        Trace::start();
+        QObject::connect(&a, &QCoreApplication::aboutToQuit, [tracePath]() {
+            if (Trace::isRecording()) Trace::writeChromeTrace(tracePath);
+        });
+    }
 
     // UPGRADE: 轻量风格接近 macOS（Fusion + 自定义 QPalette 可进一步美化）
     QApplication::setStyle("Fusion");
+    StartupProfile::mark("application created");
 
-    // 创建堆对象，保证生命周期长于 lambda
+    // 创建堆对象，保证生命周期长于 lambda；先显示启动图标并立即绘制
     SplashIconWidget *splash = new SplashIconWidget();
-    MainWindow *w = new MainWindow();
-
     splash->show();
+    QCoreApplication::processEvents();
+    StartupProfile::mark("splash shown");
+
+    MainWindow *w = nullptr;
+    auto ensureWindow = [&w, splash]() {
+        if (w) return;
+        w = new MainWindow();
+        QObject::connect(w, &MainWindow::windowHidden, [=](){
+            splash->show();
+        });
+    };
+    // 事件循环开始后（启动图标已显示）再构造主窗口
+    QTimer::singleShot(0, ensureWindow);
 
     // 点击启动图标：显示主窗口，隐藏启动图标
-    QObject::connect(splash, &SplashIconWidget::clicked, [=](){
+    QObject::connect(splash, &SplashIconWidget::clicked, [&w, splash, ensureWindow](){
+        StartupProfile::mark("splash clicked");
+        ensureWindow();
         w->show();
         splash->hide();
     });
 
-    QObject::connect(w, &MainWindow::windowHidden, [=](){
-        splash->show();
-    });
-
     return a.exec();
 }
@@ -1,9 +1,20 @@
 #include "mainwindow.h"
 #include "previewdialog.h"
+#include "thumbnailer.h"
+#include "librarystore.h"
+#include "sqlitecatalog.h"
+#include "contenthash.h"
+#include "framecache.h"
+#include "animationclock.h"
+#include "imagecache.h"
+#include "emojimimedata.h"
+#include "folderwatcher.h"
+#include "missingfilescanner.h"
+#include "startupprofile.h"
+#include "trace.h"
 
 #include <QToolBar>
 #include <QFileDialog>
-#include <QStandardItem>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
@@ -13,22 +24,76 @@
 #include <QDateTime>
 #include <QDir>
 #include <QInputDialog>
+#include <QElapsedTimer>
+#include <QShowEvent>
+#include <QHideEvent>
+#include <QDialog>
+#include <QFormLayout>
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QRegularExpression>
 #include <algorithm>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       m_view(new EmojiListWidget(this)),
-      m_model(new QStandardItemModel(this)),
+      m_model(new EmojiListModel(this)),
+      m_filter(new EmojiFilterModel(this)),
       m_jsonFile(QDir::home().filePath("emoji_data.json")),
-      m_previewDialog(nullptr)  // 【新增】：初始化预览对话框指针
+      m_previewDialog(nullptr),  // 【新增】：初始化预览对话框指针
+      m_importer(new ImportPipeline(this)),
+      m_thumbCache(new ThumbnailCache),
+      m_thumbLoader(new ThumbnailLoader(this)),
+      m_phashJob(new PerceptualHashJob(this)),
+      m_frameCache(new FrameCache(this)),
+      m_animClock(new AnimationClock(this)),
+      m_imageCache(new ImageCache(this)),
+      m_folderWatcher(new FolderWatcher(QDir::home().filePath(".emoji_watched.json"), this)),
+      m_walker(new DirectoryWalker(this)),
+      m_missingScanner(new MissingFileScanner(this)),
+      m_store(openLibrary()),
+      m_pageTimer(new QTimer(this)),
+      m_orderSaveTimer(new QTimer(this))
 {
     DEBUG_LOG("MainWindow constructor started");
+    // 缩略图缓存与 emoji_data.json 放在同一目录
+    m_thumbCache->open(QDir::home().filePath(".emoji_thumbs"));
+    m_importer->setThumbnailCache(m_thumbCache);
+    m_thumbLoader->setThumbnailCache(m_thumbCache);
+    m_phashJob->setThumbnailCache(m_thumbCache);
+    m_contentIndex.reset(new ContentIndex);  // 按内容去重：随表情库加载/导入/删除维护，导入线程共享
+    m_importer->setContentIndex(m_contentIndex);
+    m_invalidPixmap.load(":/new/prefix1/icons/invalid.png");
+    m_invalidPixmap = m_invalidPixmap.scaled(ImportPipeline::ThumbnailSize, ImportPipeline::ThumbnailSize,
+                                             Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    // 索引目录：第一页同步显示，其余各页在事件循环空闲时逐页追加
+    m_pageTimer->setInterval(0);
+    connect(m_pageTimer, &QTimer::timeout, this, [this]() { appendLibraryPage(PageSize); });
+    // 连续切换排序时只在停下来后写一次快照
+    m_orderSaveTimer->setSingleShot(true);
+    m_orderSaveTimer->setInterval(OrderSaveDelayMs);
+    connect(m_orderSaveTimer, &QTimer::timeout, this, &MainWindow::saveToJson);
     resize(1000, 700);
     setupUI();
-    // 【已禁用内部拖动排序】：不再需要 rowsMoved 信号连接
-    // connect(m_model, &QStandardItemModel::rowsMoved, this, &MainWindow::onModelRowsMoved);
+    // 构造只建界面：JSON 库在写线程中读取，索引目录只读第一页；文件是否存在随后在后台检查
     loadFromJson();
     DEBUG_LOG("MainWindow initialized successfully");
+    StartupProfile::mark("main window constructed");
+}
+
+LibraryBackend *MainWindow::openLibrary()
+{
+    // 有 QSQLITE 驱动时使用带索引的目录（首次打开自动导入 emoji_data.json）；环境变量 EMOJI_STORAGE=json 强制使用 JSON
+    if (qgetenv("EMOJI_STORAGE") != "json" && SqliteCatalog::isAvailable()) {
+        SqliteCatalog *catalog = new SqliteCatalog(QDir::home().filePath("emoji_catalog.db"), m_jsonFile, this);
+        if (catalog->open()) {
+            DEBUG_LOG("Library backend: SQLite catalog");
+            return catalog;
+        }
+        delete catalog;
+    }
+    DEBUG_LOG("Library backend: JSON snapshot + journal");
+    return new LibraryStore(m_jsonFile, this);
 }
 
 void MainWindow::setupUI()
@@ -36,9 +101,29 @@ void MainWindow::setupUI()
     DEBUG_LOG("Setting up UI components");
     // 中央视图
     setCentralWidget(m_view);
-    m_view->setModel(m_model);
-    m_view->setItemDelegate(new EmojiListDelegate(this));
+    m_filter->setSourceModel(m_model);
+    m_view->setModel(m_filter);  // 视图只看到过滤代理；代理的行号经 sourceRow() 转换后再访问 m_model
+    EmojiListDelegate *delegate = new EmojiListDelegate(this);
+    delegate->setAnimation(m_frameCache, m_animClock);  // GIF/WebP 由共享时钟驱动，只有可见单元格推进
+    m_view->setItemDelegate(delegate);
+    m_view->setAnimation(m_frameCache, m_animClock);
+    m_view->setImageCache(m_imageCache);
+    m_model->setImageCache(m_imageCache);  // 拖出与复制共用同一份原图缓存
+    m_animClock->setPaused(true);  // 窗口显示后才开始播放
     
+    // Ctrl+C：复制所有选中项
+    QAction *copyAct = new QAction(tr("复制"), m_view);
+    copyAct->setShortcut(QKeySequence::Copy);
+    copyAct->setShortcutContext(Qt::WidgetShortcut);
+    m_view->addAction(copyAct);
+    connect(copyAct, &QAction::triggered, this, &MainWindow::onCopySelected);
+
+    // Ctrl+Shift+T：开始/停止录制追踪，停止时导出 Chrome trace JSON
+    QAction *traceAct = new QAction(tr("录制追踪"), this);
+    traceAct->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_T));
+    addAction(traceAct);
+    connect(traceAct, &QAction::triggered, this, &MainWindow::onToggleTrace);
+
     // 【禁用内部拖动排序】：支持拖动但不支持在列表内重排
     m_view->setDragDropMode(QAbstractItemView::DragOnly);  // 只允许拖出，不允许内部排序
     DEBUG_LOG("Drag mode set to DragOnly (internal sorting disabled)");
@@ -50,6 +135,7 @@ void MainWindow::setupUI()
     QAction *saveAct = tb->addAction(tr("保存"));
     QAction *delSelAct = tb->addAction(tr("删除选中"));
     QAction *refreshAct = tb->addAction(tr("刷新"));
+    QAction *watchedAct = tb->addAction(tr("监视的文件夹"));
 
     tb->addSeparator();
     tb->addWidget(new QLabel(tr("排序:")));
@@ -74,6 +160,16 @@ void MainWindow::setupUI()
     m_showNamesAct = tb->addAction(tr("显示文件名"));
     m_showNamesAct->setCheckable(true);
     m_showNamesAct->setChecked(false);
+    QAction *clusterAct = tb->addAction(tr("聚类相似"));
+
+    tb->addSeparator();
+    m_filterEdit = new QLineEdit(this);
+    m_filterEdit->setPlaceholderText(tr("搜索名称或路径"));
+    m_filterEdit->setClearButtonEnabled(true);
+    m_filterEdit->setMaximumWidth(240);
+    tb->addWidget(m_filterEdit);
+    m_showAllAct = tb->addAction(tr("显示全部"));
+    m_showAllAct->setVisible(false);  // 只在显示查找相似/聚类结果时出现
 
     // 连接信号
     connect(addFilesAct, &QAction::triggered, this, &MainWindow::onAddFiles);
@@ -81,60 +177,184 @@ void MainWindow::setupUI()
     connect(saveAct, &QAction::triggered, this, &MainWindow::onSave);
     connect(delSelAct, &QAction::triggered, this, &MainWindow::onDeleteSelected);
     connect(refreshAct, &QAction::triggered, this, &MainWindow::loadFromJson);
+    connect(watchedAct, &QAction::triggered, this, &MainWindow::onManageWatchedFolders);
+    connect(m_folderWatcher, &FolderWatcher::changesReady, this, &MainWindow::onWatchedFolderChanged);
     connect(m_view, &EmojiListWidget::requestDeleteIndex, this, &MainWindow::onDeleteIndex);
     connect(m_view, &EmojiListWidget::requestPreview, this, &MainWindow::onPreview);
     connect(m_view, &EmojiListWidget::requestRename, this, &MainWindow::onRenameIndex);
     connect(m_view, &EmojiListWidget::requestCopyPath, this, &MainWindow::onCopyPath);
     connect(m_view, &EmojiListWidget::itemClickedIndex, this, &MainWindow::onItemClicked);
+    connect(m_view, &EmojiListWidget::requestFindSimilar, this, &MainWindow::onFindSimilar);
+    connect(clusterAct, &QAction::triggered, this, &MainWindow::onClusterSimilar);
+    connect(m_showAllAct, &QAction::triggered, this, &MainWindow::onShowAll);
+    connect(m_phashJob, &PerceptualHashJob::progress, this, &MainWindow::onPerceptualHashProgress);
+    connect(m_phashJob, &PerceptualHashJob::finished, this, &MainWindow::onPerceptualHashesReady);
     
     // 【关键修复】：在连接信号之前已经阻止了信号触发，所以这里安全连接
     connect(m_sortCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onSortCriteriaChanged);
     connect(m_orderCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onSortOrderChanged);
     connect(m_showNamesAct, &QAction::toggled, this, &MainWindow::onShowNamesToggled);
+    connect(m_filterEdit, &QLineEdit::textChanged, this, &MainWindow::onFilterTextChanged);
+
+    // 导入进度：状态栏右侧的进度条 + 取消按钮，仅在导入期间显示
+    m_importProgress = new QProgressBar(this);
+    m_importProgress->setMaximumWidth(200);
+    m_importProgress->setTextVisible(true);
+    m_importProgress->hide();
+    m_importCancelBtn = new QToolButton(this);
+    m_importCancelBtn->setText(tr("取消导入"));
+    m_importCancelBtn->hide();
+    statusBar()->addPermanentWidget(m_importProgress);
+    statusBar()->addPermanentWidget(m_importCancelBtn);
+
+    connect(m_importCancelBtn, &QToolButton::clicked, m_importer, &ImportPipeline::cancel);
+    connect(m_importCancelBtn, &QToolButton::clicked, m_walker, &DirectoryWalker::cancel);
+    connect(m_walker, &DirectoryWalker::filesFound, this, &MainWindow::onWalkFilesFound);
+    connect(m_walker, &DirectoryWalker::finished, this, &MainWindow::onWalkFinished);
+    connect(m_importer, &ImportPipeline::batchReady, this, &MainWindow::onImportBatch);
+    connect(m_importer, &ImportPipeline::progress, this, &MainWindow::onImportProgress);
+    connect(m_importer, &ImportPipeline::finished, this, &MainWindow::onImportFinished);
+
+    // 缩略图按需加载：视图报告可见范围 → 加载器在后台生成 → 回填模型
+    connect(m_view, &EmojiListWidget::visibleRowsChanged, this, &MainWindow::onVisibleRowsChanged);
+    connect(m_thumbLoader, &ThumbnailLoader::thumbnailReady, this, &MainWindow::onThumbnailLoaded);
+
+    // 持久化：修改写日志，空闲时由这里提供数据写出压缩快照
+    connect(m_store, &LibraryBackend::snapshotWanted, this, &MainWindow::saveToJson);
+    connect(m_store, &LibraryBackend::loaded, this, &MainWindow::onLibraryLoaded);
+    connect(m_missingScanner, &MissingFileScanner::missing, this, &MainWindow::onMissingFiles);
+    connect(m_store, &LibraryBackend::writeFailed, this, [this](const QString &path) {
+        QMessageBox::warning(this, tr("保存失败"), tr("无法写入 %1").arg(path));
+    });
 }
 
-void MainWindow::appendEmojiItem(const QString &path, bool preserveOrder)
+int MainWindow::appendEmojiItems(const QList<ImportedEmoji> &batch)
 {
-    QFileInfo fi(path);
-    if (!fi.exists()) return;
-
-    QImageReader reader(path);
-    reader.setAutoTransform(true);
-    QImage img = reader.read();
-    QPixmap pix;
+    TRACE_SCOPE(Trace::Import, "appendEmojiItems");
+    finishLibraryLoad();  // 新条目排在整个库之后，先把尚未读取的页追加完
+    QVector<EmojiItem> items;
+    items.reserve(batch.size());
+    for (const ImportedEmoji &imported : batch) {
+        if (!imported.duplicateOf.isEmpty()) {
+            // 内容与已有文件完全相同：不再占用缩略图和一条库记录
+            ++m_duplicateCount;
+            m_duplicateBytes += imported.fileSize;
+            DEBUG_LOG("Duplicate skipped:" << imported.filePath << "same as" << imported.duplicateOf);
+            continue;
+        }
+        QPixmap pix;
+        if (imported.thumbnailSkipped) {
+            // 疑似重复而未解码，最终不是重复：留空，由视图按需加载
+        } else if (imported.thumbnail.isNull()) {
+            /*
+            * 原有问题：
+            *   其他类型图片无法加载，导致网格空白。
+            * 修改日期：2025-10-21
+            * 修改操作：失败时使用占位图 resources/invalid.png
+            * 修改后续期达到的效果：网格显示占位图，防止空白。
+            */
+            pix = m_invalidPixmap;
+            DEBUG_LOG("Invalid pixmap replaced with placeholder:" << imported.filePath);
+        } else {
+            // decode/scale 已在工作线程完成，这里只做 QImage → QPixmap（必须在主线程）
+            pix = QPixmap::fromImage(imported.thumbnail);
+        }
 
-    if (img.isNull()) {
-        /*
-        * 原有问题：
-        *   其他类型图片无法加载，导致网格空白。
-        * 修改日期：2025-10-21
-        * 修改操作：失败时使用占位图 resources/invalid.png
-        * 修改后续期达到的效果：网格显示占位图，防止空白。
-        */
-        pix.load(":/new/prefix1/icons/invalid.png");
-        DEBUG_LOG("Invalid pixmap replaced with placeholder:" << path);
-    } else {
-        pix = QPixmap::fromImage(img);
+        EmojiItem item;
+        item.filePath = imported.filePath;
+        item.fileName = imported.fileName;
+        item.thumbnail = pix;
+        item.createTime = imported.createTime;
+        item.fileSize = imported.fileSize;
+        item.orderIndex = m_model->rowCount() + items.size();
+        item.contentHash = imported.contentHash;
+        item.perceptualHash = imported.perceptualHash;
+        item.hasPerceptualHash = imported.hasPerceptualHash;
+        items.append(item);
+        m_store->recordAdd(toRecord(item));  // 每个导入文件只追加一行日志
     }
+    m_model->appendItems(items);  // 一批只插入一次
+    DEBUG_LOG("Inserted" << items.size() << "emojis, total:" << m_model->rowCount());
+    TRACE_COUNTER(Trace::Import, "library items", m_model->rowCount());
+    return items.size();
+}
 
-    EmojiItem item;
-    item.filePath = path;
-    item.fileName = fi.fileName();
-    item.thumbnail = pix.scaled(180,180, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    item.createTime = fi.created();
-    item.fileSize = fi.size();
-    item.orderIndex = preserveOrder ? m_list.size() : m_list.size();
-    DEBUG_LOG("Loaded emoji:" << path);
+void MainWindow::onImportBatch(const QList<ImportedEmoji> &batch)
+{
+    m_importedCount += appendEmojiItems(batch);
+}
 
-    m_list.append(item);
+void MainWindow::onImportProgress(int done, int total)
+{
+    m_importProgress->setMaximum(total);
+    m_importProgress->setValue(done);
+    m_importProgress->setFormat(tr("导入 %1/%2").arg(done).arg(total));
+    m_importProgress->show();
+    m_importCancelBtn->show();
+}
 
-    QStandardItem *it = new QStandardItem();
-    it->setIcon(QIcon(item.thumbnail));
-    it->setText(item.fileName);
-    it->setData(item.filePath, Qt::UserRole);
-    it->setData(m_showNames, Qt::UserRole + 10); // pass showName flag to delegate via model
-    it->setEditable(false);
-    m_model->appendRow(it);
+void MainWindow::onImportFinished(bool cancelled)
+{
+    // 目录还在遍历：导入队列只是暂时排空，等遍历结束、最后一批导入完再汇总
+    if (!cancelled && m_walker->isRunning()) {
+        m_importSummaryPending = true;
+        return;
+    }
+    m_importSummaryPending = false;
+    m_importProgress->hide();
+    m_importCancelBtn->hide();
+    // 导入过程中为旧条目补算的内容哈希：写回模型与表情库，下次不必再算
+    const QVector<QPair<QString, quint64>> learned = m_contentIndex->takeLearned();
+    for (const auto &ph : learned) {
+        m_model->setContentHashForPath(ph.first, ph.second);
+        m_store->recordHash(ph.first, ph.second);
+    }
+    m_store->flush(); // 导入的条目已逐条写入日志，这里只把合并中的记录交给写线程
+    m_thumbCache->flush();
+    QString msg = cancelled ? tr("导入已取消，已导入 %1 项").arg(m_importedCount)
+                            : tr("导入完成，共 %1 项").arg(m_importedCount);
+    if (m_duplicateCount > 0) {
+        msg += tr("，跳过 %1 个重复文件（%2 MB）").arg(m_duplicateCount)
+                   .arg(m_duplicateBytes / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+    statusBar()->showMessage(msg, 5000);
+    DEBUG_LOG("Import finished, cancelled:" << cancelled << "inserted:" << m_importedCount
+              << "duplicates:" << m_duplicateCount << "learned hashes:" << learned.size());
+    DEBUG_LOG("Thumbnail decode stats:\n" << qPrintable(Thumbnailer::statsReport()));
+    m_importedCount = 0;
+    m_duplicateCount = 0;
+    m_duplicateBytes = 0;
+}
+
+void MainWindow::onVisibleRowsChanged(int first, int last, int prefetchFirst, int prefetchLast)
+{
+    TRACE_SCOPE(Trace::Thumbnail, "onVisibleRowsChanged");
+    // 加载顺序：可见行 → 滚动方向上的预取行 → 反方向的预取行；已有缩略图的行跳过
+    QStringList paths;
+    auto want = [&](int r) {
+        const int src = m_filter->sourceRow(r);  // 视图行号是过滤代理的行号
+        if (!m_model->hasThumbnail(src)) paths.append(m_model->item(src).filePath);
+    };
+    for (int r = first; r <= last; ++r) want(r);
+    const bool down = (prefetchLast - last) >= (first - prefetchFirst);
+    if (down) {
+        for (int r = last + 1; r <= prefetchLast; ++r) want(r);
+        for (int r = first - 1; r >= prefetchFirst; --r) want(r);
+    } else {
+        for (int r = first - 1; r >= prefetchFirst; --r) want(r);
+        for (int r = last + 1; r <= prefetchLast; ++r) want(r);
+    }
+    TRACE_COUNTER(Trace::Thumbnail, "thumbnail requests", paths.size());
+    m_thumbLoader->request(paths);  // 不在窗口内的排队任务在这里被取消
+}
+
+void MainWindow::onThumbnailLoaded(const QString &path, const QImage &thumb)
+{
+    // O(1) 路径索引；加载期间已被删除的路径直接忽略
+    m_model->setThumbnailForPath(path, thumb.isNull() ? m_invalidPixmap : QPixmap::fromImage(thumb));
+    if (!m_warming.isEmpty() && m_warming.remove(path) && m_warming.isEmpty()) {
+        StartupProfile::mark("first page thumbnails ready");
+    }
 }
 
 void MainWindow::onAddFiles()
@@ -147,11 +367,8 @@ void MainWindow::onAddFiles()
         return;
     }
     DEBUG_LOG("Adding" << files.size() << "files");
-    for (const QString &f : files) {
-        appendEmojiItem(f);
-    }
-    saveToJson(); // 自动保存变更
-    DEBUG_LOG("Files added and saved successfully");
+    finishLibraryLoad();  // 去重需要整个库的内容哈希
+    m_importer->enqueue(files); // 多线程导入，完成后在 onImportFinished() 中统一保存
 }
 
 void MainWindow::onAddFolder()
@@ -163,26 +380,141 @@ void MainWindow::onAddFolder()
         return;
     }
     DEBUG_LOG("Selected folder:" << dir);
-    QDir d(dir);
-    QStringList filters = {"*.png","*.jpg","*.jpeg","*.gif","*.webp","*.bmp"};
-    QFileInfoList list = d.entryInfoList(filters, QDir::Files | QDir::NoSymLinks, QDir::Name);
-    DEBUG_LOG("Found" << list.size() << "image files in folder");
-    for (const QFileInfo &fi : list) {
-        appendEmojiItem(fi.absoluteFilePath());
+    if (m_folderWatcher->isWatched(dir)) {
+        statusBar()->showMessage(tr("该文件夹已在监视中，其中的变化会自动导入"), 3000);
+        return;
+    }
+
+    // 导入选项：是否包含子文件夹、是否跟随符号链接、包含/排除的通配符（分号分隔）
+    QDialog dlg(this);
+    dlg.setWindowTitle(tr("导入文件夹"));
+    QFormLayout *form = new QFormLayout(&dlg);
+    QCheckBox *recursiveBox = new QCheckBox(tr("包含子文件夹"), &dlg);
+    recursiveBox->setChecked(true);
+    QCheckBox *followBox = new QCheckBox(tr("跟随符号链接"), &dlg);
+    QLineEdit *includeEdit = new QLineEdit(WalkFilter::defaultIncludeGlobs().join("; "), &dlg);
+    QLineEdit *excludeEdit = new QLineEdit(&dlg);
+    excludeEdit->setPlaceholderText(tr("例如 .git; *_backup; 草稿/*"));
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dlg);
+    connect(buttons, &QDialogButtonBox::accepted, &dlg, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+    form->addRow(recursiveBox);
+    form->addRow(followBox);
+    form->addRow(tr("包含："), includeEdit);
+    form->addRow(tr("排除："), excludeEdit);
+    form->addRow(buttons);
+    if (dlg.exec() != QDialog::Accepted) return;
+
+    const QRegularExpression separators("[;,]");
+    m_walkRoot = dir;
+    m_walkOptions = WalkOptions();
+    m_walkOptions.recursive = recursiveBox->isChecked();
+    m_walkOptions.followSymlinks = followBox->isChecked();
+    for (const QString &g : includeEdit->text().split(separators)) {
+        if (!g.trimmed().isEmpty()) m_walkOptions.includeGlobs.append(g.trimmed());
+    }
+    for (const QString &g : excludeEdit->text().split(separators)) {
+        if (!g.trimmed().isEmpty()) m_walkOptions.excludeGlobs.append(g.trimmed());
+    }
+    m_walkBaseline.clear();
+    finishLibraryLoad();  // 去重需要整个库的内容哈希
+    // 并行遍历，找到的文件分批流入导入队列；结束后以找到的文件为快照开始监视
+    m_walker->start(dir, m_walkOptions);
+    statusBar()->showMessage(tr("正在查找图片…"));
+}
+
+void MainWindow::onWalkFilesFound(const FoundFileList &files)
+{
+    QStringList paths;
+    paths.reserve(files.size());
+    for (const FoundFile &f : files) paths.append(f.path);
+    m_walkBaseline += files;
+    m_importer->enqueue(paths);
+}
+
+void MainWindow::onWalkFinished(int files, int dirs, bool cancelled)
+{
+    DEBUG_LOG("Folder walk finished:" << files << "files in" << dirs << "folders, cancelled:" << cancelled);
+    if (!cancelled) {
+        m_folderWatcher->watch(m_walkRoot, m_walkOptions, m_walkBaseline);
+        if (files == 0) statusBar()->showMessage(tr("文件夹中没有找到图片"), 3000);
+    }
+    m_walkBaseline.clear();
+    // 最后一批已经导入完：补上等遍历结束才做的汇总
+    if (m_importSummaryPending && !m_importer->isRunning()) onImportFinished(cancelled);
+}
+
+void MainWindow::onWatchedFolderChanged(const QStringList &added, const QStringList &changed, const QStringList &removed)
+{
+    finishLibraryLoad();  // 按路径查找条目与去重都需要整个库
+
+    // 删除的文件移出表情库；修改过的文件先移除旧条目再重新导入（缩略图缓存按修改时间与大小自动失效）
+    QVector<int> rows;
+    QStringList paths;
+    QStringList incoming = added;
+    for (const QStringList *list : {&removed, &changed}) {
+        for (const QString &path : *list) {
+            const int row = m_model->rowOfPath(path);
+            if (row < 0) continue;  // 用户已经从列表中移除：修改后也不再导入回来
+            const EmojiItem &it = m_model->item(row);
+            m_contentIndex->remove(it.filePath, it.fileSize, it.contentHash);
+            rows.append(row);
+            paths.append(path);
+            if (list == &changed) incoming.append(path);
+        }
+    }
+    if (!rows.isEmpty()) {
+        m_model->removeRowSet(rows);
+        m_store->recordRemove(paths);  // 整批只写一条日志
+    }
+    if (!incoming.isEmpty()) m_importer->enqueue(incoming);  // 已在库中的同一文件按内容去重跳过
+    DEBUG_LOG("Watched folder changes applied: removed" << rows.size() << "rows, importing" << incoming.size());
+    statusBar()->showMessage(tr("文件夹有变化：新增 %1，修改 %2，删除 %3")
+                             .arg(added.size()).arg(changed.size()).arg(removed.size()), 3000);
+}
+
+void MainWindow::onManageWatchedFolders()
+{
+    const QStringList folders = m_folderWatcher->folders();
+    if (folders.isEmpty()) {
+        QMessageBox::information(this, tr("监视的文件夹"), tr("还没有监视的文件夹。通过\"添加文件夹\"导入的文件夹会自动监视。"));
+        return;
+    }
+    bool ok = false;
+    const QString dir = QInputDialog::getItem(this, tr("监视的文件夹"), tr("选择要停止监视的文件夹（已导入的表情保留）："),
+                                              folders, 0, false, &ok);
+    if (!ok || dir.isEmpty()) return;
+    m_folderWatcher->unwatch(dir);
+    statusBar()->showMessage(tr("已停止监视：%1").arg(dir), 3000);
+}
+
+void MainWindow::onToggleTrace()
+{
+    if (!Trace::isRecording()) {
+        Trace::start();
+        statusBar()->showMessage(tr("正在录制追踪，再按 Ctrl+Shift+T 停止并导出"));
+        return;
+    }
+    const QString path = QDir::home().filePath(
+        QStringLiteral("emoji_trace_%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss")));
+    if (Trace::writeChromeTrace(path)) {
+        statusBar()->showMessage(tr("追踪已导出：%1（用 chrome://tracing 或 ui.perfetto.dev 打开）").arg(path), 8000);
+    } else {
+        statusBar()->showMessage(tr("追踪导出失败：%1").arg(path), 5000);
     }
-    saveToJson();
-    DEBUG_LOG("Folder contents added and saved successfully");
 }
 
 void MainWindow::onSave()
 {
     DEBUG_LOG("Manual save triggered");
     saveToJson();
+    m_store->flush();
     statusBar()->showMessage(tr("已保存"), 2000);
 }
 
 void MainWindow::onDeleteSelected()
 {
+    TRACE_SCOPE(Trace::Model, "onDeleteSelected");
     QModelIndexList sels = m_view->selectionModel()->selectedIndexes();
     if (sels.isEmpty()) {
         DEBUG_LOG("Delete selected: no items selected");
@@ -199,26 +531,20 @@ void MainWindow::onDeleteSelected()
     bool deleteDisk = (ret == QMessageBox::Yes);
     DEBUG_LOG("Delete mode:" << (deleteDisk ? "from disk" : "from list only"));
 
-    // collect rows to delete (unique rows)
-    QList<int> rows;
+    // collect rows to delete；模型会合并为连续区间，每个区间只发一次删除信号
+    QVector<int> rows;
+    QStringList paths;
+    rows.reserve(sels.size());
     for (const QModelIndex &idx : sels) {
-        rows.append(idx.row());
-    }
-    std::sort(rows.begin(), rows.end(), std::greater<int>()); // delete from bottom upward
-    for (int r : rows) {
-        QModelIndex idx = m_model->index(r, 0);
-        QString path = idx.data(Qt::UserRole).toString();
-        if (deleteDisk) QFile::remove(path);
-        m_model->removeRow(r);
-        // remove from m_list by path
-        for (int i=0;i<m_list.size();++i){
-            if (m_list[i].filePath == path){ m_list.removeAt(i); break;}
-        }
+        rows.append(m_filter->sourceRow(idx.row()));
+        const EmojiItem &it = m_model->item(rows.last());
+        paths.append(it.filePath);
+        m_contentIndex->remove(it.filePath, it.fileSize, it.contentHash);
+        if (deleteDisk) QFile::remove(paths.last());
     }
-    // UPGRADE: 更新 orderIndex
-    for (int i=0;i<m_list.size();++i) m_list[i].orderIndex = i;
-    saveToJson();
-    DEBUG_LOG("Deleted items, remaining count:" << m_list.size());
+    const int ranges = m_model->removeRowSet(rows);
+    m_store->recordRemove(paths);  // 整批只写一条日志
+    DEBUG_LOG("Deleted" << rows.size() << "items in" << ranges << "ranges, remaining count:" << m_model->rowCount());
 }
 
 void MainWindow::onDeleteIndex(const QModelIndex &index)
@@ -234,14 +560,10 @@ void MainWindow::onDeleteIndex(const QModelIndex &index)
                                     QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
     if (ret == QMessageBox::Yes) QFile::remove(path);
 
-    // remove from model and list
-    m_model->removeRow(index.row());
-    for (int i=0;i<m_list.size();++i){
-        if (m_list[i].filePath == path){ m_list.removeAt(i); break;}
-    }
-    // update indices
-    for (int i=0;i<m_list.size();++i) m_list[i].orderIndex = i;
-    saveToJson();
+    const int row = m_filter->sourceRow(index.row());
+    m_contentIndex->remove(path, m_model->item(row).fileSize, m_model->item(row).contentHash);
+    m_model->removeRow(row);
+    m_store->recordRemove({path});
 }
 
 void MainWindow::onPreview(const QString &path)
@@ -251,18 +573,22 @@ void MainWindow::onPreview(const QString &path)
     // 【优化】：使用单例预览对话框，支持在预览时点击其他图片自动切换
     if (!m_previewDialog) {
         m_previewDialog = new PreviewDialog(this);
+        m_previewDialog->setImageCache(m_imageCache);  // 预览的解码结果与复制/拖出共用一个内存上限
+        connect(m_previewDialog, &PreviewDialog::stepRequested, this, &MainWindow::onPreviewStep);
         DEBUG_LOG("Preview dialog created");
     }
     
-    QPixmap pix(path);
-    if (pix.isNull()) {
+    if (!QImageReader(path).canRead()) {  // 只读文件头；解码由预览对话框在后台分块完成
         DEBUG_LOG("Cannot load image for preview:" << path);
         // 【重要】：不弹出无效图片的预览，避免用户无法退出的问题
         return;
     }
     
     // 如果对话框已经显示，直接更新图片；否则显示对话框
-    m_previewDialog->setImage(pix);
+    m_previewPath = path;
+    m_previewDirection = 1;
+    m_previewDialog->setImagePath(path);
+    prefetchPreviewNeighbours();
     
     if (!m_previewDialog->isVisible()) {
         m_previewDialog->show();
@@ -273,6 +599,52 @@ void MainWindow::onPreview(const QString &path)
     DEBUG_LOG("Preview updated/shown");
 }
 
+int MainWindow::previewRow() const
+{
+    const int src = m_model->rowOfPath(m_previewPath);
+    if (src < 0) return -1;
+    return m_filter->mapFromSource(m_model->index(src, 0)).row();
+}
+
+void MainWindow::onPreviewStep(int delta)
+{
+    if (!m_previewDialog || !m_previewDialog->isVisible()) return;
+    const int row = previewRow();
+    if (row < 0) return;  // 预览中的图已被删除或过滤掉
+    const int count = m_filter->rowCount();
+    // 跳过无法读取的文件（只读文件头），到头不循环
+    for (int r = row + delta; r >= 0 && r < count; r += delta) {
+        const QModelIndex idx = m_filter->index(r, 0);
+        const QString path = idx.data(Qt::UserRole).toString();
+        if (!QImageReader(path).canRead()) continue;
+        m_view->selectionModel()->setCurrentIndex(idx, QItemSelectionModel::ClearAndSelect);
+        m_view->scrollTo(idx);
+        m_previewPath = path;
+        m_previewDirection = delta > 0 ? 1 : -1;
+        m_previewDialog->setImagePath(path, false);  // 翻页不播放淡入动画
+        prefetchPreviewNeighbours();
+        return;
+    }
+    statusBar()->showMessage(delta > 0 ? tr("已经是最后一张") : tr("已经是第一张"), 1500);
+}
+
+void MainWindow::prefetchPreviewNeighbours()
+{
+    const int row = previewRow();
+    if (row < 0) return;
+    const int count = m_filter->rowCount();
+    QStringList paths;
+    // 按翻页方向由近及远：先是前进方向的 N 张，再是后退方向的 N 张
+    for (int side : {m_previewDirection, -m_previewDirection}) {
+        for (int i = 1; i <= PreviewPrefetchCount; ++i) {
+            const int r = row + side * i;
+            if (r < 0 || r >= count) break;
+            paths << m_filter->index(r, 0).data(Qt::UserRole).toString();
+        }
+    }
+    m_previewDialog->prefetch(paths);
+}
+
 void MainWindow::onRenameIndex(const QModelIndex &index)
 {
     if (!index.isValid()) {
@@ -290,13 +662,12 @@ void MainWindow::onRenameIndex(const QModelIndex &index)
         return;
     }
     DEBUG_LOG("New name:" << newName);
-    // update model display name only
-    m_model->setData(index, newName, Qt::DisplayRole);
-    // update in m_list
-    for (int i=0;i<m_list.size();++i){
-        if (m_list[i].filePath == path){ m_list[i].fileName = newName; break;}
-    }
-    saveToJson();
+    const QModelIndex source = m_filter->mapToSource(index);
+    // 按名称翻页时改名会移动条目在目录中的位置，翻页偏移随之错位：先读完（追加在末尾，源行号不变）
+    if (m_paging && m_pageSortKey == LibraryQuery::ByName) finishLibraryLoad();
+    // update model display name only（模型即存储，EmojiItem::fileName 同步更新）
+    m_model->setData(source, newName, Qt::DisplayRole);
+    m_store->recordRename(path, newName);  // 只追加一行日志，不重写整个文件
 }
 
 void MainWindow::onCopyPath(const QString &path)
@@ -315,59 +686,66 @@ void MainWindow::onItemClicked(const QModelIndex &index)
     }
     QString path = index.data(Qt::UserRole).toString();
     DEBUG_LOG("Item clicked, copying to clipboard:" << path);
-    QPixmap pix(path);
-    if (pix.isNull()) {
+    // 只读文件头判断能否打开；原始字节/图像在粘贴时才生成（GIF 粘贴后仍是动图）
+    if (!QImageReader(path).canRead()) {
         DEBUG_LOG("Failed to load image:" << path);
         statusBar()->showMessage(tr("无法复制：图片无法打开"), 2000);
         return;
     }
     QClipboard *clip = QApplication::clipboard();
-    clip->setPixmap(pix);
+    clip->setMimeData(new EmojiMimeData({path}, m_imageCache));
     // UPGRADE: 单击直接把图片复制到剪贴板，方便在聊天框粘贴
     statusBar()->showMessage(tr("图片已复制到剪贴板，粘贴到聊天框即可。"), 2000);
     DEBUG_LOG("Image copied to clipboard successfully");
 }
 
+void MainWindow::onCopySelected()
+{
+    const QModelIndexList sels = m_view->selectionModel()->selectedIndexes();
+    if (sels.isEmpty()) return;
+    QStringList paths;
+    paths.reserve(sels.size());
+    for (const QModelIndex &idx : sels) paths.append(idx.data(Qt::UserRole).toString());
+    // 多选只提供文件 URL 列表，不解码任何图片
+    QApplication::clipboard()->setMimeData(new EmojiMimeData(paths, m_imageCache));
+    statusBar()->showMessage(tr("已复制 %1 项").arg(paths.size()), 2000);
+    DEBUG_LOG("Copied" << paths.size() << "items to clipboard");
+}
+
 void MainWindow::onSortCriteriaChanged(int /*idx*/)
 {
+    TRACE_SCOPE(Trace::Model, "onSortCriteriaChanged");
     // 【关键修复】：需要区分用户手动拖动排序 vs 工具栏选择排序
     // 
     // 问题现象：即使用户拖动排序成功，只要工具栏排序条件改变就会被重新排序
     // 正确做法：工具栏排序应该有一个"自定义排序"选项，拖动后的排序应保持不变
     // 
-    // 暂时方案：在 m_list 中记录排序模式，只有当用户主动改变工具栏排序时才重新排序
+    // 暂时方案：在模型中记录排序模式，只有当用户主动改变工具栏排序时才重新排序
     // 当用户从文件夹加载或手动拖动时，应该恢复到"自定义"排序模式
     
     int criteria = m_sortCombo->currentIndex();
     int order = m_orderCombo->currentIndex(); // 0:降序,1:升序
     DEBUG_LOG("Sort criteria changed - criteria:" << criteria << "order:" << order);
+
+    if (m_paging) {
+        // 索引目录尚未读完：由目录按索引排序，只重新读第一页，其余页仍在空闲时按新顺序追加
+        static const LibraryQuery::SortKey keys[] = { LibraryQuery::ByDate, LibraryQuery::BySize, LibraryQuery::ByName };
+        startLibraryPaging(keys[criteria], order == 0 ? Qt::DescendingOrder : Qt::AscendingOrder);
+        m_orderSaveAfterLoad = true;  // 新的排序键等全部读完后再写
+        return;
+    }
+    finishLibraryLoad();  // JSON 库的后台读取尚未完成时改为同步读取，排序针对整个库
     
-    // apply sort on m_list, then rebuild model
-    if (criteria == 0) { // date
-        std::sort(m_list.begin(), m_list.end(), [](const EmojiItem &a, const EmojiItem &b){
-            return a.createTime < b.createTime;
-        });
-    } else if (criteria == 1) { // size
-        std::sort(m_list.begin(), m_list.end(), [](const EmojiItem &a, const EmojiItem &b){
-            return a.fileSize < b.fileSize;
-        });
-    } else { // name
-        std::sort(m_list.begin(), m_list.end(), [](const EmojiItem &a, const EmojiItem &b){
-            return a.fileName.toLower() < b.fileName.toLower();
-        });
-    }
-    if (order == 0) { // 要求降序 -> reverse
-        std::reverse(m_list.begin(), m_list.end());
-    }
-    // 更新 orderIndex
-    for (int i=0;i<m_list.size();++i) m_list[i].orderIndex = i;
-    rebuildModelFromList();
-    saveToJson();
-    DEBUG_LOG("List sorted and saved, count:" << m_list.size());
+    // 排序结果以 layoutChanged 置换应用到模型，不再重建；置换由排序引擎缓存，切换升降序只反向映射行号
+    m_model->sortItems(static_cast<EmojiListModel::SortKey>(criteria),
+                       order == 0 ? Qt::DescendingOrder : Qt::AscendingOrder);
+    m_orderSaveTimer->start();  // 顺序整体改变：稍后在后台写新快照，而不是逐条记日志
+    DEBUG_LOG("List sorted, count:" << m_model->rowCount());
 }
 
 void MainWindow::onSortOrderChanged(int /*idx*/)
 {
+    TRACE_SCOPE(Trace::Model, "onSortOrderChanged");
     // Just reuse the same handler
     onSortCriteriaChanged(m_sortCombo->currentIndex());
 }
@@ -375,165 +753,355 @@ void MainWindow::onSortOrderChanged(int /*idx*/)
 void MainWindow::onShowNamesToggled(bool checked)
 {
     DEBUG_LOG("Show names toggled:" << (checked ? "ON" : "OFF"));
-    m_showNames = checked;
-    // propagate to model: set a role to each item so delegate can read
-    for (int r=0; r<m_model->rowCount(); ++r) {
-        QModelIndex idx = m_model->index(r,0);
-        m_model->setData(idx, m_showNames, Qt::UserRole + 10);
+    // 模型对所有行统一返回该标志，只发一次 dataChanged
+    m_model->setShowNames(checked);
+}
+
+void MainWindow::onFilterTextChanged(const QString &text)
+{
+    TRACE_SCOPE(Trace::Model, "onFilterTextChanged");
+    // 搜索索引第一次使用时建立；之后每次按键只做增量查询，模型数据不重建
+    // 索引目录尚未读完时不等待：先在已读取的行中匹配，之后追加的页由过滤代理逐批匹配
+    QElapsedTimer timer;
+    timer.start();
+    m_filter->setFilterText(text);
+    if (m_filter->isFiltering()) {
+        statusBar()->showMessage(m_paging ? tr("已找到 %1 项，表情库仍在读取").arg(m_filter->rowCount())
+                                          : tr("找到 %1 项").arg(m_filter->rowCount()), 2000);
     }
-    // request view update
-    m_view->viewport()->update();
+    m_showAllAct->setVisible(m_filter->isPinned());
+    DEBUG_LOG("Filter:" << text << "matches:" << m_filter->rowCount() << "in" << timer.nsecsElapsed() / 1000 << "us");
 }
 
-void MainWindow::onModelRowsMoved(const QModelIndex &/*parent*/, int start, int end, const QModelIndex &/*destination*/, int row)
+bool MainWindow::ensurePerceptualHashes()
 {
-    Q_UNUSED(start);
-    Q_UNUSED(end);
-    Q_UNUSED(row);
-    
-    // 【彻底修复】：不依赖 rowsMoved 的参数（这些参数容易导致理解错误）
-    // 【正确做法】：直接根据 model 的当前状态重新同步 m_list
-    // 【关键问题】：拖动排序后，需要同步 model 和 m_list，并立即保存到 JSON，防止被后续操作覆盖
-    // 
-    // 理由：
-    // 1. Qt 的 rowsMoved 信号参数在不同场景下含义可能有歧义
-    // 2. model 此时已经完成了行的移动，我们直接读取 model 的最新顺序最安全
-    // 3. 通过 filePath（唯一标识）在 model 中的顺序来重建 m_list 的顺序
-    // 4. 必须同时更新 model 中每个 item 的 orderIndex，确保数据一致
-    
-    // 根据 model 中的顺序重新排列 m_list
-    QList<EmojiItem> orderedList;
-    
-    for (int r = 0; r < m_model->rowCount(); ++r) {
-        QModelIndex idx = m_model->index(r, 0);
-        QString path = idx.data(Qt::UserRole).toString();
-        
-        // 从 m_list 中找到对应的项
-        for (const EmojiItem &item : m_list) {
-            if (item.filePath == path) {
-                EmojiItem copy = item;
-                copy.orderIndex = orderedList.size();  // 更新排序索引
-                orderedList.append(copy);
-                break;
-            }
-        }
+    if (m_phashJob->isRunning()) return false;
+    QStringList missing = m_model->pathsWithoutPerceptualHash();
+    if (!m_phashFailed.isEmpty()) {
+        missing.erase(std::remove_if(missing.begin(), missing.end(),
+                                     [this](const QString &p) { return m_phashFailed.contains(p); }),
+                      missing.end());
     }
-    
-    // 【关键】：只有当 orderedList 的大小与 m_list 相同时才进行替换
-    // 这确保我们没有丢失任何项
-    if (orderedList.size() == m_list.size()) {
-        m_list = orderedList;
-        
-        // 【重要】：同时更新 model 中每个 item 的 orderIndex
-        // 这样即使 model 被重建，orderIndex 也能正确保存
-        for (int r = 0; r < m_model->rowCount(); ++r) {
-            QModelIndex idx = m_model->index(r, 0);
-            // 更新 model 中存储的 orderIndex（使用一个自定义 role）
-            m_model->setData(idx, orderedList[r].orderIndex, Qt::UserRole + 50);
-        }
-        
-        // 立即保存到 JSON，防止被其他操作覆盖
-        saveToJson();
-        DEBUG_LOG("Drag sync completed, list size:" << m_list.size());
-    } else {
-        DEBUG_LOG("WARNING: Size mismatch! orderedList:" << orderedList.size() << "m_list:" << m_list.size());
+    if (missing.isEmpty()) return true;
+    m_phashRequested = missing;
+    m_phashJob->start(missing);  // 缩略图大多已在磁盘缓存中，补算只做缩小与比较
+    return false;
+}
+
+void MainWindow::onFindSimilar(const QModelIndex &index)
+{
+    if (!index.isValid()) return;
+    const QString path = m_model->item(m_filter->sourceRow(index.row())).filePath;
+    finishLibraryLoad();  // 在整个库中查找
+    m_clusterPending = false;
+    if (!ensurePerceptualHashes()) {
+        m_similarPending = path;  // 补算完成后在 onPerceptualHashesReady() 中继续
+        return;
+    }
+    showSimilar(path);
+}
+
+void MainWindow::onClusterSimilar()
+{
+    finishLibraryLoad();
+    m_similarPending.clear();
+    if (!ensurePerceptualHashes()) {
+        m_clusterPending = true;
+        return;
+    }
+    showClusters();
+}
+
+void MainWindow::showSimilar(const QString &path)
+{
+    const int row = m_model->rowOfPath(path);
+    if (row < 0) return;  // 补算期间已被删除
+    if (!m_model->item(row).hasPerceptualHash) {
+        statusBar()->showMessage(tr("无法查找相似：图片无法打开"), 2000);
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<SimilarityIndex::Match> matches = m_model->similarIds(m_model->idOfRow(row));
+    QVector<int> ids;
+    ids.reserve(matches.size());
+    for (const SimilarityIndex::Match &m : matches) ids.append(m.id);  // 按距离升序，自身排在最前
+    const qint64 us = timer.nsecsElapsed() / 1000;
+
+    m_filterEdit->blockSignals(true);
+    m_filterEdit->clear();
+    m_filterEdit->blockSignals(false);
+    m_filter->setIdFilter(ids);
+    m_showAllAct->setVisible(true);
+    statusBar()->showMessage(tr("找到 %1 张相似图片").arg(ids.size() - 1), 5000);
+    DEBUG_LOG("Find similar:" << path << "matches:" << ids.size() - 1 << "in" << us << "us");
+}
+
+void MainWindow::showClusters()
+{
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<QVector<int>> groups = m_model->similarClusters();
+    const qint64 us = timer.nsecsElapsed() / 1000;
+    DEBUG_LOG("Cluster similar:" << groups.size() << "groups in" << us << "us");
+    if (groups.isEmpty()) {
+        statusBar()->showMessage(tr("没有找到相似图片"), 3000);
+        return;
+    }
+    // 同一组的条目相邻显示，组按大小降序
+    QVector<int> ids;
+    for (const QVector<int> &g : groups) ids += g;
+
+    m_filterEdit->blockSignals(true);
+    m_filterEdit->clear();
+    m_filterEdit->blockSignals(false);
+    m_filter->setIdFilter(ids);
+    m_showAllAct->setVisible(true);
+    statusBar()->showMessage(tr("找到 %1 组相似图片，共 %2 项").arg(groups.size()).arg(ids.size()), 5000);
+}
+
+void MainWindow::onShowAll()
+{
+    m_filter->setFilterText(QString());
+    m_showAllAct->setVisible(false);
+}
+
+void MainWindow::onPerceptualHashProgress(int done, int total)
+{
+    statusBar()->showMessage(tr("正在计算感知哈希 %1/%2").arg(done).arg(total));
+}
+
+void MainWindow::onPerceptualHashesReady(const PerceptualHashList &hashes)
+{
+    QSet<QString> hashed;
+    hashed.reserve(hashes.size());
+    for (const auto &ph : hashes) {
+        m_model->setPerceptualHashForPath(ph.first, ph.second);
+        m_store->recordPerceptualHash(ph.first, ph.second);
+        hashed.insert(ph.first);
+    }
+    for (const QString &path : qAsConst(m_phashRequested)) {
+        if (!hashed.contains(path)) m_phashFailed.insert(path);
+    }
+    m_phashRequested.clear();
+    m_store->flush();
+    statusBar()->clearMessage();
+    DEBUG_LOG("Perceptual hashes backfilled:" << hashes.size() << "failed:" << m_phashFailed.size());
+
+    if (m_clusterPending) {
+        m_clusterPending = false;
+        showClusters();
+    } else if (!m_similarPending.isEmpty()) {
+        const QString path = m_similarPending;
+        m_similarPending.clear();
+        showSimilar(path);
     }
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     event->ignore();   // 忽略默认关闭
+    if (m_store->snapshotPending() || m_orderSaveTimer->isActive() || m_orderSaveAfterLoad) saveToJson();  // 隐藏时把积压的修改合并为快照（后台）
+    else m_store->flush();
+    m_thumbCache->flush();
     this->hide();      // 隐藏窗口
     emit windowHidden(); // 可自定义信号
 }
 
+void MainWindow::showEvent(QShowEvent *event)
+{
+    QMainWindow::showEvent(event);
+    m_animClock->setPaused(false);
+    StartupProfile::reportOnNextPaint(m_view->viewport(), "first grid paint");
+}
 
-void MainWindow::rebuildModelFromList()
+void MainWindow::hideEvent(QHideEvent *event)
 {
-    DEBUG_LOG("Rebuilding model from list, count:" << m_list.size());
-    m_model->clear();
-    for (const EmojiItem &item : m_list) {
-        QStandardItem *s = new QStandardItem();
-        s->setIcon(QIcon(item.thumbnail));
-        s->setText(item.fileName);
-        s->setData(item.filePath, Qt::UserRole);
-        s->setData(m_showNames, Qt::UserRole + 10);
-        s->setEditable(false);
-        m_model->appendRow(s);
-    }
-    DEBUG_LOG("Model rebuilt successfully");
+    QMainWindow::hideEvent(event);
+    m_animClock->setPaused(true);  // 隐藏（或最小化）后不再重绘动图
+}
+
+LibraryRecord MainWindow::toRecord(const EmojiItem &item)
+{
+    LibraryRecord rec;
+    rec.path = item.filePath;
+    rec.name = item.fileName;
+    rec.time = item.createTime;
+    rec.size = item.fileSize;
+    rec.hash = item.contentHash;
+    rec.phash = item.perceptualHash;
+    rec.hasPhash = item.hasPerceptualHash;
+    return rec;
 }
 
 void MainWindow::saveToJson()
 {
-    DEBUG_LOG("Saving to JSON:" << m_jsonFile << "item count:" << m_list.size());
-    QJsonArray arr;
-    for (const EmojiItem &it : m_list) {
-        QJsonObject obj;
-        obj["path"] = it.filePath;
-        obj["name"] = it.fileName;
-        obj["time"] = it.createTime.toString(Qt::ISODate);
-        obj["size"] = static_cast<double>(it.fileSize);
-        obj["order"] = it.orderIndex;
-        arr.append(obj);
-    }
-    QJsonDocument doc(arr);
-    QFile f(m_jsonFile);
-    if (f.open(QIODevice::WriteOnly)) {
-        f.write(doc.toJson());
-        f.close();
-        DEBUG_LOG("JSON saved successfully");
+    TRACE_SCOPE(Trace::Library, "saveToJson");
+    // 主线程只收集元数据（不含缩略图），JSON 序列化与写文件都在后台写线程完成
+    finishLibraryLoad();  // 快照必须包含整个库
+    m_orderSaveTimer->stop();
+    DEBUG_LOG("Saving snapshot:" << m_jsonFile << "item count:" << m_model->rowCount());
+    QVector<LibraryRecord> records;
+    records.reserve(m_model->rowCount());
+    for (int i = 0; i < m_model->rowCount(); ++i) {
+        records.append(toRecord(m_model->item(i)));  // 当前显示顺序即持久化排序索引
+    }
+    m_store->writeSnapshot(records);
+}
+
+QVector<EmojiItem> MainWindow::itemsFromRecords(const QVector<LibraryRecord> &records)
+{
+    TRACE_SCOPE(Trace::Library, "itemsFromRecords");
+    // 不在这里检查文件是否存在：冷启动时逐条 stat 会访问整个库的磁盘位置，改由 m_missingScanner 在后台检查
+    QVector<EmojiItem> list;
+    list.reserve(records.size());
+    QStringList paths;
+    paths.reserve(records.size());
+    for (const LibraryRecord &rec : records) {
+        EmojiItem it;
+        it.filePath = rec.path;
+        it.fileName = rec.name;
+        // 缩略图不在这里加载：视图显示到该行时由 ThumbnailLoader 按需生成（先查磁盘缓存）
+        it.createTime = rec.time;
+        it.fileSize = rec.size;
+        it.orderIndex = m_model->rowCount() + list.size();
+        it.contentHash = rec.hash;
+        it.perceptualHash = rec.phash;
+        it.hasPerceptualHash = rec.hasPhash;
+        m_contentIndex->add(rec.path, rec.size, rec.hash);
+        list.append(it);
+        paths.append(rec.path);
+    }
+    m_missingScanner->check(paths);
+    return list;
+}
+
+void MainWindow::startLibraryPaging(LibraryQuery::SortKey key, Qt::SortOrder order)
+{
+    m_thumbLoader->clear();
+    m_missingScanner->clear();
+    m_contentIndex->clear();
+    m_model->setItems(QVector<EmojiItem>());
+    m_showAllAct->setVisible(false);  // 模型重置会退出查找相似/聚类结果
+
+    m_pageSortKey = key;
+    m_pageSortOrder = order;
+    m_pageAfter = -1;
+    m_paging = true;
+    appendLibraryPage(FirstPageSize);
+    if (m_paging) m_pageTimer->start();
+    else m_pageTimer->stop();
+}
+
+void MainWindow::appendLibraryPage(int limit)
+{
+    LibraryQuery q;
+    q.sortKey = m_pageSortKey;
+    q.sortOrder = m_pageSortOrder;
+    q.limit = limit;
+    if (q.sortKey == LibraryQuery::ByOrder) {
+        q.afterOrder = m_pageAfter;  // 按持久化顺序以 order 为游标翻页：中途删除条目不会使后面的页错位
+    } else {
+        // 已读取的行正是排序结果的前缀；其中删除的条目在目录中也已删除（query() 先等待写入），偏移即当前行数
+        q.offset = m_model->rowCount();
+    }
+    const QVector<LibraryRecord> records = m_store->query(q);
+    m_model->appendItems(itemsFromRecords(records));
+    if (records.size() < limit) {
+        m_paging = false;
+        m_pageTimer->stop();
+        DEBUG_LOG("Library fully loaded, count:" << m_model->rowCount());
+        if (m_orderSaveAfterLoad) {
+            m_orderSaveAfterLoad = false;
+            m_orderSaveTimer->start();  // 读取期间排过序：现在才有完整的顺序可写
+        }
     } else {
-        DEBUG_LOG("Failed to save JSON:" << m_jsonFile);
-        QMessageBox::warning(this, tr("保存失败"), tr("无法写入 %1").arg(m_jsonFile));
+        m_pageAfter = records.last().order;
+    }
+}
+
+void MainWindow::finishLibraryLoad()
+{
+    if (m_loadPending) {
+        // 后台读取尚未完成就需要整个库（例如启动后立即导入）：同步读一次，稍后到达的结果被忽略
+        DEBUG_LOG("Library needed before background load finished, loading synchronously");
+        onLibraryLoaded(m_store->load());
     }
+    if (!m_paging) return;
+    m_pageTimer->stop();
+    while (m_paging) appendLibraryPage(PageSize);
 }
 
 void MainWindow::loadFromJson()
 {
     DEBUG_LOG("Loading from JSON:" << m_jsonFile);
-    m_list.clear();
-    m_model->clear();
-
-    QFile f(m_jsonFile);
-    if (!f.exists()) {
-        DEBUG_LOG("JSON file does not exist, starting with empty list");
+    m_pageTimer->stop();
+    m_paging = false;
+    if (m_store->isIndexed()) {
+        // 索引目录：只读第一页就显示，其余页随后在事件循环中追加
+        startLibraryPaging(LibraryQuery::ByOrder, Qt::AscendingOrder);
+        onLibraryReady();
         return;
     }
-    if (!f.open(QIODevice::ReadOnly)) {
-        DEBUG_LOG("Failed to open JSON file for reading");
-        return;
+
+    m_thumbLoader->clear();
+    m_missingScanner->clear();
+    m_contentIndex->clear();
+    m_model->setItems(QVector<EmojiItem>());
+    m_showAllAct->setVisible(false);  // 重新加载会退出查找相似/聚类结果
+
+    // 快照 + 日志重放（崩溃后也能恢复到最后一次修改）在写线程中进行，读完后由 onLibraryLoaded() 显示
+    m_loadPending = true;
+    m_store->loadAsync();
+}
+
+void MainWindow::onLibraryLoaded(const QVector<LibraryRecord> &records)
+{
+    if (!m_loadPending) return;  // finishLibraryLoad() 已经同步读取过
+    m_loadPending = false;
+    const QVector<EmojiItem> list = itemsFromRecords(records);
+    DEBUG_LOG("Loaded" << list.size() << "items from JSON");
+    m_model->setItems(list);
+    onLibraryReady();
+}
+
+void MainWindow::onLibraryReady()
+{
+    // 窗口还没显示（启动图标等待点击）：先为首屏的行从磁盘缓存读出缩略图，点击后第一帧就有图
+    if (!isVisible()) {
+        QStringList paths;
+        m_warming.clear();
+        const int n = qMin(m_filter->rowCount(), WarmRows);
+        for (int r = 0; r < n; ++r) {
+            paths.append(m_model->item(m_filter->sourceRow(r)).filePath);
+            m_warming.insert(paths.last());
+        }
+        m_thumbLoader->request(paths);
     }
-    QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
-    f.close();
-    if (!doc.isArray()) {
-        DEBUG_LOG("Invalid JSON format, expected array");
-        return;
+    // 第一次加载完成后才补扫监视的文件夹：程序关闭期间的变化在后台发现后再应用
+    if (!m_watcherStarted) {
+        m_watcherStarted = true;
+        StartupProfile::mark("library loaded");
+        m_folderWatcher->load();
     }
+}
 
-    // Build list, but only include existing files
-    QJsonArray arr = doc.array();
-    for (const QJsonValue &v : arr) {
-        QJsonObject o = v.toObject();
-        QString path = o["path"].toString();
-        QFileInfo fi(path);
-        if (!fi.exists()) continue;
-        EmojiItem it;
-        it.filePath = path;
-        it.fileName = o["name"].toString();
-        it.thumbnail = QPixmap(path).scaled(180,180, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        it.createTime = QDateTime::fromString(o["time"].toString(), Qt::ISODate);
-        it.fileSize = static_cast<qint64>(o["size"].toDouble());
-        it.orderIndex = o["order"].toInt();
-        m_list.append(it);
-    }
-
-    // sort by orderIndex to restore original ordering
-    std::sort(m_list.begin(), m_list.end(), [](const EmojiItem &a, const EmojiItem &b){
-        return a.orderIndex < b.orderIndex;
-    });
-
-    DEBUG_LOG("Loaded" << m_list.size() << "items from JSON");
-    rebuildModelFromList();
+void MainWindow::onMissingFiles(const QStringList &paths)
+{
+    // 后台检查发现已不存在的文件：移出列表与内容索引，整批只写一条日志
+    QVector<int> rows;
+    QStringList removed;
+    for (const QString &path : paths) {
+        const int row = m_model->rowOfPath(path);
+        if (row < 0) continue;
+        const EmojiItem &it = m_model->item(row);
+        m_contentIndex->remove(it.filePath, it.fileSize, it.contentHash);
+        rows.append(row);
+        removed.append(path);
+    }
+    if (rows.isEmpty()) return;
+    m_model->removeRowSet(rows);
+    m_store->recordRemove(removed);
+    DEBUG_LOG("Removed" << removed.size() << "missing files from library");
 }
 
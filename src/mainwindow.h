@@ -4,18 +4,40 @@
 * 该文件功能大致描述：主窗口，负责 UI 布局、工具栏（导入/保存/删除/刷新/设置）、排序逻辑、JSON 持久化，以及连接列表视图发出的信号进行具体操作。
 * 该文件函数功能描述：
 *   - setupUI()：初始化主窗口UI，包括工具栏、列表视图、委托等
-*   - loadFromJson()/saveToJson()：JSON文件读写，持久化表情数据
-*   - onAddFiles()/onAddFolder()：批量导入文件和文件夹
+*   - openLibrary()：选择存储后端，优先使用 SqliteCatalog（带索引），否则使用 LibraryStore（JSON 快照 + 日志）
+*   - loadFromJson()：读取表情库（缩略图按需加载）；索引目录只同步读取第一页，其余页由 appendLibraryPage() 在空闲时追加
+*   - startLibraryPaging()：按给定的排序条件从索引目录重新读取第一页并开始翻页（加载时与尚未读完时排序）
+*   - onLibraryLoaded()：JSON 库在写线程中读完后显示；启动时主窗口构造不等待读取，启动图标空闲期间在后台完成
+*   - onLibraryReady()：第一页可以显示时调用：窗口尚未显示则为首屏的行预读缩略图（来自磁盘缓存），第一次加载后开始补扫监视的文件夹
+*   - onMissingFiles()：后台存在性检查发现已不存在的文件，移出表情库（读取时不再逐条 stat）
+*   - finishLibraryLoad()：需要整个库时（导入、写快照）把尚未读取的页一次追加完；后台读取未完成时改为同步读取
+*   - saveToJson()：收集元数据交给存储后端在后台整体重写（排序、手动保存、空闲、隐藏时）；其余修改只记录单条变更
+*   - onAddFiles()/onAddFolder()：批量导入文件和文件夹（提交到 ImportPipeline 多线程导入）；添加的文件夹交给 FolderWatcher 持续监视
+*   - onWalkFilesFound()/onWalkFinished()：添加文件夹时 DirectoryWalker 并行遍历（可递归、可按通配符包含/排除），边找边导入；
+*                                         遍历结束后以找到的文件为初始快照开始监视
+*   - onWatchedFolderChanged()：监视的文件夹有新增/修改/删除时分批应用：删除的移出表情库，新增的导入，修改的先移除再重新导入
+*   - onManageWatchedFolders()：工具栏"监视的文件夹"，选择一个停止监视（已导入的条目保留）
+*   - onToggleTrace()：Ctrl+Shift+T 开始/停止录制追踪（trace.h），停止时导出到主目录下的 emoji_trace_*.json
+*   - onImportBatch()/onImportProgress()/onImportFinished()：导入流水线回调，批量插入、状态栏进度、结束后汇总跳过的重复文件
+*   - onVisibleRowsChanged()/onThumbnailLoaded()：按视图可见范围按需加载缩略图，加载完成后回填模型
+*   - showEvent()/hideEvent()：窗口隐藏时暂停动图缩略图的共享时钟，显示时恢复；显示后网格的第一次绘制记入启动计时（StartupProfile）
+*   - appendEmojiItems()：导入流水线的 insert 阶段，把一批结果转换为 EmojiItem 追加到模型（跳过内容重复的文件），返回插入条数
 *   - onDeleteSelected()/onDeleteIndex()：删除选中的表情项
-*   - onPreview()：预览图片，支持单例非模态对话框，允许连续查看多张图片
+*   - onPreview()：预览图片，支持单例非模态对话框，允许连续查看多张图片（分块后台解码，可缩放平移）
+*   - onPreviewStep()：预览中按方向键/滚轮时，按视图当前顺序切换到上一张/下一张可读的图，网格的当前项随之移动
+*   - prefetchPreviewNeighbours()：按翻页方向预取前后各 PreviewPrefetchCount 张
 *   - onRenameIndex()：重命名表情项
 *   - onCopyPath()：复制文件路径到剪贴板
-*   - onItemClicked()：单击复制图片到剪贴板
-*   - onSortCriteriaChanged()/onSortOrderChanged()：处理排序逻辑
+*   - onItemClicked()：单击复制图片到剪贴板（EmojiMimeData：原始字节/文件 URL/图像按需生成，不预先解码）
+*   - onCopySelected()：Ctrl+C 复制所有选中项（文件 URL 列表）
+*   - onSortCriteriaChanged()/onSortOrderChanged()：处理排序逻辑（切换升降序为 O(1)；排序后延迟写一次快照）；
+*                                                  索引目录尚未读完时由目录按索引排序，只重新读第一页
 *   - onShowNamesToggled()：切换文件名显示/隐藏
-*   - onModelRowsMoved()：处理拖放排序后的数据同步
-*   - rebuildModelFromList()：根据内存数据重建模型
-* 与该文件相关联的其他文件：mainwindow.cpp, emojilistwidget.h, emojilistwidget.cpp, emojilistdelegate.h, emojilistdelegate.cpp, previewdialog.h, previewdialog.cpp, emoji_meta.h
+*   - onFilterTextChanged()：工具栏搜索框，经 EmojiFilterModel 过滤名称/路径（视图行号需经 sourceRow() 转换）；
+*                            尚未读完时不等待，之后追加的页由过滤代理增量匹配
+*   - onFindSimilar()/onClusterSimilar()：右键“查找相似”/工具栏“聚类相似”，按感知哈希找出近似重复的图，以固定结果集显示
+*   - ensurePerceptualHashes()/onPerceptualHashesReady()：旧条目没有感知哈希时先在后台补算，完成后写回并继续刚才的操作
+* 与该文件相关联的其他文件：mainwindow.cpp, emojilistwidget.h, emojilistwidget.cpp, emojilistmodel.h, emojilistmodel.cpp, emojifiltermodel.h, emojifiltermodel.cpp, emojilistdelegate.h, emojilistdelegate.cpp, previewdialog.h, previewdialog.cpp, importpipeline.h, importpipeline.cpp, thumbnailcache.h, thumbnailcache.cpp, thumbnailloader.h, thumbnailloader.cpp, framecache.h, framecache.cpp, imagecache.h, imagecache.cpp, emojimimedata.h, emojimimedata.cpp, animationclock.h, animationclock.cpp, contenthash.h, contenthash.cpp, perceptualhash.h, perceptualhash.cpp, similarityindex.h, folderwatcher.h, folderwatcher.cpp, directorywalker.h, directorywalker.cpp, missingfilescanner.h, missingfilescanner.cpp, startupprofile.h, startupprofile.cpp, trace.h, trace.cpp, librarystore.h, librarystore.cpp, librarybackend.h, sqlitecatalog.h, sqlitecatalog.cpp, emoji_meta.h
 */
 
 #ifndef MAINWINDOW_H
@@ -23,19 +45,37 @@
 
 #include <QMainWindow>
 #include <QToolBar>
-#include <QStandardItemModel>
 #include <QComboBox>
 #include <QAction>
 #include "emojilistwidget.h"
 #include "emojilistdelegate.h"
+#include "emojilistmodel.h"
+#include "emojifiltermodel.h"
 #include "emoji_meta.h"
+#include "importpipeline.h"
+#include "thumbnailcache.h"
+#include "thumbnailloader.h"
+#include "librarybackend.h"
+#include "perceptualhash.h"
+#include "directorywalker.h"
 #include <QStatusBar>
 #include <QMessageBox>  // 如果需要使用其他Qt类
 #include <QApplication>
 #include <QClipboard>
 #include <QImageReader>
+#include <QProgressBar>
+#include <QToolButton>
+#include <QTimer>
+#include <QLineEdit>
+#include <QSet>
 
 class PreviewDialog;  // 前置声明
+class ContentIndex;
+class FrameCache;
+class AnimationClock;
+class ImageCache;
+class FolderWatcher;
+class MissingFileScanner;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -45,36 +85,113 @@ public:
 private slots:
     void onAddFiles();
     void onAddFolder(); // UPGRADE: 批量导入文件夹
+    void onWatchedFolderChanged(const QStringList &added, const QStringList &changed, const QStringList &removed);
+    void onManageWatchedFolders();
+    void onToggleTrace();
+    void onWalkFilesFound(const FoundFileList &files);
+    void onWalkFinished(int files, int dirs, bool cancelled);
     void onSave();
     void onDeleteSelected();
     void onDeleteIndex(const QModelIndex &index);
     void onPreview(const QString &path);
+    void onPreviewStep(int delta);
     void onRenameIndex(const QModelIndex &index);
     void onCopyPath(const QString &path);
     void onItemClicked(const QModelIndex &index); // UPGRADE: 单击复制图片到剪贴板
+    void onCopySelected();
     void onSortCriteriaChanged(int idx);
     void onSortOrderChanged(int idx);
     void onShowNamesToggled(bool checked);
-    void onModelRowsMoved(const QModelIndex &parent, int start, int end, const QModelIndex &destination, int row);
+    void onImportBatch(const QList<ImportedEmoji> &batch);
+    void onImportProgress(int done, int total);
+    void onImportFinished(bool cancelled);
+    void onVisibleRowsChanged(int first, int last, int prefetchFirst, int prefetchLast);
+    void onThumbnailLoaded(const QString &path, const QImage &thumb);
+    void onFilterTextChanged(const QString &text);
+    void onFindSimilar(const QModelIndex &index);
+    void onClusterSimilar();
+    void onShowAll();
+    void onPerceptualHashProgress(int done, int total);
+    void onPerceptualHashesReady(const PerceptualHashList &hashes);
+    void onLibraryLoaded(const QVector<LibraryRecord> &records);
+    void onMissingFiles(const QStringList &paths);
 
     void closeEvent(QCloseEvent *event);
-private:
-    void setupUI();
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
     void loadFromJson();
     void saveToJson();
-    void appendEmojiItem(const QString &path, bool preserveOrder=false);
-    void rebuildModelFromList();
+private:
+    void setupUI();
+    LibraryBackend *openLibrary();
+    static LibraryRecord toRecord(const EmojiItem &item);
+    QVector<EmojiItem> itemsFromRecords(const QVector<LibraryRecord> &records);  // 同时登记内容哈希，并提交存在性检查
+    void onLibraryReady();
+    void startLibraryPaging(LibraryQuery::SortKey key, Qt::SortOrder order);
+    void appendLibraryPage(int limit);
+    void finishLibraryLoad();
+    int appendEmojiItems(const QList<ImportedEmoji> &batch);  // 导入流水线的 insert 阶段
+    bool ensurePerceptualHashes();  // 全部条目都有感知哈希时返回 true，否则启动后台补算
+    void showSimilar(const QString &path);
+    void showClusters();
+    int previewRow() const;  // 当前预览的图在视图（过滤代理）中的行号，不在视图中返回 -1
+    void prefetchPreviewNeighbours();
     EmojiListWidget *m_view;
-    QStandardItemModel *m_model;
-    QList<EmojiItem> m_list;
+    EmojiListModel *m_model;     // 唯一的数据存储（取代 m_list + QStandardItemModel）
+    EmojiFilterModel *m_filter;  // 搜索过滤代理（视图的模型）
     QString m_jsonFile;
     // UI controls
     QComboBox *m_sortCombo;     // 排序依据
     QComboBox *m_orderCombo;    // 升序/降序
     QAction *m_showNamesAct;    // 切换显示文件名
-    bool m_showNames = false;   // 默认隐藏文件名
+    QLineEdit *m_filterEdit;    // 搜索框
+    QAction *m_showAllAct;      // 退出查找相似/聚类的固定结果集
     
     PreviewDialog *m_previewDialog = nullptr;  // 【新增】：保持单例预览对话框
+    static const int PreviewPrefetchCount = 3;
+    QString m_previewPath;                     // 预览中的图片
+    int m_previewDirection = 1;                // 最近一次翻页方向，先预取这一侧
+
+    ImportPipeline *m_importer;          // 多线程导入流水线
+    QProgressBar *m_importProgress;      // 状态栏导入进度
+    QToolButton *m_importCancelBtn;      // 状态栏取消导入按钮
+    int m_importedCount = 0;             // 本次导入实际插入的条数
+    int m_duplicateCount = 0;            // 本次导入跳过的重复文件数与字节数
+    qint64 m_duplicateBytes = 0;
+    QSharedPointer<ThumbnailCache> m_thumbCache;  // 持久化缩略图缓存（与导入线程共享）
+    QSharedPointer<ContentIndex> m_contentIndex;  // 内容哈希 → 文件（与导入线程共享）
+    ThumbnailLoader *m_thumbLoader;      // 可见行按需加载缩略图
+    PerceptualHashJob *m_phashJob;       // 为旧条目补算感知哈希
+    FrameCache *m_frameCache;            // 动图缩略图的帧缓存（全局一份）
+    AnimationClock *m_animClock;         // 所有动图共用的时钟
+    ImageCache *m_imageCache;            // 原图解码缓存（复制到剪贴板与拖出的图像、预览、悬停预热）
+    FolderWatcher *m_folderWatcher;      // 导入过的文件夹：监视变化并增量重新扫描
+    DirectoryWalker *m_walker;           // 添加文件夹时的并行目录遍历
+    MissingFileScanner *m_missingScanner; // 读取表情库后在后台检查文件是否还在
+    QString m_walkRoot;                  // 正在遍历的文件夹与选项，遍历结束后交给 m_folderWatcher
+    WalkOptions m_walkOptions;
+    FoundFileList m_walkBaseline;        // 遍历找到的文件（初始监视快照）
+    bool m_importSummaryPending = false; // 导入队列在遍历结束前排空，汇总推迟到遍历结束
+    QStringList m_phashRequested;        // 本次补算提交的文件
+    QSet<QString> m_phashFailed;         // 无法解码、补算不出感知哈希的文件（不再重试）
+    QString m_similarPending;            // 补算完成后要继续的操作：查找与该文件相似的图 / 聚类
+    bool m_clusterPending = false;
+    QPixmap m_invalidPixmap;             // 无法解码时的占位图（只加载一次）
+    LibraryBackend *m_store;             // 表情库存储（SQLite 目录或 JSON 快照 + 日志）
+    QTimer *m_pageTimer;                 // 索引目录分页追加
+    bool m_paging = false;               // 是否还有未读取的页
+    int m_pageAfter = -1;                // 已读取的最后一条的 order（按持久化顺序翻页的游标）
+    LibraryQuery::SortKey m_pageSortKey = LibraryQuery::ByOrder;  // 翻页使用的排序条件
+    Qt::SortOrder m_pageSortOrder = Qt::AscendingOrder;
+    static const int FirstPageSize = 1000;
+    static const int PageSize = 5000;
+    bool m_loadPending = false;          // JSON 库正在写线程中读取
+    bool m_watcherStarted = false;       // 第一次加载完成后才开始补扫监视的文件夹
+    QSet<QString> m_warming;             // 启动时预读缩略图的首屏条目（全部就绪时记入启动计时）
+    static const int WarmRows = 60;      // 预读的行数：默认窗口大小下首屏约 20 个，其余相当于向下的预取窗口
+    QTimer *m_orderSaveTimer;            // 排序后延迟写快照
+    bool m_orderSaveAfterLoad = false;   // 尚未读完时排序：读完后再写新的排序键
+    static const int OrderSaveDelayMs = 1000;
 
 signals:
     void windowHidden();
@@ -0,0 +1,71 @@
+#include "missingfilescanner.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+
+#include <QRunnable>
+#include <QFileInfo>
+#include <QThread>
+
+namespace {
+
+class CheckTask : public QRunnable {
+public:
+    CheckTask(MissingFileScanner *scanner, const QSharedPointer<QAtomicInt> &cancelled, int generation,
+              const QStringList &paths)
+        : m_scanner(scanner), m_cancelled(cancelled), m_generation(generation), m_paths(paths) {}
+
+    void run() override
+    {
+        if (m_cancelled->loadAcquire()) return;
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+        QStringList missing;
+        for (const QString &p : qAsConst(m_paths)) {
+            if (!QFileInfo::exists(p)) missing.append(p);
+        }
+        // scanner 析构时会等待线程池，因此这里的指针在任务运行期间一直有效
+        QMetaObject::invokeMethod(m_scanner, "onChunkChecked", Qt::QueuedConnection,
+                                  Q_ARG(int, m_generation), Q_ARG(QStringList, missing));
+    }
+
+private:
+    MissingFileScanner *m_scanner;
+    QSharedPointer<QAtomicInt> m_cancelled;
+    int m_generation;
+    QStringList m_paths;
+};
+
+} // namespace
+
+MissingFileScanner::MissingFileScanner(QObject *parent)
+    : QObject(parent),
+      m_cancelled(new QAtomicInt(0))
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+MissingFileScanner::~MissingFileScanner()
+{
+    clear();
+    m_pool.waitForDone();
+}
+
+void MissingFileScanner::check(const QStringList &paths)
+{
+    for (int i = 0; i < paths.size(); i += ChunkSize) {
+        m_pool.start(new CheckTask(this, m_cancelled, m_generation, paths.mid(i, ChunkSize)));
+    }
+}
+
+void MissingFileScanner::clear()
+{
+    m_cancelled->storeRelease(1);
+    m_pool.clear();
+    m_cancelled.reset(new QAtomicInt(0));
+    ++m_generation;
+}
+
+void MissingFileScanner::onChunkChecked(int generation, const QStringList &paths)
+{
+    if (generation != m_generation || paths.isEmpty()) return;
+    DEBUG_LOG("Missing files found:" << paths.size());
+    emit missing(paths);
+}
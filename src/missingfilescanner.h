@@ -0,0 +1,45 @@
+/*
+* 文件名：missingfilescanner.h
+* 日期：2026-10-16
+* 该文件功能大致描述：延后的文件存在性检查。读取表情库时不再逐条 stat（冷启动时每个文件一次磁盘访问），
+*                    条目先显示出来，随后在低优先级的后台线程中按 ChunkSize 分块检查，已不存在的路径分批回传给 MainWindow 移出表情库。
+* 该文件函数功能描述：
+*   - check()：追加一批待检查的路径（分页读取时每页调用一次）
+*   - clear()：取消尚未完成的检查（重新加载表情库时使用）
+*   - missing()：信号，一块中已不存在的文件
+* 与该文件相关联的其他文件：missingfilescanner.cpp, mainwindow.h, mainwindow.cpp
+*/
+
+#ifndef MISSINGFILESCANNER_H
+#define MISSINGFILESCANNER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QAtomicInt>
+
+class MissingFileScanner : public QObject {
+    Q_OBJECT
+public:
+    static const int ChunkSize = 1000;  // 每块检查的路径数，也是取消的粒度
+
+    explicit MissingFileScanner(QObject *parent = nullptr);
+    ~MissingFileScanner() override;
+
+    void check(const QStringList &paths);
+    void clear();
+
+signals:
+    void missing(const QStringList &paths);
+
+private slots:
+    void onChunkChecked(int generation, const QStringList &paths);
+
+private:
+    QThreadPool m_pool;                      // 单线程：不与缩略图加载争抢磁盘
+    QSharedPointer<QAtomicInt> m_cancelled;  // 当前这一代任务的取消标记
+    int m_generation = 0;
+};
+
+#endif // MISSINGFILESCANNER_H
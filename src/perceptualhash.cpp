@@ -0,0 +1,150 @@
+#include "perceptualhash.h"
+#include "importpipeline.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+
+#include <QRunnable>
+#include <QFileInfo>
+#include <QThread>
+#include <QPainter>
+#include <algorithm>
+
+namespace {
+
+const int kCols = 9;  // 9 列比较出 8 个差值
+const int kRows = 8;
+
+class HashChunkTask : public QRunnable {
+public:
+    HashChunkTask(QObject *receiver, int generation, const QSharedPointer<QAtomicInt> &cancelled,
+                  const QSharedPointer<ThumbnailCache> &cache, const QStringList &paths)
+        : m_receiver(receiver), m_generation(generation), m_cancelled(cancelled), m_cache(cache), m_paths(paths) {}
+
+    void run() override
+    {
+        PerceptualHashList out;
+        out.reserve(m_paths.size());
+        for (const QString &path : m_paths) {
+            if (m_cancelled->loadAcquire()) break;
+            // 缩略图多半已在磁盘缓存中，不必重新解码原图
+            const QImage thumb = ImportPipeline::makeThumbnail(QFileInfo(path), m_cache.data());
+            bool ok = false;
+            const quint64 h = PerceptualHash::dHash(thumb, &ok);
+            if (ok) out.append(qMakePair(path, h));
+        }
+        // 即使被取消也回传（可能为空），接收方据此统计进度
+        QMetaObject::invokeMethod(m_receiver, "onChunkDone", Qt::QueuedConnection,
+                                  Q_ARG(int, m_generation), Q_ARG(PerceptualHashList, out));
+    }
+
+private:
+    QObject *m_receiver;
+    int m_generation;
+    QSharedPointer<QAtomicInt> m_cancelled;
+    QSharedPointer<ThumbnailCache> m_cache;
+    QStringList m_paths;
+};
+
+} // namespace
+
+quint64 PerceptualHash::dHash(const QImage &image, bool *ok)
+{
+    if (ok) *ok = false;
+    if (image.isNull()) return 0;
+    // 透明背景按白色处理，灰度转换由 Qt 内部的 SIMD 路径完成
+    QImage src = image;
+    if (src.hasAlphaChannel()) {
+        QImage flat(src.size(), QImage::Format_RGB32);
+        flat.fill(Qt::white);
+        QPainter(&flat).drawImage(0, 0, src);
+        src = flat;
+    }
+    const QImage gray = src.convertToFormat(QImage::Format_Grayscale8);
+    const int w = gray.width(), h = gray.height();
+    if (w < kCols || h < kRows) {
+        // 极小的图：直接缩放到 9×8
+        return dHash(src.scaled(kCols * 2, kRows * 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation), ok);
+    }
+
+    // 按行带累加：内层是对连续内存的整数加法，编译器可自动向量化
+    QVector<quint32> acc(w);
+    quint32 cells[kRows][kCols];
+    for (int ry = 0; ry < kRows; ++ry) {
+        const int y0 = ry * h / kRows, y1 = (ry + 1) * h / kRows;
+        std::fill(acc.begin(), acc.end(), 0u);
+        quint32 *a = acc.data();
+        for (int y = y0; y < y1; ++y) {
+            const uchar *line = gray.constScanLine(y);
+            for (int x = 0; x < w; ++x) a[x] += line[x];
+        }
+        for (int cx = 0; cx < kCols; ++cx) {
+            const int x0 = cx * w / kCols, x1 = (cx + 1) * w / kCols;
+            quint32 sum = 0;
+            for (int x = x0; x < x1; ++x) sum += a[x];
+            // 各列宽度可能差 1 像素：按面积归一化后再比较
+            cells[ry][cx] = sum * 16 / quint32(qMax(1, (x1 - x0) * (y1 - y0)));
+        }
+    }
+
+    quint64 bits = 0;
+    for (int ry = 0; ry < kRows; ++ry) {
+        for (int cx = 0; cx < kCols - 1; ++cx) {
+            bits = (bits << 1) | (cells[ry][cx] > cells[ry][cx + 1] ? 1u : 0u);
+        }
+    }
+    if (ok) *ok = true;
+    return bits;
+}
+
+PerceptualHashJob::PerceptualHashJob(QObject *parent)
+    : QObject(parent),
+      m_cancelled(new QAtomicInt(0))
+{
+    qRegisterMetaType<PerceptualHashList>("PerceptualHashList");
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+PerceptualHashJob::~PerceptualHashJob()
+{
+    m_cancelled->storeRelease(1);
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void PerceptualHashJob::start(const QStringList &paths)
+{
+    if (isRunning() || paths.isEmpty()) return;
+    m_cancelled.reset(new QAtomicInt(0));
+    ++m_generation;
+    m_results.clear();
+    m_results.reserve(paths.size());
+    m_total = paths.size();
+    m_done = 0;
+    DEBUG_LOG("Perceptual hash backfill:" << m_total << "files");
+    for (int i = 0; i < paths.size(); i += ChunkSize) {
+        m_pool.start(new HashChunkTask(this, m_generation, m_cancelled, m_cache, paths.mid(i, ChunkSize)));
+    }
+    emit progress(0, m_total);
+}
+
+void PerceptualHashJob::cancel()
+{
+    if (!isRunning()) return;
+    m_cancelled->storeRelease(1);
+    m_pool.clear();  // 未开始的块直接丢弃；已排队的回传按代数忽略
+    m_pool.waitForDone();
+    m_total = 0;
+    m_results.clear();
+}
+
+void PerceptualHashJob::onChunkDone(int generation, const PerceptualHashList &chunk)
+{
+    if (generation != m_generation || !isRunning()) return;  // 已取消的旧任务
+    m_results += chunk;
+    m_done = qMin(m_total, m_done + ChunkSize);
+    emit progress(m_done, m_total);
+    if (m_done < m_total) return;
+    PerceptualHashList results;
+    results.swap(m_results);
+    m_total = 0;
+    emit finished(results);
+}
@@ -0,0 +1,69 @@
+/*
+* 文件名：perceptualhash.h
+* 日期：2026-10-16
+* 该文件功能大致描述：感知哈希（dHash）。从已经生成的缩略图计算 64 位 dHash：先转为 8 位灰度（Qt 的 SIMD 转换），
+*                    再以整数按行累加、按列分段求和缩小为 9×8，比较相邻像素得到 64 位；两个哈希的汉明距离用 popcount 计算。
+*                    重新编码、缩放过的同一张图汉明距离很小。另提供后台补算任务，为没有感知哈希的旧条目批量计算。
+* 该文件函数功能描述：
+*   - PerceptualHash::dHash()：由缩略图计算 dHash，图像为空时 ok 为 false
+*   - PerceptualHash::distance()：汉明距离
+*   - PerceptualHashJob：在私有线程池中分块补算（先查缩略图磁盘缓存），progress()/finished() 回报进度与结果
+* 与该文件相关联的其他文件：perceptualhash.cpp, similarityindex.h, importpipeline.cpp, mainwindow.cpp, thumbnailcache.h
+*/
+
+#ifndef PERCEPTUALHASH_H
+#define PERCEPTUALHASH_H
+
+#include <QObject>
+#include <QImage>
+#include <QVector>
+#include <QPair>
+#include <QStringList>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QtAlgorithms>
+
+class ThumbnailCache;
+
+typedef QVector<QPair<QString, quint64>> PerceptualHashList;  // 路径 → dHash
+
+class PerceptualHash {
+public:
+    static quint64 dHash(const QImage &image, bool *ok = nullptr);
+    static int distance(quint64 a, quint64 b) { return int(qPopulationCount(a ^ b)); }
+};
+
+class PerceptualHashJob : public QObject {
+    Q_OBJECT
+public:
+    explicit PerceptualHashJob(QObject *parent = nullptr);
+    ~PerceptualHashJob() override;
+
+    void setThumbnailCache(const QSharedPointer<ThumbnailCache> &cache) { m_cache = cache; }
+    void start(const QStringList &paths);
+    void cancel();
+    bool isRunning() const { return m_total > 0; }
+
+    static const int ChunkSize = 256;  // 每个任务处理的文件数，结果按块回传
+
+signals:
+    void progress(int done, int total);
+    void finished(const PerceptualHashList &results);
+
+private slots:
+    void onChunkDone(int generation, const PerceptualHashList &chunk);
+
+private:
+    QThreadPool m_pool;
+    QSharedPointer<ThumbnailCache> m_cache;
+    QSharedPointer<QAtomicInt> m_cancelled;
+    PerceptualHashList m_results;
+    int m_total = 0;
+    int m_done = 0;
+    int m_generation = 0;  // 每次 start() 递增，用于忽略已取消任务的回传
+};
+
+Q_DECLARE_METATYPE(PerceptualHashList)
+
+#endif // PERCEPTUALHASH_H
@@ -2,21 +2,20 @@
 #include <QVBoxLayout>
 #include <QGraphicsOpacityEffect>
 #include <QMouseEvent>
+#include <QKeyEvent>
+#include <QWheelEvent>
 
 PreviewDialog::PreviewDialog(QWidget *parent)
     : QDialog(parent),
-      m_imageLabel(new QLabel(this)),
+      m_imageView(new TiledImageView(this)),
       m_opacityAnim(new QPropertyAnimation(this))
 {
     setWindowFlags(Qt::Dialog | Qt::FramelessWindowHint);
     setAttribute(Qt::WA_TranslucentBackground);
     setModal(false);  // 【修改】：设置为非模态，允许在预览时点击其他图片
 
-    m_imageLabel->setAlignment(Qt::AlignCenter);
-    m_imageLabel->setScaledContents(false);
-
     QVBoxLayout *lay = new QVBoxLayout(this);
-    lay->addWidget(m_imageLabel);
+    lay->addWidget(m_imageView);
     lay->setContentsMargins(12,12,12,12);
     setLayout(lay);
     resize(640, 480);
@@ -32,15 +31,15 @@ PreviewDialog::PreviewDialog(QWidget *parent)
     m_opacityAnim->setEasingCurve(QEasingCurve::InOutCubic);
 }
 
-void PreviewDialog::setImage(const QPixmap &pixmap)
+void PreviewDialog::setImagePath(const QString &path, bool animate)
 {
-    if (pixmap.isNull()) {
+    if (path.isEmpty()) {
         // 【修改】：移除错误提示，在上层处理无效图片
         return;
     }
-    QPixmap scaled = pixmap.scaled(size()*0.9, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    m_imageLabel->setPixmap(scaled);
-    startShowAnimation();
+    // 不在界面线程解码：视图只读文件头，总览图与各块在后台生成
+    m_imageView->setImagePath(path);
+    if (animate) startShowAnimation();
     // 【修改】：不在这里调用 show()，由调用者控制
 }
 
@@ -54,3 +53,37 @@ void PreviewDialog::mouseDoubleClickEvent(QMouseEvent * /*event*/)
     // UPGRADE: 双击预览框关闭（第二次双击）
     close();
 }
+
+void PreviewDialog::keyPressEvent(QKeyEvent *event)
+{
+    switch (event->key()) {
+    case Qt::Key_Left:
+    case Qt::Key_Up:
+    case Qt::Key_PageUp:
+        emit stepRequested(-1);
+        break;
+    case Qt::Key_Right:
+    case Qt::Key_Down:
+    case Qt::Key_PageDown:
+    case Qt::Key_Space:
+        emit stepRequested(1);
+        break;
+    default:
+        QDialog::keyPressEvent(event);  // Esc 关闭等默认行为
+    }
+}
+
+void PreviewDialog::wheelEvent(QWheelEvent *event)
+{
+    // 视图只处理 Ctrl+滚轮缩放，普通滚轮冒泡到这里翻页：向下滚为下一张
+    m_wheelAccum += event->angleDelta().y();
+    while (m_wheelAccum <= -120) {
+        m_wheelAccum += 120;
+        emit stepRequested(1);
+    }
+    while (m_wheelAccum >= 120) {
+        m_wheelAccum -= 120;
+        emit stepRequested(-1);
+    }
+    event->accept();
+}
@@ -2,35 +2,47 @@
 * 文件名：previewdialog.h
 * 日期：2025-10-21
 * 该文件功能大致描述：预览对话框类，支持淡入动画、双击关闭、非模态显示，允许连续预览多张图片。
+*                    图片由 TiledImageView 分块显示：后台解码，先显示低分辨率总览再逐块变清晰，支持 Ctrl+滚轮缩放与拖动平移。
+*                    方向键/PageUp/PageDown/滚轮按主窗口当前的排列顺序切换上一张、下一张；相邻的图在后台预取。
 * 该文件函数功能描述：
 *   - PreviewDialog()：构造函数，初始化非模态、无边框、半透明对话框
-*   - setImage()：设置并显示预览图片，带淡入动画效果
+*   - setImagePath()：切换预览的图片（解码全部在后台进行，界面线程不解码原图），可选淡入动画效果（翻页时不播放）
+*   - prefetch()：后台预取相邻图片，翻到时立即显示
+*   - setImageCache()：解码结果放进 MainWindow 共享的 ImageCache
+*   - keyPressEvent()/wheelEvent()：方向键与滚轮翻页，发出 stepRequested(±1)，由 MainWindow 决定下一张
 *   - mouseDoubleClickEvent()：双击关闭预览对话框
 *   - startShowAnimation()：启动透明度淡入动画
-* 与该文件相关联的其他文件：previewdialog.cpp, mainwindow.h, mainwindow.cpp
+* 与该文件相关联的其他文件：previewdialog.cpp, tiledimageview.h, tiledimageview.cpp, mainwindow.h, mainwindow.cpp
 */
 
 #ifndef PREVIEWDIALOG_H
 #define PREVIEWDIALOG_H
 
 #include <QDialog>
-#include <QLabel>
 #include <QPropertyAnimation>
-#include <QPixmap>
+#include "tiledimageview.h"
 
 class PreviewDialog : public QDialog {
     Q_OBJECT
 public:
     explicit PreviewDialog(QWidget *parent = nullptr);
     // 显示图片，如果已经显示则切换行为由调用者控制（这里实现双击关闭）
-    void setImage(const QPixmap &pixmap);
+    void setImagePath(const QString &path, bool animate = true);
+    void prefetch(const QStringList &paths) { m_imageView->prefetch(paths); }
+    void setImageCache(ImageCache *images) { m_imageView->setImageCache(images); }
+
+signals:
+    void stepRequested(int delta);  // -1 上一张，+1 下一张
 
 protected:
     void mouseDoubleClickEvent(QMouseEvent *event) override; // 双击关闭
+    void keyPressEvent(QKeyEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
 
 private:
-    QLabel *m_imageLabel;
+    TiledImageView *m_imageView;
     QPropertyAnimation *m_opacityAnim;
+    int m_wheelAccum = 0;  // 触控板的细小滚动累计满一格才翻页
     void startShowAnimation();
 };
 
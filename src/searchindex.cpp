@@ -0,0 +1,153 @@
+#include "searchindex.h"
+
+#include <algorithm>
+
+namespace {
+
+inline quint64 trigram(const QChar *p)
+{
+    return (quint64(p[0].unicode()) << 32) | (quint64(p[1].unicode()) << 16) | quint64(p[2].unicode());
+}
+
+inline bool hasSeparator(const QString &s)
+{
+    return s.contains('/') || s.contains('\\');
+}
+
+} // namespace
+
+void SearchIndex::clear()
+{
+    m_entries.clear();
+    m_postings.clear();
+    m_dirIds.clear();
+    m_dirs.clear();
+    m_dirSlots.clear();
+    m_stale = 0;
+    m_live = 0;
+}
+
+void SearchIndex::indexText(int slot, const QString &text) const
+{
+    const QChar *p = text.constData();
+    for (int i = 0; i + 3 <= text.size(); ++i) {
+        QVector<int> &list = m_postings[trigram(p + i)];
+        if (list.isEmpty() || list.last() != slot) list.append(slot);  // 同一文本内的重复三元组大多相邻
+    }
+}
+
+void SearchIndex::setItem(int slot, const QString &name, const QString &path)
+{
+    if (slot >= m_entries.size()) m_entries.resize(slot + 1);
+    Entry &e = m_entries[slot];
+    if (e.live) removeItem(slot);
+
+    const QString folded = fold(path);
+    const int cut = folded.lastIndexOf('/');
+    const QString dir = cut >= 0 ? folded.left(cut) : QString();
+    auto it = m_dirIds.constFind(dir);
+    if (it == m_dirIds.constEnd()) {
+        it = m_dirIds.insert(dir, m_dirs.size());
+        m_dirs.append(dir);
+        m_dirSlots.append(QVector<int>());
+    }
+
+    e.name = fold(name);
+    e.base = folded.mid(cut + 1);
+    e.dir = it.value();
+    e.live = true;
+    ++m_live;
+    m_dirSlots[e.dir].append(slot);
+    indexText(slot, e.name);
+    if (e.base != e.name) indexText(slot, e.base);
+}
+
+void SearchIndex::removeItem(int slot)
+{
+    if (slot < 0 || slot >= m_entries.size() || !m_entries.at(slot).live) return;
+    Entry &e = m_entries[slot];
+    m_stale += e.name.size() + e.base.size() + 1;  // 倒排项留到查询时剔除
+    e = Entry();
+    --m_live;
+}
+
+void SearchIndex::renameItem(int slot, const QString &name)
+{
+    if (slot < 0 || slot >= m_entries.size() || !m_entries.at(slot).live) return;
+    Entry &e = m_entries[slot];
+    m_stale += e.name.size();
+    e.name = fold(name);
+    indexText(slot, e.name);
+}
+
+void SearchIndex::rebuild() const
+{
+    // 过期项超过有效项时整体重建；只在查询时触发，代价分摊到很多次增删之后
+    m_postings.clear();
+    for (QVector<int> &list : m_dirSlots) list.clear();
+    for (int slot = 0; slot < m_entries.size(); ++slot) {
+        const Entry &e = m_entries.at(slot);
+        if (!e.live) continue;
+        m_dirSlots[e.dir].append(slot);
+        indexText(slot, e.name);
+        if (e.base != e.name) indexText(slot, e.base);
+    }
+    m_stale = 0;
+}
+
+bool SearchIndex::dirMatches(int dir, const QString &folded) const
+{
+    return dir >= 0 && m_dirs.at(dir).contains(folded);
+}
+
+bool SearchIndex::matches(int slot, const QString &folded) const
+{
+    if (slot < 0 || slot >= m_entries.size()) return false;
+    const Entry &e = m_entries.at(slot);
+    if (!e.live) return false;
+    if (e.name.contains(folded) || e.base.contains(folded) || dirMatches(e.dir, folded)) return true;
+    // 跨越文件夹与文件名的查询（含分隔符）才需要拼出完整路径
+    return hasSeparator(folded) && (m_dirs.at(e.dir) + '/' + e.base).contains(folded);
+}
+
+QVector<int> SearchIndex::search(const QString &folded) const
+{
+    QVector<int> out;
+    if (folded.isEmpty()) return out;
+    if (m_stale > m_live * 8 + 1024) rebuild();
+
+    QVector<bool> seen(m_entries.size(), false);
+    auto take = [&](int slot) {
+        if (!seen.at(slot) && matches(slot, folded)) {
+            seen[slot] = true;
+            out.append(slot);
+        }
+    };
+
+    if (folded.size() < 3 || hasSeparator(folded)) {
+        // 太短无法使用三元组，或跨越路径分隔符：逐条校验（只比较预先折叠好的字符串）
+        for (int slot = 0; slot < m_entries.size(); ++slot) take(slot);
+        return out;
+    }
+
+    // 候选：查询中最稀有的三元组对应的倒排表
+    const QVector<int> *best = nullptr;
+    const QChar *p = folded.constData();
+    for (int i = 0; i + 3 <= folded.size(); ++i) {
+        auto it = m_postings.constFind(trigram(p + i));
+        if (it == m_postings.constEnd()) { best = nullptr; break; }
+        if (!best || it.value().size() < best->size()) best = &it.value();
+    }
+    if (best) {
+        for (int slot : *best) take(slot);
+    }
+
+    // 文件夹路径：不同文件夹的数量远少于条目数，逐个比较
+    for (int dir = 0; dir < m_dirs.size(); ++dir) {
+        if (!m_dirs.at(dir).contains(folded)) continue;
+        for (int slot : m_dirSlots.at(dir)) {
+            if (m_entries.at(slot).dir == dir) take(slot);
+        }
+    }
+    return out;
+}
@@ -0,0 +1,54 @@
+/*
+* 文件名：searchindex.h
+* 日期：2026-10-16
+* 该文件功能大致描述：表情名称/路径的内存搜索索引（按稳定槽位号）。显示名与文件名建立三元组（trigram）倒排表，
+*                    文件夹路径单独成表（同一文件夹下的条目共用一条），不区分大小写的子串查询先取最短的倒排表作为候选，
+*                    再逐个校验。增删改名都是增量更新：删除/改名只留下过期的倒排项，查询时校验剔除，过期项过多时整体重建。
+* 该文件函数功能描述：
+*   - setItem()/removeItem()/renameItem()：条目加入、删除、改显示名
+*   - search()：返回匹配查询的所有槽位（无序）
+*   - matches()：单个槽位是否匹配（用于在上一次结果上继续缩小范围）
+*   - fold()：查询与索引统一使用的大小写折叠
+* 与该文件相关联的其他文件：searchindex.cpp, emojilistmodel.h, emojilistmodel.cpp, emojifiltermodel.cpp
+*/
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QVector>
+#include <QString>
+#include <QHash>
+
+class SearchIndex {
+public:
+    void clear();
+    void setItem(int slot, const QString &name, const QString &path);
+    void removeItem(int slot);
+    void renameItem(int slot, const QString &name);
+
+    QVector<int> search(const QString &folded) const;
+    bool matches(int slot, const QString &folded) const;
+    static QString fold(const QString &text) { return text.toCaseFolded(); }
+
+private:
+    struct Entry {
+        QString name;   // 折叠后的显示名
+        QString base;   // 折叠后的文件名
+        int dir = -1;   // 所在文件夹编号
+        bool live = false;
+    };
+
+    void indexText(int slot, const QString &text) const;
+    void rebuild() const;
+    bool dirMatches(int dir, const QString &folded) const;
+
+    QVector<Entry> m_entries;
+    mutable QHash<quint64, QVector<int>> m_postings;  // 三元组 → 槽位（可能含过期项）
+    QHash<QString, int> m_dirIds;
+    QVector<QString> m_dirs;                           // 折叠后的文件夹路径
+    mutable QVector<QVector<int>> m_dirSlots;          // 文件夹 → 槽位（可能含过期项）
+    mutable int m_stale = 0;                           // 过期倒排项的粗略计数
+    int m_live = 0;
+};
+
+#endif // SEARCHINDEX_H
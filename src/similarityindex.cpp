@@ -0,0 +1,153 @@
+#include "similarityindex.h"
+#include "perceptualhash.h"
+
+#include <algorithm>
+#include <numeric>
+
+void SimilarityIndex::clear()
+{
+    m_nodes.clear();
+    m_nodeOf.clear();
+    m_emptyNodes = 0;
+}
+
+void SimilarityIndex::insert(int id, quint64 hash)
+{
+    if (m_nodeOf.contains(id)) remove(id);
+    if (m_nodes.isEmpty()) {
+        m_nodes.append(Node());
+        m_nodes[0].hash = hash;
+        m_nodes[0].ids.append(id);
+        m_nodeOf.insert(id, 0);
+        return;
+    }
+    int cur = 0;
+    for (;;) {
+        const int d = PerceptualHash::distance(hash, m_nodes.at(cur).hash);
+        if (d == 0) {
+            if (m_nodes.at(cur).ids.isEmpty()) --m_emptyNodes;
+            m_nodes[cur].ids.append(id);
+            m_nodeOf.insert(id, cur);
+            return;
+        }
+        int next = -1;
+        for (const QPair<int, int> &c : m_nodes.at(cur).children) {
+            if (c.first == d) { next = c.second; break; }
+        }
+        if (next < 0) {
+            Node node;
+            node.hash = hash;
+            node.ids.append(id);
+            m_nodes.append(node);  // 先追加再取下标：append 可能使引用失效
+            const int idx = m_nodes.size() - 1;
+            m_nodes[cur].children.append(qMakePair(d, idx));
+            m_nodeOf.insert(id, idx);
+            return;
+        }
+        cur = next;
+    }
+}
+
+void SimilarityIndex::remove(int id)
+{
+    auto it = m_nodeOf.find(id);
+    if (it == m_nodeOf.end()) return;
+    Node &node = m_nodes[it.value()];
+    node.ids.removeOne(id);
+    if (node.ids.isEmpty()) ++m_emptyNodes;  // 空节点仍用于路由
+    m_nodeOf.erase(it);
+    if (m_emptyNodes > m_nodeOf.size() + 64) rebuild();
+}
+
+void SimilarityIndex::rebuild()
+{
+    QVector<Node> old;
+    old.swap(m_nodes);
+    clear();
+    for (const Node &node : old) {
+        for (int id : node.ids) insert(id, node.hash);
+    }
+}
+
+QVector<SimilarityIndex::Match> SimilarityIndex::findSimilar(quint64 hash, int radius) const
+{
+    QVector<Match> out;
+    if (m_nodes.isEmpty()) return out;
+    QVector<int> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const Node &node = m_nodes.at(stack.takeLast());
+        const int d = PerceptualHash::distance(hash, node.hash);
+        if (d <= radius) {
+            for (int id : node.ids) out.append(Match{id, d});
+        }
+        // 三角不等式：只有与本节点距离在 [d - r, d + r] 内的子树可能包含结果
+        for (const QPair<int, int> &c : node.children) {
+            if (c.first >= d - radius && c.first <= d + radius) stack.append(c.second);
+        }
+    }
+    std::stable_sort(out.begin(), out.end(), [](const Match &a, const Match &b) { return a.distance < b.distance; });
+    return out;
+}
+
+namespace {
+
+int findRoot(QVector<int> &parent, int x)
+{
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];  // 路径减半
+        x = parent[x];
+    }
+    return x;
+}
+
+} // namespace
+
+QVector<QVector<int>> SimilarityIndex::clusters(int radius) const
+{
+    // 只处理有条目的节点：完全相同的哈希已经在同一节点中
+    QVector<int> nodes;
+    for (int i = 0; i < m_nodes.size(); ++i) {
+        if (!m_nodes.at(i).ids.isEmpty()) nodes.append(i);
+    }
+    const int n = nodes.size();
+    QVector<int> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+
+    // 多索引哈希：64 位分成 radius+1 段，逐段按段值排序，只比较段值相同的候选对
+    const int chunks = qBound(1, radius + 1, 64);
+    QVector<QPair<quint64, int>> keyed(n);
+    for (int c = 0; c < chunks; ++c) {
+        const int lo = c * 64 / chunks, hi = (c + 1) * 64 / chunks;
+        const quint64 mask = (hi - lo == 64) ? ~quint64(0) : ((quint64(1) << (hi - lo)) - 1);
+        for (int i = 0; i < n; ++i) {
+            keyed[i] = qMakePair((m_nodes.at(nodes.at(i)).hash >> lo) & mask, i);
+        }
+        std::sort(keyed.begin(), keyed.end());
+        for (int run = 0; run < n;) {
+            int end = run + 1;
+            while (end < n && keyed.at(end).first == keyed.at(run).first) ++end;
+            for (int a = run; a < end; ++a) {
+                const quint64 ha = m_nodes.at(nodes.at(keyed.at(a).second)).hash;
+                for (int b = a + 1; b < end; ++b) {
+                    const int ia = keyed.at(a).second, ib = keyed.at(b).second;
+                    if (PerceptualHash::distance(ha, m_nodes.at(nodes.at(ib)).hash) > radius) continue;
+                    const int ra = findRoot(parent, ia), rb = findRoot(parent, ib);
+                    if (ra != rb) parent[ra] = rb;
+                }
+            }
+            run = end;
+        }
+    }
+
+    QHash<int, QVector<int>> groups;
+    for (int i = 0; i < n; ++i) groups[findRoot(parent, i)] += m_nodes.at(nodes.at(i)).ids;
+    QVector<QVector<int>> out;
+    for (auto it = groups.cbegin(); it != groups.cend(); ++it) {
+        if (it.value().size() >= 2) out.append(it.value());
+    }
+    std::sort(out.begin(), out.end(), [](const QVector<int> &a, const QVector<int> &b) {
+        return a.size() != b.size() ? a.size() > b.size() : a.first() < b.first();
+    });
+    return out;
+}
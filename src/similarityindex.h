@@ -0,0 +1,54 @@
+/*
+* 文件名：similarityindex.h
+* 日期：2026-10-16
+* 该文件功能大致描述：按感知哈希（dHash）查找相似表情的索引（按稳定槽位号）。“查找相似”用 BK 树：按汉明距离组织，
+*                    三角不等式剪枝，只访问可能落在半径内的子树；感知哈希完全相同的条目共用一个节点。
+*                    “聚类相似”用多索引哈希：把 64 位分成 radius+1 段，距离不超过 radius 的两个哈希至少有一段完全相同（抽屉原理），
+*                    只比较同段相同的候选对，再用并查集合并成簇。
+* 该文件函数功能描述：
+*   - insert()/remove()：加入、删除条目（删除只清空节点上的 ID，空节点过多时整体重建）
+*   - findSimilar()：半径内的所有条目，按距离升序
+*   - clusters()：所有至少两个条目的相似簇，按簇大小降序
+* 与该文件相关联的其他文件：similarityindex.cpp, perceptualhash.h, emojilistmodel.h, emojilistmodel.cpp, mainwindow.cpp
+*/
+
+#ifndef SIMILARITYINDEX_H
+#define SIMILARITYINDEX_H
+
+#include <QVector>
+#include <QHash>
+#include <QPair>
+
+class SimilarityIndex {
+public:
+    struct Match {
+        int id;
+        int distance;
+    };
+
+    static const int DefaultRadius = 10;  // 查找相似：64 位中最多 10 位不同
+    static const int ClusterRadius = 5;   // 聚类：更严格，只合并几乎相同的图
+
+    void clear();
+    void insert(int id, quint64 hash);
+    void remove(int id);
+    int size() const { return m_nodeOf.size(); }
+
+    QVector<Match> findSimilar(quint64 hash, int radius = DefaultRadius) const;
+    QVector<QVector<int>> clusters(int radius = ClusterRadius) const;
+
+private:
+    struct Node {
+        quint64 hash = 0;
+        QVector<int> ids;                     // 哈希完全相同的条目
+        QVector<QPair<int, int>> children;    // (到子节点的距离, 子节点下标)
+    };
+
+    void rebuild();
+
+    QVector<Node> m_nodes;   // m_nodes[0] 为根
+    QHash<int, int> m_nodeOf;  // ID → 节点下标
+    int m_emptyNodes = 0;
+};
+
+#endif // SIMILARITYINDEX_H
@@ -0,0 +1,144 @@
+#include "sortengine.h"
+
+#include <algorithm>
+#include <limits>
+
+SortEngine::SortEngine()
+    : m_collator(QLocale())
+{
+    m_collator.setCaseSensitivity(Qt::CaseInsensitive);  // 与原先 toLower() 比较的语义一致
+    std::fill(m_permValid, m_permValid + KeyCount, false);
+}
+
+void SortEngine::clear()
+{
+    m_names.clear();
+    m_nameKeys.clear();
+    m_nameKeyValid.clear();
+    m_sizes.clear();
+    m_times.clear();
+    m_live.clear();
+    m_deadCount = 0;
+    for (int k = 0; k < KeyCount; ++k) {
+        m_perm[k].clear();
+        m_permValid[k] = false;
+        m_added[k].clear();
+    }
+}
+
+void SortEngine::setItem(int slot, const EmojiItem &item)
+{
+    if (slot < m_live.size() && !m_live.at(slot) && m_deadCount > 0) {
+        purgeDead();  // 复用刚删除的槽位前，先把旧条目从缓存中剔除（一批导入只发生一次）
+    }
+    if (slot >= m_live.size()) {
+        const int n = slot + 1;
+        m_names.resize(n);
+        m_nameKeyValid.resize(n);
+        m_sizes.resize(n);
+        m_times.resize(n);
+        m_live.resize(n);
+    }
+    m_names[slot] = item.fileName;
+    m_nameKeyValid[slot] = false;
+    m_sizes[slot] = item.fileSize;
+    m_times[slot] = item.createTime.isValid() ? item.createTime.toMSecsSinceEpoch()
+                                              : std::numeric_limits<qint64>::min();
+    m_live[slot] = true;
+    for (int k = 0; k < KeyCount; ++k) {
+        if (m_permValid[k]) m_added[k].append(slot);
+    }
+}
+
+void SortEngine::removeItem(int slot)
+{
+    if (slot < 0 || slot >= m_live.size() || !m_live.at(slot)) return;
+    m_live[slot] = false;
+    m_names[slot].clear();
+    ++m_deadCount;
+}
+
+void SortEngine::renameItem(int slot, const QString &name)
+{
+    if (slot < 0 || slot >= m_live.size() || !m_live.at(slot)) return;
+    m_names[slot] = name;
+    m_nameKeyValid[slot] = false;
+    if (m_permValid[ByName]) {
+        // 单个条目：从名称置换中取出，下次取用时重新归并
+        m_perm[ByName].removeOne(slot);
+        m_added[ByName].removeOne(slot);
+        m_added[ByName].append(slot);
+    }
+}
+
+void SortEngine::ensureNameKeys(const QVector<int> &slots)
+{
+    if (m_nameKeys.size() < size_t(m_names.size())) {
+        m_nameKeys.resize(m_names.size(), m_collator.sortKey(QString()));
+    }
+    for (int slot : slots) {
+        if (m_nameKeyValid.at(slot)) continue;
+        m_nameKeys[slot] = m_collator.sortKey(m_names.at(slot));
+        m_nameKeyValid[slot] = true;
+    }
+}
+
+bool SortEngine::less(Key key, int a, int b) const
+{
+    switch (key) {
+    case ByDate:
+        if (m_times.at(a) != m_times.at(b)) return m_times.at(a) < m_times.at(b);
+        break;
+    case BySize:
+        if (m_sizes.at(a) != m_sizes.at(b)) return m_sizes.at(a) < m_sizes.at(b);
+        break;
+    default: {
+        const int c = m_nameKeys[a].compare(m_nameKeys[b]);
+        if (c != 0) return c < 0;
+        break;
+    }
+    }
+    return a < b;  // 键相同时按槽位，结果确定，增量归并与完整排序一致
+}
+
+void SortEngine::purgeDead()
+{
+    const QVector<bool> &live = m_live;
+    auto dead = [&live](int slot) { return !live.at(slot); };
+    for (int k = 0; k < KeyCount; ++k) {
+        if (!m_permValid[k]) continue;
+        m_perm[k].erase(std::remove_if(m_perm[k].begin(), m_perm[k].end(), dead), m_perm[k].end());
+        m_added[k].erase(std::remove_if(m_added[k].begin(), m_added[k].end(), dead), m_added[k].end());
+    }
+    m_deadCount = 0;
+}
+
+const QVector<int> &SortEngine::ascending(Key key)
+{
+    auto cmp = [this, key](int a, int b) { return less(key, a, b); };
+    QVector<int> &perm = m_perm[key];
+    if (!m_permValid[key]) {
+        perm.clear();
+        perm.reserve(m_live.size());
+        for (int slot = 0; slot < m_live.size(); ++slot) {
+            if (m_live.at(slot)) perm.append(slot);
+        }
+        if (key == ByName) ensureNameKeys(perm);
+        std::sort(perm.begin(), perm.end(), cmp);
+        m_permValid[key] = true;
+        m_added[key].clear();
+        return perm;
+    }
+
+    if (m_deadCount > 0) purgeDead();
+    QVector<int> &added = m_added[key];
+    if (!added.isEmpty()) {
+        if (key == ByName) ensureNameKeys(added);
+        std::sort(added.begin(), added.end(), cmp);
+        const int mid = perm.size();
+        perm += added;
+        std::inplace_merge(perm.begin(), perm.begin() + mid, perm.end(), cmp);
+        added.clear();
+    }
+    return perm;
+}
@@ -0,0 +1,60 @@
+/*
+* 文件名：sortengine.h
+* 日期：2026-10-16
+* 该文件功能大致描述：表情列表的排序引擎。每个条目的排序键只计算一次（名称使用与区域设置相关的 QCollator 排序键，
+*                    另有大小、创建时间），每种排序依据的升序置换（槽位序列）缓存下来，并随条目增删增量维护：
+*                    新增条目排序后与缓存归并，删除的条目在下次取用前统一剔除。降序不在这里计算，由模型反向映射行号。
+* 该文件函数功能描述：
+*   - setItem()/removeItem()/renameItem()：条目（按稳定槽位号）加入、删除、改名
+*   - ascending()：取得某排序依据下的升序槽位序列（首次调用时完整排序，之后只做增量归并）
+*   - clear()：清空全部数据与缓存
+* 与该文件相关联的其他文件：sortengine.cpp, emojilistmodel.h, emojilistmodel.cpp, emoji_meta.h
+*/
+
+#ifndef SORTENGINE_H
+#define SORTENGINE_H
+
+#include <QVector>
+#include <QString>
+#include <QCollator>
+#include <QCollatorSortKey>
+#include <vector>
+#include "emoji_meta.h"
+
+class SortEngine {
+public:
+    enum Key {
+        ByDate = 0,  // 与 EmojiListModel::SortKey 的取值一致
+        BySize = 1,
+        ByName = 2,
+        KeyCount = 3
+    };
+
+    SortEngine();
+
+    void clear();
+    void setItem(int slot, const EmojiItem &item);
+    void removeItem(int slot);
+    void renameItem(int slot, const QString &name);
+    const QVector<int> &ascending(Key key);
+
+private:
+    bool less(Key key, int a, int b) const;
+    void ensureNameKeys(const QVector<int> &slots);
+    void purgeDead();
+
+    QCollator m_collator;
+    QVector<QString> m_names;                 // 按槽位存放；排序键延迟计算，加载时不花时间
+    std::vector<QCollatorSortKey> m_nameKeys; // QCollatorSortKey 没有默认构造，只能用 std::vector
+    QVector<bool> m_nameKeyValid;
+    QVector<qint64> m_sizes;
+    QVector<qint64> m_times;                  // 毫秒时间戳，无效时间视为最早
+    QVector<bool> m_live;
+    int m_deadCount = 0;                      // 已删除但尚未从缓存置换中剔除的槽位数
+
+    QVector<int> m_perm[KeyCount];            // 各排序依据下的升序槽位序列
+    bool m_permValid[KeyCount];
+    QVector<int> m_added[KeyCount];           // 上次取用之后新增的槽位，取用时排序后归并
+};
+
+#endif // SORTENGINE_H
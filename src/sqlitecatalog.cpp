@@ -0,0 +1,513 @@
+#include "sqlitecatalog.h"
+#include "librarystore.h"  // 首次打开时导入旧的 JSON 快照 + 日志
+#include "emoji_meta.h"    // for DEBUG_LOG
+#include "trace.h"
+
+#include <QFile>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <QSqlRecord>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+
+namespace {
+
+const char *const kSchema[] = {
+    "CREATE TABLE IF NOT EXISTS emoji ("
+    " id INTEGER PRIMARY KEY,"
+    " path TEXT NOT NULL,"
+    " name TEXT NOT NULL,"
+    " size INTEGER NOT NULL DEFAULT 0,"
+    " ctime INTEGER,"            // 毫秒时间戳
+    " ord INTEGER NOT NULL,"     // 持久化排序键
+    " hash INTEGER,"             // 文件内容哈希（按位存为有符号整数），NULL 表示未知
+    " phash INTEGER)",           // 感知哈希（dHash），NULL 表示尚未计算
+    "CREATE INDEX IF NOT EXISTS emoji_path ON emoji(path)",
+    "CREATE INDEX IF NOT EXISTS emoji_ord ON emoji(ord)",
+    "CREATE INDEX IF NOT EXISTS emoji_name ON emoji(name COLLATE NOCASE, ord)",
+    "CREATE INDEX IF NOT EXISTS emoji_size ON emoji(size, ord)",
+    "CREATE INDEX IF NOT EXISTS emoji_ctime ON emoji(ctime, ord)",
+    "CREATE INDEX IF NOT EXISTS emoji_hash ON emoji(hash)"
+};
+
+QVariant timeValue(const QDateTime &t)
+{
+    return t.isValid() ? QVariant(t.toMSecsSinceEpoch()) : QVariant(QVariant::LongLong);
+}
+
+QVariant hashValue(quint64 hash)
+{
+    return hash ? QVariant(qint64(hash)) : QVariant(QVariant::LongLong);
+}
+
+QVariant phashValue(const LibraryRecord &rec)
+{
+    return rec.hasPhash ? QVariant(qint64(rec.phash)) : QVariant(QVariant::LongLong);
+}
+
+QString likePattern(const QString &text)
+{
+    QString s = text;
+    s.replace('\\', "\\\\").replace('%', "\\%").replace('_', "\\_");
+    return '%' + s + '%';
+}
+
+} // namespace
+
+// 运行在写线程中：持有独立的数据库连接，只做写入
+class CatalogWriter : public QObject {
+    Q_OBJECT
+public:
+    CatalogWriter(const QString &dbPath, const QString &connection)
+        : m_dbPath(dbPath), m_connection(connection) {}
+
+    // 在主线程中调用：每个投递给写线程的任务带一个递增序号，写线程做完（无论成败）后记下
+    int completed()
+    {
+        QMutexLocker lock(&m_mutex);
+        return m_completed;
+    }
+
+    void waitFor(int seq)
+    {
+        QMutexLocker lock(&m_mutex);
+        while (m_completed < seq) m_done.wait(&m_mutex);
+    }
+
+public slots:
+    // 返回 -1 失败，0 打开已有目录，1 新建了目录
+    int open()
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_connection);
+        db.setDatabaseName(m_dbPath);
+        if (!db.open()) {
+            DEBUG_LOG("Catalog: cannot open" << m_dbPath << db.lastError().text());
+            return -1;
+        }
+        const bool existed = db.tables().contains("emoji");
+        QSqlQuery q(db);
+        q.exec("PRAGMA journal_mode=WAL");   // 主线程读连接与写线程互不阻塞
+        q.exec("PRAGMA synchronous=NORMAL");
+        if (existed && !db.record("emoji").contains("hash")) {
+            q.exec("ALTER TABLE emoji ADD COLUMN hash INTEGER");  // 旧版本目录升级
+        }
+        if (existed && !db.record("emoji").contains("phash")) {
+            q.exec("ALTER TABLE emoji ADD COLUMN phash INTEGER");
+        }
+        for (const char *sql : kSchema) {
+            if (!q.exec(QString::fromLatin1(sql))) {
+                DEBUG_LOG("Catalog: schema error" << q.lastError().text());
+                return -1;
+            }
+        }
+        return existed ? 0 : 1;
+    }
+
+    void apply(const QVector<CatalogOp> &ops, int seq)
+    {
+        applyOps(ops);
+        complete(seq);
+    }
+
+    void reorder(const QVector<LibraryRecord> &records, int seq)
+    {
+        writeOrder(records);
+        complete(seq);
+    }
+
+    void close()
+    {
+        {
+            QSqlDatabase db = QSqlDatabase::database(m_connection, false);
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(m_connection);
+    }
+
+signals:
+    void failed(const QString &path);
+
+private:
+    void complete(int seq)
+    {
+        QMutexLocker lock(&m_mutex);
+        m_completed = seq;
+        m_done.wakeAll();
+    }
+
+    void applyOps(const QVector<CatalogOp> &ops)
+    {
+        QSqlDatabase db = QSqlDatabase::database(m_connection, false);
+        if (!db.transaction()) {
+            DEBUG_LOG("Catalog: cannot begin transaction" << db.lastError().text());
+            emit failed(m_dbPath);
+            return;
+        }
+        QSqlQuery add(db), del(db), ren(db), hash(db), phash(db);
+        add.prepare("INSERT INTO emoji(path, name, size, ctime, hash, phash, ord) "
+                    "VALUES(?, ?, ?, ?, ?, ?, (SELECT IFNULL(MAX(ord), -1) + 1 FROM emoji))");
+        hash.prepare("UPDATE emoji SET hash = ? WHERE path = ?");
+        phash.prepare("UPDATE emoji SET phash = ? WHERE path = ?");
+        // 与 JSON 日志一致：同一路径导入多次时，每次只作用于排在最前的一条
+        del.prepare("DELETE FROM emoji WHERE id = (SELECT id FROM emoji WHERE path = ? ORDER BY ord LIMIT 1)");
+        ren.prepare("UPDATE emoji SET name = ? WHERE id = (SELECT id FROM emoji WHERE path = ? ORDER BY ord LIMIT 1)");
+        // 任何一条失败即停止并回滚整批：不留下部分写入，连接也不会停在未结束的事务里
+        bool ok = true;
+        QSqlError error;
+        for (int i = 0; ok && i < ops.size(); ++i) {
+            const CatalogOp &op = ops.at(i);
+            QSqlQuery *q = nullptr;
+            switch (op.type) {
+            case CatalogOp::Add:
+                add.addBindValue(op.rec.path);
+                add.addBindValue(op.rec.name);
+                add.addBindValue(op.rec.size);
+                add.addBindValue(timeValue(op.rec.time));
+                add.addBindValue(hashValue(op.rec.hash));
+                add.addBindValue(phashValue(op.rec));
+                q = &add;
+                break;
+            case CatalogOp::Remove:
+                del.addBindValue(op.rec.path);
+                q = &del;
+                break;
+            case CatalogOp::Rename:
+                ren.addBindValue(op.rec.name);
+                ren.addBindValue(op.rec.path);
+                q = &ren;
+                break;
+            case CatalogOp::SetHash:
+                hash.addBindValue(hashValue(op.rec.hash));
+                hash.addBindValue(op.rec.path);
+                q = &hash;
+                break;
+            case CatalogOp::SetPerceptualHash:
+                phash.addBindValue(phashValue(op.rec));
+                phash.addBindValue(op.rec.path);
+                q = &phash;
+                break;
+            }
+            ok = q && q->exec();
+            if (!ok && q) error = q->lastError();
+        }
+        if (ok && !db.commit()) {
+            ok = false;
+            error = db.lastError();
+        }
+        if (!ok) {
+            DEBUG_LOG("Catalog: write failed" << error.text());
+            db.rollback();
+            emit failed(m_dbPath);
+        }
+    }
+
+    // 按给定顺序更新排序键（排序后使用）。条目集合不变时只改 ord 变化的行，不重写整张表；
+    // 集合不一致（首次导入旧 JSON）时才整体重写。其他列的修改已由 apply() 逐条写入，这里不再比较
+    void writeOrder(const QVector<LibraryRecord> &records)
+    {
+        QSqlDatabase db = QSqlDatabase::database(m_connection, false);
+        QSqlQuery cur(db);
+        cur.setForwardOnly(true);
+        // 路径 → 按 ord 排列的 (id, ord)；同一路径导入多次时按先后对应
+        QHash<QString, QVector<QPair<qint64, int>>> rows;
+        int total = 0;
+        if (cur.exec("SELECT id, path, ord FROM emoji ORDER BY ord")) {
+            while (cur.next()) {
+                rows[cur.value(1).toString()].append(qMakePair(cur.value(0).toLongLong(), cur.value(2).toInt()));
+                ++total;
+            }
+        }
+        if (total != records.size()) {
+            replaceAll(records);
+            return;
+        }
+        QVector<QPair<qint64, int>> updates;  // (id, 新 ord)
+        QHash<QString, int> used;
+        for (int i = 0; i < records.size(); ++i) {
+            const QString &path = records.at(i).path;
+            const auto it = rows.constFind(path);
+            int &k = used[path];
+            if (it == rows.constEnd() || k >= it->size()) {
+                replaceAll(records);
+                return;
+            }
+            const QPair<qint64, int> &row = it->at(k++);
+            if (row.second != i) updates.append(qMakePair(row.first, i));
+        }
+        if (updates.isEmpty()) return;
+
+        if (!db.transaction()) {
+            DEBUG_LOG("Catalog: cannot begin transaction" << db.lastError().text());
+            emit failed(m_dbPath);
+            return;
+        }
+        QSqlQuery q(db);
+        q.prepare("UPDATE emoji SET ord = ? WHERE id = ?");
+        bool ok = true;
+        for (int i = 0; ok && i < updates.size(); ++i) {
+            q.addBindValue(updates.at(i).second);
+            q.addBindValue(updates.at(i).first);
+            ok = q.exec();
+        }
+        if (!ok || !db.commit()) {
+            DEBUG_LOG("Catalog: reorder failed" << q.lastError().text());
+            db.rollback();
+            emit failed(m_dbPath);
+            return;
+        }
+        DEBUG_LOG("Catalog reordered:" << updates.size() << "of" << records.size() << "items");
+    }
+
+    // 整体重写：只在条目集合与目录不一致时使用（首次导入旧 JSON）
+    void replaceAll(const QVector<LibraryRecord> &records)
+    {
+        QSqlDatabase db = QSqlDatabase::database(m_connection, false);
+        if (!db.transaction()) {
+            DEBUG_LOG("Catalog: cannot begin transaction" << db.lastError().text());
+            emit failed(m_dbPath);
+            return;
+        }
+        QSqlQuery q(db);
+        bool ok = q.exec("DELETE FROM emoji");
+        q.prepare("INSERT INTO emoji(path, name, size, ctime, hash, phash, ord) VALUES(?, ?, ?, ?, ?, ?, ?)");
+        for (int i = 0; ok && i < records.size(); ++i) {
+            const LibraryRecord &rec = records.at(i);
+            q.addBindValue(rec.path);
+            q.addBindValue(rec.name);
+            q.addBindValue(rec.size);
+            q.addBindValue(timeValue(rec.time));
+            q.addBindValue(hashValue(rec.hash));
+            q.addBindValue(phashValue(rec));
+            q.addBindValue(i);
+            ok = q.exec();
+        }
+        if (!ok || !db.commit()) {
+            DEBUG_LOG("Catalog: rewrite failed" << q.lastError().text());
+            db.rollback();
+            emit failed(m_dbPath);
+            return;
+        }
+        DEBUG_LOG("Catalog rewritten:" << records.size() << "items");
+    }
+
+    QString m_dbPath;
+    QString m_connection;
+    QMutex m_mutex;
+    QWaitCondition m_done;
+    int m_completed = 0;  // 已做完的最后一个任务序号
+};
+
+SqliteCatalog::SqliteCatalog(const QString &dbPath, const QString &legacyJsonPath, QObject *parent)
+    : LibraryBackend(parent),
+      m_dbPath(dbPath),
+      m_legacyJsonPath(legacyJsonPath),
+      m_readConnection(QString("emoji_catalog_read_%1").arg(quintptr(this))),
+      m_writer(new CatalogWriter(dbPath, QString("emoji_catalog_write_%1").arg(quintptr(this))))
+{
+    qRegisterMetaType<QVector<CatalogOp>>("QVector<CatalogOp>");
+    qRegisterMetaType<QVector<LibraryRecord>>("QVector<LibraryRecord>");
+
+    m_writer->moveToThread(&m_thread);
+    connect(m_writer, &CatalogWriter::failed, this, &SqliteCatalog::writeFailed);
+    m_thread.setObjectName("CatalogWriter");
+    m_thread.start(QThread::LowPriority);
+
+    m_coalesceTimer.setSingleShot(true);
+    m_coalesceTimer.setInterval(CoalesceMs);
+    connect(&m_coalesceTimer, &QTimer::timeout, this, &SqliteCatalog::flush);
+}
+
+SqliteCatalog::~SqliteCatalog()
+{
+    flush();
+    QMetaObject::invokeMethod(m_writer, "close", Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+    delete m_writer;
+    if (m_open) {
+        {
+            QSqlDatabase db = QSqlDatabase::database(m_readConnection, false);
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(m_readConnection);
+    }
+}
+
+bool SqliteCatalog::isAvailable()
+{
+    return QSqlDatabase::isDriverAvailable("QSQLITE");
+}
+
+bool SqliteCatalog::open()
+{
+    int state = -1;
+    QMetaObject::invokeMethod(m_writer, "open", Qt::BlockingQueuedConnection, Q_RETURN_ARG(int, state));
+    if (state < 0) return false;
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_readConnection);
+    db.setDatabaseName(m_dbPath);
+    if (!db.open()) {
+        DEBUG_LOG("Catalog: cannot open read connection" << db.lastError().text());
+        QSqlDatabase::removeDatabase(m_readConnection);
+        return false;
+    }
+    m_open = true;
+
+    if (state == 1 && QFile::exists(m_legacyJsonPath)) {
+        // 新建的目录：一次性导入旧的 JSON 快照与日志（JSON 文件保留不动，作为备份）
+        QVector<LibraryRecord> records;
+        {
+            LibraryStore legacy(m_legacyJsonPath);
+            records = legacy.load();
+        }
+        writeSnapshot(records);
+        sync();
+        DEBUG_LOG("Catalog imported" << records.size() << "items from" << m_legacyJsonPath);
+    }
+    return true;
+}
+
+QVector<LibraryRecord> SqliteCatalog::load()
+{
+    return query(LibraryQuery());
+}
+
+QVector<LibraryRecord> SqliteCatalog::query(const LibraryQuery &q)
+{
+    TRACE_SCOPE(Trace::Library, "SqliteCatalog::query");
+    sync();  // 先让合并中的修改落库，查询结果才包含它们
+
+    static const char *const columns[] = { "ord", "ctime", "size", "name COLLATE NOCASE" };
+    const char *dir = q.sortOrder == Qt::DescendingOrder ? " DESC" : " ASC";
+    QStringList where;
+    if (q.sortKey == LibraryQuery::ByOrder && q.sortOrder == Qt::AscendingOrder && q.afterOrder >= 0)
+        where << "ord > :after";
+    if (!q.nameContains.isEmpty())
+        where << "name LIKE :pattern ESCAPE '\\'";  // 子串匹配用不到 B 树，但按索引顺序扫描，凑够一页即停止
+
+    QString sql = "SELECT path, name, ctime, size, ord, hash, phash FROM emoji";
+    if (!where.isEmpty()) sql += " WHERE " + where.join(" AND ");
+    sql += QString(" ORDER BY %1%2").arg(QLatin1String(columns[q.sortKey]), QLatin1String(dir));
+    if (q.sortKey != LibraryQuery::ByOrder) sql += QString(", ord%1").arg(QLatin1String(dir));
+    sql += " LIMIT :limit OFFSET :offset";
+
+    QSqlQuery query(QSqlDatabase::database(m_readConnection, false));
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    if (where.contains("ord > :after")) query.bindValue(":after", q.afterOrder);
+    if (!q.nameContains.isEmpty()) query.bindValue(":pattern", likePattern(q.nameContains));
+    query.bindValue(":limit", q.limit);
+    query.bindValue(":offset", q.offset);
+
+    QVector<LibraryRecord> out;
+    if (q.limit > 0) out.reserve(q.limit);
+    if (!query.exec()) {
+        DEBUG_LOG("Catalog: query failed" << query.lastError().text());
+        return out;
+    }
+    while (query.next()) {
+        LibraryRecord rec;
+        rec.path = query.value(0).toString();
+        rec.name = query.value(1).toString();
+        if (!query.value(2).isNull()) rec.time = QDateTime::fromMSecsSinceEpoch(query.value(2).toLongLong());
+        rec.size = query.value(3).toLongLong();
+        rec.order = query.value(4).toInt();
+        rec.hash = quint64(query.value(5).toLongLong());  // NULL → 0
+        rec.hasPhash = !query.value(6).isNull();
+        rec.phash = quint64(query.value(6).toLongLong());
+        out.append(rec);
+    }
+    return out;
+}
+
+int SqliteCatalog::count()
+{
+    sync();
+    QSqlQuery query(QSqlDatabase::database(m_readConnection, false));
+    if (!query.exec("SELECT COUNT(*) FROM emoji") || !query.next()) return 0;
+    return query.value(0).toInt();
+}
+
+void SqliteCatalog::enqueue(const CatalogOp &op)
+{
+    m_pending.append(op);
+    if (!m_coalesceTimer.isActive()) m_coalesceTimer.start();
+}
+
+void SqliteCatalog::recordAdd(const LibraryRecord &rec)
+{
+    CatalogOp op;
+    op.type = CatalogOp::Add;
+    op.rec = rec;
+    enqueue(op);
+}
+
+void SqliteCatalog::recordRemove(const QStringList &paths)
+{
+    for (const QString &path : paths) {
+        CatalogOp op;
+        op.type = CatalogOp::Remove;
+        op.rec.path = path;
+        enqueue(op);
+    }
+}
+
+void SqliteCatalog::recordRename(const QString &path, const QString &name)
+{
+    CatalogOp op;
+    op.type = CatalogOp::Rename;
+    op.rec.path = path;
+    op.rec.name = name;
+    enqueue(op);
+}
+
+void SqliteCatalog::recordHash(const QString &path, quint64 hash)
+{
+    CatalogOp op;
+    op.type = CatalogOp::SetHash;
+    op.rec.path = path;
+    op.rec.hash = hash;
+    enqueue(op);
+}
+
+void SqliteCatalog::recordPerceptualHash(const QString &path, quint64 phash)
+{
+    CatalogOp op;
+    op.type = CatalogOp::SetPerceptualHash;
+    op.rec.path = path;
+    op.rec.phash = phash;
+    op.rec.hasPhash = true;
+    enqueue(op);
+}
+
+void SqliteCatalog::writeSnapshot(const QVector<LibraryRecord> &records)
+{
+    flush();
+    QMetaObject::invokeMethod(m_writer, "reorder", Qt::QueuedConnection,
+                              Q_ARG(QVector<LibraryRecord>, records), Q_ARG(int, ++m_submitted));
+}
+
+void SqliteCatalog::flush()
+{
+    m_coalesceTimer.stop();
+    if (m_pending.isEmpty()) return;
+    QMetaObject::invokeMethod(m_writer, "apply", Qt::QueuedConnection, Q_ARG(QVector<CatalogOp>, m_pending),
+                              Q_ARG(int, ++m_submitted));
+    m_pending.clear();
+}
+
+void SqliteCatalog::sync()
+{
+    flush();
+    // WAL 模式下读连接能直接读到已提交的数据：没有尚未做完的写入时立即返回，不经过写线程
+    if (m_writer->completed() >= m_submitted) return;
+    TRACE_SCOPE(Trace::Library, "SqliteCatalog::sync wait");
+    // 界面线程在等待期间，写线程不再以低优先级让出 CPU
+    m_thread.setPriority(QThread::NormalPriority);
+    m_writer->waitFor(m_submitted);
+    m_thread.setPriority(QThread::LowPriority);
+}
+
+#include "sqlitecatalog.moc"
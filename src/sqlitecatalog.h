@@ -0,0 +1,73 @@
+/*
+* 文件名：sqlitecatalog.h
+* 日期：2026-10-16
+* 该文件功能大致描述：基于 SQLite 的表情库目录（LibraryBackend 的索引实现）。路径、名称、大小、创建时间、排序键、内容哈希各有索引，
+*                    排序 / 分页 / 名称过滤都由数据库回答，不必把整个表情库读入内存；50 万条的库也可以先显示第一页。
+*                    首次打开时从现有的 emoji_data.json（含日志）导入一次；之后每次修改在后台写线程中按批提交事务。
+* 该文件函数功能描述：
+*   - isAvailable()：Qt 是否带有 QSQLITE 驱动
+*   - open()：打开/建表，新建时从 JSON 导入；失败返回 false（MainWindow 回退到 LibraryStore）
+*   - load()/query()/count()：在主线程的只读连接上直接读 WAL 快照；仅当还有已投递未做完的写入时才等待到它们完成
+*   - recordAdd()/recordRemove()/recordRename()/recordHash()/recordPerceptualHash()：合并后在写线程中一个事务提交
+*   - writeSnapshot()：在写线程中按给定顺序更新排序键，只写 ord 变化的行（条目集合与目录不一致时才整体重写）
+* 与该文件相关联的其他文件：sqlitecatalog.cpp, librarybackend.h, librarystore.h, mainwindow.cpp
+*/
+
+#ifndef SQLITECATALOG_H
+#define SQLITECATALOG_H
+
+#include "librarybackend.h"
+#include <QTimer>
+#include <QThread>
+#include <QSqlDatabase>
+
+class CatalogWriter;  // 前置声明：运行在写线程中的对象
+
+struct CatalogOp {
+    enum Type { Add, Remove, Rename, SetHash, SetPerceptualHash };
+    Type type = Add;
+    LibraryRecord rec;  // Add: 完整记录；其余只用 path（另用 name / hash / phash）
+};
+Q_DECLARE_METATYPE(CatalogOp)
+
+class SqliteCatalog : public LibraryBackend {
+    Q_OBJECT
+public:
+    SqliteCatalog(const QString &dbPath, const QString &legacyJsonPath, QObject *parent = nullptr);
+    ~SqliteCatalog() override;
+
+    static bool isAvailable();
+    bool open();
+
+    bool isIndexed() const override { return true; }
+    QVector<LibraryRecord> load() override;
+    QVector<LibraryRecord> query(const LibraryQuery &q) override;
+    int count() override;
+
+    void recordAdd(const LibraryRecord &rec) override;
+    void recordRemove(const QStringList &paths) override;
+    void recordRename(const QString &path, const QString &name) override;
+    void recordHash(const QString &path, quint64 hash) override;
+    void recordPerceptualHash(const QString &path, quint64 phash) override;
+    void writeSnapshot(const QVector<LibraryRecord> &records) override;
+    bool snapshotPending() const override { return false; }  // 每次修改都已直接写入索引表
+    void flush() override;
+
+    static const int CoalesceMs = 100;  // 合并窗口：这段时间内的修改放进同一个事务
+
+private:
+    void enqueue(const CatalogOp &op);
+    void sync();
+
+    QString m_dbPath;
+    QString m_legacyJsonPath;
+    QString m_readConnection;
+    QThread m_thread;
+    CatalogWriter *m_writer;
+    QVector<CatalogOp> m_pending;
+    QTimer m_coalesceTimer;
+    int m_submitted = 0;  // 已投递给写线程的最后一个任务序号
+    bool m_open = false;
+};
+
+#endif // SQLITECATALOG_H
@@ -0,0 +1,90 @@
+#include "startupprofile.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+#include "trace.h"
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <QPair>
+#include <QByteArray>
+#include <QPointer>
+#include <QWidget>
+#include <QEvent>
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+
+namespace {
+
+// 只在主线程访问
+QElapsedTimer g_clock;
+QVector<QPair<QByteArray, qint64>> g_marks;  // 本轮记录的阶段（汇总后清空）
+bool g_reported = false;                      // 已经汇总过一次：之后的轮次是热启动
+
+void report()
+{
+    if (g_marks.isEmpty()) return;
+    const bool cold = !g_reported;
+    g_reported = true;
+    // 冷启动从进程启动算起；热启动从本轮第一个阶段（点击启动图标）算起
+    const qint64 base = cold ? 0 : g_marks.first().second;
+    QByteArray line = QDateTime::currentDateTime().toString(Qt::ISODate).toUtf8();
+    line += cold ? " cold" : " warm";
+    line += " total " + QByteArray::number(g_marks.last().second - base) + " ms";
+    qint64 prev = base;
+    for (const auto &m : qAsConst(g_marks)) {
+        line += " | " + m.first + ' ' + QByteArray::number(m.second - base)
+                + " (+" + QByteArray::number(m.second - prev) + ')';
+        prev = m.second;
+    }
+    g_marks.clear();
+    DEBUG_LOG("Startup:" << line.constData());
+
+    QFile f(QDir::home().filePath(".emoji_startup.log"));
+    if (f.open(QIODevice::WriteOnly | QIODevice::Append)) f.write(line + '\n');
+}
+
+// 一次性的事件过滤器：第一次 Paint 时记录并汇总，然后移除自己
+class PaintProbe : public QObject {
+public:
+    PaintProbe(QWidget *widget, const char *phase) : QObject(widget), m_phase(phase) {}
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::Paint) {
+            watched->removeEventFilter(this);
+            StartupProfile::mark(m_phase);
+            report();
+            deleteLater();
+        }
+        return false;
+    }
+
+private:
+    const char *m_phase;
+};
+
+QPointer<PaintProbe> g_probe;
+
+} // namespace
+
+void StartupProfile::start()
+{
+    g_clock.start();
+}
+
+void StartupProfile::mark(const char *phase)
+{
+    if (!g_clock.isValid()) return;
+    const qint64 ms = g_clock.elapsed();
+    g_marks.append(qMakePair(QByteArray(phase), ms));
+    TRACE_INSTANT(Trace::Startup, phase);
+    DEBUG_LOG("Startup phase:" << phase << "at" << ms << "ms");
+}
+
+void StartupProfile::reportOnNextPaint(QWidget *widget, const char *phase)
+{
+    if (g_probe) delete g_probe.data();  // 重复调用只保留最新的一个
+    g_probe = new PaintProbe(widget, phase);
+    widget->installEventFilter(g_probe);
+}
@@ -0,0 +1,28 @@
+/*
+* 文件名：startupprofile.h
+* 日期：2026-10-16
+* 该文件功能大致描述：启动阶段计时。从 main() 第一行开始计时，各阶段（启动图标显示、主窗口构造、表情库读取、
+*                    首屏缩略图就绪、点击启动图标、网格第一次绘制）调用 mark() 记录时间点。网格绘制出第一帧时
+*                    把本轮各阶段汇总为一行：进程启动后的第一次为冷启动，之后从启动图标再次打开为热启动（点击 → 绘制）。
+*                    汇总同时输出到 DEBUG_LOG 并追加到 ~/.emoji_startup.log，便于跨版本比较启动耗时。
+* 该文件函数功能描述：
+*   - start()：开始计时（main() 第一行调用）
+*   - mark()：记录一个阶段的完成时间
+*   - reportOnNextPaint()：控件下一次绘制时记录该阶段，并把本轮记录的阶段写成一行汇总
+* 与该文件相关联的其他文件：startupprofile.cpp, main.cpp, mainwindow.cpp
+*/
+
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+class QWidget;
+
+namespace StartupProfile {
+
+void start();
+void mark(const char *phase);
+void reportOnNextPaint(QWidget *widget, const char *phase);
+
+} // namespace StartupProfile
+
+#endif // STARTUPPROFILE_H
@@ -0,0 +1,308 @@
+#include "thumbnailcache.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+
+#include <QDir>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QVector>
+#include <QPair>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const quint32 kMagic = 0x454D5443;  // 'EMTC'
+const quint32 kVersion = 1;
+const qint64 kMinCompactBytes = 4 * 1024 * 1024;  // 数据文件太小时不值得压缩
+const qint64 kCopyChunk = 1024 * 1024;
+
+// 压缩时待复制的一个条目
+struct Block {
+    QString path;
+    qint64 offset;
+    qint32 length;
+    qint64 newOffset;
+};
+
+// 把 in 中 [offset, offset + length) 追加到 out 末尾，读写任何一步不完整都返回 false
+bool copyRange(QFile &in, qint64 offset, qint64 length, QFile &out)
+{
+    if (!in.seek(offset)) return false;
+    while (length > 0) {
+        const QByteArray chunk = in.read(qMin(length, kCopyChunk));
+        if (chunk.isEmpty() || out.write(chunk) != chunk.size()) return false;
+        length -= chunk.size();
+    }
+    return true;
+}
+
+// 用 tmp 替换 target。Windows 上 rename 不能覆盖已有文件，先把原文件移开，失败时移回
+bool replaceFile(const QString &tmp, const QString &target)
+{
+    const QString backup = target + ".old";
+    QFile::remove(backup);
+    if (!QFile::rename(target, backup)) return false;
+    if (!QFile::rename(tmp, target)) {
+        QFile::rename(backup, target);
+        return false;
+    }
+    QFile::remove(backup);
+    return true;
+}
+
+} // namespace
+
+ThumbnailCache::~ThumbnailCache()
+{
+    flush();
+}
+
+bool ThumbnailCache::open(const QString &dirPath, qint64 maxBytes)
+{
+    QMutexLocker lock(&m_mutex);
+    m_dir = dirPath;
+    m_maxBytes = maxBytes;
+    m_index.clear();
+    m_liveBytes = 0;
+    m_dirty = false;
+    if (m_pack.isOpen()) m_pack.close();
+    QDir().mkpath(dirPath);
+
+    // 读取索引；任何不一致都视为空缓存，不影响功能
+    qint64 packSize = 0;
+    QFile idx(QDir(dirPath).filePath("thumbs.idx"));
+    if (idx.open(QIODevice::ReadOnly)) {
+        QDataStream in(&idx);
+        in.setVersion(QDataStream::Qt_5_6);
+        quint32 magic = 0, version = 0;
+        qint32 n = 0;
+        in >> magic >> version >> packSize >> m_tick >> n;
+        if (magic == kMagic && version == kVersion && in.status() == QDataStream::Ok) {
+            m_index.reserve(n);
+            for (qint32 i = 0; i < n && in.status() == QDataStream::Ok; ++i) {
+                QString path;
+                Entry e;
+                in >> path >> e.mtimeMs >> e.fileSize >> e.offset >> e.length
+                   >> e.width >> e.height >> e.format >> e.lastUse;
+                m_index.insert(path, e);
+                m_liveBytes += e.length;
+            }
+        }
+        if (in.status() != QDataStream::Ok || magic != kMagic || version != kVersion) {
+            DEBUG_LOG("Thumbnail cache index invalid, starting empty");
+            m_index.clear();
+            m_liveBytes = 0;
+            packSize = 0;
+        }
+    }
+
+    m_pack.setFileName(QDir(dirPath).filePath("thumbs.pack"));
+    // 上次压缩在两次 rename 之间中断：原数据文件还在 .old 中，移回即可（索引仍对应它）
+    if (!QFile::exists(m_pack.fileName()) && QFile::exists(m_pack.fileName() + ".old")) {
+        QFile::rename(m_pack.fileName() + ".old", m_pack.fileName());
+    }
+    QFile::remove(m_pack.fileName() + ".tmp");
+    if (!m_pack.open(QIODevice::ReadWrite)) {
+        DEBUG_LOG("Failed to open thumbnail cache:" << m_pack.fileName());
+        m_index.clear();
+        return false;
+    }
+    // 上次索引保存之后追加的数据没有索引项，直接截断；数据文件比索引记录的短则说明已损坏
+    if (m_pack.size() < packSize) {
+        m_index.clear();
+        m_liveBytes = 0;
+        packSize = 0;
+    }
+    if (m_pack.size() != packSize) m_pack.resize(packSize);
+    DEBUG_LOG("Thumbnail cache opened:" << m_index.size() << "entries," << m_liveBytes << "bytes");
+    return true;
+}
+
+QImage ThumbnailCache::lookup(const QFileInfo &fi)
+{
+    QMutexLocker lock(&m_mutex);
+    if (!m_pack.isOpen()) return QImage();
+    auto it = m_index.find(fi.absoluteFilePath());
+    if (it == m_index.end()) return QImage();
+    // 原文件被修改过：视为未命中，之后的 insert() 会覆盖该条目
+    if (it->mtimeMs != fi.lastModified().toMSecsSinceEpoch() || it->fileSize != fi.size()) return QImage();
+
+    if (!m_pack.seek(it->offset)) return QImage();
+    const QByteArray raw = qUncompress(m_pack.read(it->length));
+    QImage img(it->width, it->height, static_cast<QImage::Format>(it->format));
+    if (img.isNull() || raw.size() != img.bytesPerLine() * img.height()) return QImage();
+    std::memcpy(img.bits(), raw.constData(), static_cast<size_t>(raw.size()));
+
+    // 只在内存中更新 LRU 计数，不标记索引需要保存：滚动浏览不应让每次 flush() 重写整个索引。
+    // 计数随下一次因插入/淘汰/压缩而保存的索引一起写出
+    it->lastUse = ++m_tick;
+    return img;
+}
+
+void ThumbnailCache::insert(const QFileInfo &fi, const QImage &thumb)
+{
+    if (thumb.isNull()) return;
+    // 统一为 32 位格式，加载时直接按原始像素构造 QImage
+    const QImage img = thumb.convertToFormat(thumb.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                                     : QImage::Format_RGB32);
+    // 压缩在锁外完成，导入线程之间互不阻塞
+    const QByteArray blob = qCompress(img.constBits(), img.bytesPerLine() * img.height(), 1);
+
+    Entry e;
+    e.mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+    e.fileSize = fi.size();
+    e.length = blob.size();
+    e.width = img.width();
+    e.height = img.height();
+    e.format = img.format();
+
+    QMutexLocker lock(&m_mutex);
+    if (!m_pack.isOpen()) return;
+    e.offset = m_pack.size();
+    if (!m_pack.seek(e.offset) || m_pack.write(blob) != blob.size()) {
+        DEBUG_LOG("Thumbnail cache write failed:" << fi.absoluteFilePath());
+        return;
+    }
+    e.lastUse = ++m_tick;
+
+    const QString key = fi.absoluteFilePath();
+    auto old = m_index.find(key);
+    if (old != m_index.end()) m_liveBytes -= old->length;
+    m_index.insert(key, e);
+    m_liveBytes += e.length;
+    m_dirty = true;
+
+    if (m_liveBytes > m_maxBytes) evictLocked();
+}
+
+void ThumbnailCache::evictLocked()
+{
+    // 淘汰到上限的 90%，避免每次插入都触发；被淘汰条目的数据留在文件中，由 compact() 回收
+    QVector<QPair<quint64, QString>> order;
+    order.reserve(m_index.size());
+    for (auto it = m_index.cbegin(); it != m_index.cend(); ++it) {
+        order.append(qMakePair(it->lastUse, it.key()));
+    }
+    std::sort(order.begin(), order.end());
+    const qint64 target = m_maxBytes / 10 * 9;
+    int evicted = 0;
+    for (const auto &p : qAsConst(order)) {
+        if (m_liveBytes <= target) break;
+        m_liveBytes -= m_index.value(p.second).length;
+        m_index.remove(p.second);
+        ++evicted;
+    }
+    m_dirty = true;
+    DEBUG_LOG("Thumbnail cache evicted" << evicted << "entries, live bytes:" << m_liveBytes);
+}
+
+void ThumbnailCache::flush()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        if (!m_pack.isOpen()) return;
+        const qint64 deadBytes = m_pack.size() - m_liveBytes;
+        if (m_pack.size() <= kMinCompactBytes || deadBytes <= m_liveBytes) {
+            if (m_dirty) saveIndexLocked();
+            return;
+        }
+    }
+    compact();  // 成功时会保存索引
+}
+
+void ThumbnailCache::compact()
+{
+    // 第一步（持锁）：记下有效条目的位置与当前文件末尾。数据文件只在末尾追加，末尾之前的内容在复制期间不会变化
+    QVector<Block> blocks;
+    QString packPath;
+    qint64 end = 0;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (!m_pack.isOpen() || m_compacting) return;
+        m_compacting = true;
+        m_pack.flush();
+        packPath = m_pack.fileName();
+        end = m_pack.size();
+        blocks.reserve(m_index.size());
+        for (auto it = m_index.cbegin(); it != m_index.cend(); ++it) {
+            blocks.append({it.key(), it->offset, it->length, 0});
+        }
+    }
+    std::sort(blocks.begin(), blocks.end(), [](const Block &a, const Block &b) { return a.offset < b.offset; });
+
+    // 第二步（不持锁）：用独立的只读句柄按偏移顺序复制到临时文件，每次写入都检查
+    QFile out(packPath + ".tmp");
+    bool ok = out.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    if (ok) {
+        QFile in(packPath);
+        ok = in.open(QIODevice::ReadOnly);
+        for (int i = 0; ok && i < blocks.size(); ++i) {
+            Block &b = blocks[i];
+            b.newOffset = out.pos();
+            ok = copyRange(in, b.offset, b.length, out);
+        }
+    }
+
+    // 第三步（持锁）：补上复制期间追加的尾部，替换文件；全部成功后才换入新偏移
+    QMutexLocker lock(&m_mutex);
+    m_compacting = false;
+    const qint64 before = m_pack.size();
+    const qint64 tailDelta = out.pos() - end;  // 复制期间追加的条目整体平移
+    ok = ok && m_pack.isOpen() && copyRange(m_pack, end, before - end, out) && out.flush();
+    out.close();
+    if (ok) {
+        m_pack.close();
+        ok = replaceFile(out.fileName(), packPath);
+        if (!m_pack.open(QIODevice::ReadWrite)) {
+            // 文件已替换（或已恢复）却无法打开：缓存停用，索引保持不变，下次 open() 时按文件长度校验
+            DEBUG_LOG("Thumbnail cache reopen failed after compaction:" << packPath);
+            QFile::remove(out.fileName());
+            return;
+        }
+    }
+    if (!ok) {
+        DEBUG_LOG("Thumbnail cache compaction failed, keeping" << packPath);
+        QFile::remove(out.fileName());
+        return;
+    }
+
+    QHash<QString, QPair<qint64, qint64>> moved;  // 路径 → (旧偏移, 新偏移)
+    moved.reserve(blocks.size());
+    for (const Block &b : qAsConst(blocks)) moved.insert(b.path, qMakePair(b.offset, b.newOffset));
+    for (auto it = m_index.begin(); it != m_index.end();) {
+        if (it->offset >= end) {
+            it->offset += tailDelta;  // 复制期间插入（或覆盖）的条目
+        } else {
+            const auto m = moved.constFind(it.key());
+            if (m == moved.cend() || m->first != it->offset) {
+                // 不会发生：末尾之前的条目都在快照中。防御性地丢弃，不让索引指向错误的位置
+                m_liveBytes -= it->length;
+                it = m_index.erase(it);
+                continue;
+            }
+            it->offset = m->second;
+        }
+        ++it;
+    }
+    saveIndexLocked();
+    DEBUG_LOG("Thumbnail cache compacted:" << before << "->" << m_pack.size() << "bytes");
+}
+
+bool ThumbnailCache::saveIndexLocked()
+{
+    m_pack.flush();
+    QSaveFile idx(QDir(m_dir).filePath("thumbs.idx"));
+    if (!idx.open(QIODevice::WriteOnly)) return false;
+    QDataStream out(&idx);
+    out.setVersion(QDataStream::Qt_5_6);
+    out << kMagic << kVersion << m_pack.size() << m_tick << static_cast<qint32>(m_index.size());
+    for (auto it = m_index.cbegin(); it != m_index.cend(); ++it) {
+        const Entry &e = it.value();
+        out << it.key() << e.mtimeMs << e.fileSize << e.offset << e.length
+            << e.width << e.height << e.format << e.lastUse;
+    }
+    if (!idx.commit()) return false;
+    m_dirty = false;
+    return true;
+}
@@ -0,0 +1,71 @@
+/*
+* 文件名：thumbnailcache.h
+* 日期：2026-10-16
+* 该文件功能大致描述：持久化缩略图磁盘缓存。缩略图以"原始像素 + zlib 快速压缩"的形式追加写入 thumbs.pack，
+*                    索引（路径 → 修改时间、大小、偏移）保存在 thumbs.idx；命中时只需 stat 原文件，无需解码原图。
+*                    支持按总字节数上限做 LRU 淘汰，以及在失效数据过多时压缩（重写）数据文件。线程安全，可在导入线程中使用。
+* 该文件函数功能描述：
+*   - open()：打开/创建缓存目录，读取索引
+*   - lookup()：按 路径 + mtime + size 查找缩略图，未命中或已过期返回空图（命中只更新内存中的 LRU 计数）
+*   - insert()：写入一张缩略图，超出上限时淘汰最久未使用的条目
+*   - flush()：保存索引；失效数据超过一半时自动 compact()
+*   - compact()：只保留有效条目，重写数据文件。复制在锁外进行（查询与插入照常），写入与替换文件逐步检查，
+*                全部成功后才换入新偏移；任何一步失败都保留原数据文件与索引
+* 与该文件相关联的其他文件：thumbnailcache.cpp, importpipeline.cpp, mainwindow.cpp
+*/
+
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QString>
+#include <QImage>
+#include <QHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+
+class ThumbnailCache {
+public:
+    static const qint64 DefaultMaxBytes = 512LL * 1024 * 1024;  // 数据文件有效字节上限
+
+    ThumbnailCache() = default;
+    ~ThumbnailCache();
+
+    bool open(const QString &dirPath, qint64 maxBytes = DefaultMaxBytes);
+    bool isOpen() const { return m_pack.isOpen(); }
+
+    QImage lookup(const QFileInfo &fi);
+    void insert(const QFileInfo &fi, const QImage &thumb);
+    void flush();
+    void compact();
+
+    qint64 liveBytes() const { return m_liveBytes; }
+    int count() const { return m_index.size(); }
+
+private:
+    struct Entry {
+        qint64 mtimeMs = 0;   // 原文件修改时间（毫秒）
+        qint64 fileSize = 0;  // 原文件大小
+        qint64 offset = 0;    // 在 thumbs.pack 中的偏移
+        qint32 length = 0;    // 压缩后字节数
+        qint32 width = 0;
+        qint32 height = 0;
+        qint32 format = 0;    // QImage::Format
+        quint64 lastUse = 0;  // LRU 计数
+    };
+
+    void evictLocked();
+    bool saveIndexLocked();
+
+    QMutex m_mutex;
+    QString m_dir;
+    QFile m_pack;
+    QHash<QString, Entry> m_index;  // 原文件路径 → 条目
+    qint64 m_maxBytes = DefaultMaxBytes;
+    qint64 m_liveBytes = 0;         // 有效条目占用的字节
+    quint64 m_tick = 0;
+    bool m_dirty = false;           // 条目有增删改，索引需要保存（仅 LRU 计数变化不算）
+    bool m_compacting = false;      // 压缩进行中（锁外复制期间），不再发起第二次
+};
+
+#endif // THUMBNAILCACHE_H
@@ -0,0 +1,103 @@
+#include "thumbnailer.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+#include "trace.h"
+
+#include <QImageReader>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+
+namespace {
+
+QMutex g_statsMutex;
+QHash<QByteArray, ThumbnailFormatStats> g_stats;
+
+qint64 imageBytes(const QImage &img)
+{
+    return img.isNull() ? 0 : qint64(img.bytesPerLine()) * img.height();
+}
+
+void recordStats(const QByteArray &format, qint64 ns, qint64 peak, qint64 full, bool scaled)
+{
+    QMutexLocker lock(&g_statsMutex);
+    ThumbnailFormatStats &s = g_stats[format.isEmpty() ? QByteArray("unknown") : format];
+    ++s.count;
+    if (scaled) ++s.scaledDecodes;
+    s.decodeNs += ns;
+    s.maxPeakBytes = qMax(s.maxPeakBytes, peak);
+    s.totalPeakBytes += peak;
+    s.totalFullBytes += full;
+}
+
+} // namespace
+
+QImage Thumbnailer::generate(const QString &path, const QSize &box)
+{
+    TRACE_SCOPE(Trace::Thumbnail, "Thumbnailer::generate");
+    QElapsedTimer timer;
+    timer.start();
+
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    const QByteArray format = reader.format();
+    const QSize src = reader.size();  // 只读文件头，不解码
+    bool scaledDecode = false;
+
+    if (src.isValid() && reader.supportsOption(QImageIOHandler::ScaledSize)) {
+        const QSize target = src.scaled(box, Qt::KeepAspectRatio);
+        // 只缩小不放大；JPEG 会在 DCT 域直接按 1/2、1/4、1/8 解码
+        if (target.width() < src.width() && !target.isEmpty()) {
+            reader.setScaledSize(target);
+            scaledDecode = true;
+        }
+    }
+
+    // GIF/WebP 只读取第一帧：这里只调用一次 read()，也不调用会扫描整个文件的 imageCount()
+    QImage img = reader.read();
+    const qint64 peak = imageBytes(img);
+
+    if (!img.isNull() && (img.width() > box.width() || img.height() > box.height())) {
+        // 回退路径：不支持按尺寸解码的格式，完整解码后再缩放
+        img = img.scaled(box, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    if (img.isNull()) {
+        DEBUG_LOG("Thumbnailer: decode failed" << path << reader.errorString());
+    }
+    const qint64 full = src.isValid() ? qint64(src.width()) * src.height() * 4 : peak;
+    recordStats(format, timer.nsecsElapsed(), peak, full, scaledDecode);
+    return img;
+}
+
+QHash<QByteArray, ThumbnailFormatStats> Thumbnailer::statsSnapshot()
+{
+    QMutexLocker lock(&g_statsMutex);
+    return g_stats;
+}
+
+QString Thumbnailer::statsReport()
+{
+    const QHash<QByteArray, ThumbnailFormatStats> stats = statsSnapshot();
+    QStringList lines;
+    for (auto it = stats.cbegin(); it != stats.cend(); ++it) {
+        const ThumbnailFormatStats &s = it.value();
+        if (s.count == 0) continue;
+        lines << QString("%1: %2 files (%3 scaled), avg %4 ms, peak %5 KB, avg %6 KB vs full decode %7 KB")
+                 .arg(QString::fromLatin1(it.key()))
+                 .arg(s.count)
+                 .arg(s.scaledDecodes)
+                 .arg(s.decodeNs / 1e6 / s.count, 0, 'f', 2)
+                 .arg(s.maxPeakBytes / 1024)
+                 .arg(s.totalPeakBytes / 1024 / s.count)
+                 .arg(s.totalFullBytes / 1024 / s.count);
+    }
+    lines.sort();
+    return lines.join('\n');
+}
+
+void Thumbnailer::resetStats()
+{
+    QMutexLocker lock(&g_statsMutex);
+    g_stats.clear();
+}
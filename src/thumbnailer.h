@@ -0,0 +1,41 @@
+/*
+* 文件名：thumbnailer.h
+* 日期：2026-10-16
+* 该文件功能大致描述：缩略图生成器。尽量在解码阶段直接得到目标尺寸：支持 ScaledSize 的格式（JPEG 在 DCT 域缩放、
+*                    GIF/WebP 只解第一帧）通过 QImageReader::setScaledSize 解码，保持原图宽高比不裁剪；
+*                    不支持的格式回退为完整解码后缩放。按格式统计解码耗时与峰值内存，便于对比优化效果。
+* 该文件函数功能描述：
+*   - generate()：生成适配 box 的缩略图（保持宽高比），失败返回空图；线程安全
+*   - statsSnapshot()/statsReport()/resetStats()：按格式汇总的解码统计（次数、平均耗时、峰值字节、完整解码所需字节）
+* 与该文件相关联的其他文件：thumbnailer.cpp, importpipeline.cpp, thumbnailloader.cpp, mainwindow.cpp
+*/
+
+#ifndef THUMBNAILER_H
+#define THUMBNAILER_H
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QHash>
+#include <QByteArray>
+
+struct ThumbnailFormatStats {
+    int count = 0;              // 解码次数
+    int scaledDecodes = 0;      // 其中直接按目标尺寸解码的次数
+    qint64 decodeNs = 0;        // 累计解码耗时（纳秒）
+    qint64 maxPeakBytes = 0;    // 单次解码出的最大图像字节数
+    qint64 totalPeakBytes = 0;  // 累计实际解码字节数
+    qint64 totalFullBytes = 0;  // 若完整解码原图所需的累计字节数（对照）
+};
+
+class Thumbnailer {
+public:
+
+    static QImage generate(const QString &path, const QSize &box);
+
+    static QHash<QByteArray, ThumbnailFormatStats> statsSnapshot();
+    static QString statsReport();
+    static void resetStats();
+};
+
+#endif // THUMBNAILER_H
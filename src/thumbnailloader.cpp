@@ -0,0 +1,108 @@
+#include "thumbnailloader.h"
+#include "importpipeline.h"
+#include "thumbnailcache.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+#include "trace.h"
+
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QFileInfo>
+#include <QThread>
+#include <QSet>
+
+struct ThumbnailTicket {
+    explicit ThumbnailTicket(int id) : id(id) {}
+    const int id;  // 回传时据此判断 m_pending 中是否仍是这张票（同一路径取消后可能已重新提交）
+    QAtomicInt cancelled;
+};
+
+namespace {
+
+class ThumbnailTask : public QRunnable {
+public:
+    ThumbnailTask(ThumbnailLoader *loader, const QSharedPointer<ThumbnailTicket> &ticket,
+                  const QSharedPointer<ThumbnailCache> &cache, const QString &path)
+        : m_loader(loader), m_ticket(ticket), m_cache(cache), m_path(path) {}
+
+    void run() override
+    {
+        TRACE_SCOPE(Trace::Thumbnail, "ThumbnailTask");
+        // 行已滚出预取范围：直接放弃，不做任何 IO
+        if (m_ticket->cancelled.loadAcquire()) return;
+        const QImage thumb = ImportPipeline::makeThumbnail(QFileInfo(m_path), m_cache.data());
+        // loader 析构时会等待线程池，因此这里的指针在任务运行期间一直有效
+        QMetaObject::invokeMethod(m_loader, "onTaskDone", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_path), Q_ARG(int, m_ticket->id), Q_ARG(QImage, thumb));
+    }
+
+private:
+    ThumbnailLoader *m_loader;
+    QSharedPointer<ThumbnailTicket> m_ticket;
+    QSharedPointer<ThumbnailCache> m_cache;
+    QString m_path;
+};
+
+} // namespace
+
+ThumbnailLoader::ThumbnailLoader(QObject *parent)
+    : QObject(parent)
+{
+    // 留一个核心给界面线程
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+ThumbnailLoader::~ThumbnailLoader()
+{
+    clear();
+    m_pool.waitForDone();
+}
+
+void ThumbnailLoader::request(const QStringList &paths)
+{
+    ++m_generation;
+    QSet<QString> wanted;
+    wanted.reserve(paths.size());
+    for (const QString &p : paths) wanted.insert(p);
+
+    // 取消已经不在窗口内的排队任务
+    int cancelled = 0;
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (!wanted.contains(it.key())) {
+            it.value()->cancelled.storeRelease(1);
+            it = m_pending.erase(it);
+            ++cancelled;
+        } else {
+            ++it;
+        }
+    }
+
+    // 同优先级按提交顺序执行，所以 paths 的顺序就是加载顺序
+    int submitted = 0;
+    for (const QString &p : paths) {
+        if (m_pending.contains(p)) continue;
+        QSharedPointer<ThumbnailTicket> ticket(new ThumbnailTicket(++m_lastTicket));
+        m_pending.insert(p, ticket);
+        m_pool.start(new ThumbnailTask(this, ticket, m_cache, p), m_generation);
+        ++submitted;
+    }
+    if (submitted || cancelled) {
+        DEBUG_LOG("Thumbnail request: submitted" << submitted << "cancelled" << cancelled
+                  << "pending" << m_pending.size());
+    }
+}
+
+void ThumbnailLoader::clear()
+{
+    for (const auto &ticket : qAsConst(m_pending)) {
+        ticket->cancelled.storeRelease(1);
+    }
+    m_pending.clear();
+}
+
+void ThumbnailLoader::onTaskDone(const QString &path, int ticket, const QImage &thumb)
+{
+    // 已取消但仍在执行的旧任务：结果照常交出，但不能删掉同一路径之后重新提交的新票，否则会再次提交
+    auto it = m_pending.find(path);
+    if (it != m_pending.end() && it.value()->id == ticket) m_pending.erase(it);
+    emit thumbnailReady(path, thumb);
+}
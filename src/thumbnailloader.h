@@ -0,0 +1,51 @@
+/*
+* 文件名：thumbnailloader.h
+* 日期：2026-10-16
+* 该文件功能大致描述：按需缩略图加载器。只为视图可见行及其预取窗口生成缩略图（先查磁盘缓存，未命中再解码），
+*                    在私有线程池中执行；新的请求会取消不再需要的排队任务，并优先于旧请求执行。
+* 该文件函数功能描述：
+*   - request()：提交按优先级排好序的路径列表（可见行在前，预取行在后），不在列表中的排队任务被取消
+*   - clear()：取消全部排队任务（重新加载库时使用）
+*   - thumbnailReady()：信号，某个路径的缩略图已生成（解码失败时为空图）
+* 与该文件相关联的其他文件：thumbnailloader.cpp, importpipeline.h, thumbnailcache.h, mainwindow.cpp, emojilistwidget.cpp
+*/
+
+#ifndef THUMBNAILLOADER_H
+#define THUMBNAILLOADER_H
+
+#include <QObject>
+#include <QImage>
+#include <QHash>
+#include <QStringList>
+#include <QThreadPool>
+#include <QSharedPointer>
+
+class ThumbnailCache;
+struct ThumbnailTicket;  // 前置声明：单个排队任务的取消标记
+
+class ThumbnailLoader : public QObject {
+    Q_OBJECT
+public:
+    explicit ThumbnailLoader(QObject *parent = nullptr);
+    ~ThumbnailLoader() override;
+
+    void setThumbnailCache(const QSharedPointer<ThumbnailCache> &cache) { m_cache = cache; }
+    void request(const QStringList &paths);
+    void clear();
+    int pendingCount() const { return m_pending.size(); }
+
+signals:
+    void thumbnailReady(const QString &path, const QImage &thumb);
+
+private slots:
+    void onTaskDone(const QString &path, int ticket, const QImage &thumb);
+
+private:
+    QThreadPool m_pool;
+    QSharedPointer<ThumbnailCache> m_cache;
+    QHash<QString, QSharedPointer<ThumbnailTicket>> m_pending;  // 排队中/执行中的任务
+    int m_generation = 0;  // 请求代数，作为线程池优先级：新请求先执行
+    int m_lastTicket = 0;  // 票据编号，每次提交递增
+};
+
+#endif // THUMBNAILLOADER_H
@@ -0,0 +1,364 @@
+#include "tiledimageview.h"
+#include "imagecache.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QImageReader>
+#include <QPainter>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QtMath>
+#include <QThread>
+
+struct TileTicket {
+    QAtomicInt cancelled;
+};
+
+namespace {
+
+const int kOverviewBox = 1024;  // 总览图的最大边长
+
+// 大图且格式支持 ClipRect 时逐块裁剪解码；否则完整解码一次（只读文件头判断）
+bool useClipDecode(QImageReader &reader)
+{
+    const QSize size = reader.size();
+    return size.isValid() && reader.supportsOption(QImageIOHandler::ClipRect)
+        && qint64(size.width()) * size.height() > TiledImageView::FullDecodePixels;
+}
+
+// 总览图：能逐块解码的大图按目标尺寸解码（JPEG 在 DCT 域缩小）；其他情况完整解码一次，总览图与切块都从它得到。
+// 缓存中已有完整解码的原图时（例如悬停时预热过）只做缩小
+class OverviewTask : public QRunnable {
+public:
+    OverviewTask(QObject *receiver, const QSharedPointer<TileTicket> &ticket, const QString &path, const QImage &source)
+        : m_receiver(receiver), m_ticket(ticket), m_path(path), m_source(source) {}
+
+    void run() override
+    {
+        // 预取已被取消（用户已经翻到别处）：直接放弃
+        if (m_ticket->cancelled.loadAcquire()) return;
+        QImageReader reader(m_path);
+        QImage overview, source = m_source;
+        if (!source.isNull() || !useClipDecode(reader)) {
+            if (source.isNull()) source = reader.read();
+            overview = source;
+            if (qMax(source.width(), source.height()) > kOverviewBox) {
+                overview = source.scaled(kOverviewBox, kOverviewBox, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            }
+        } else {
+            QSize size = reader.size();
+            size.scale(kOverviewBox, kOverviewBox, Qt::KeepAspectRatio);
+            reader.setScaledSize(size);
+            overview = reader.read();
+        }
+        // 视图析构时会等待线程池，因此这里的指针在任务运行期间一直有效
+        QMetaObject::invokeMethod(m_receiver, "onOverviewDecoded", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_path), Q_ARG(QImage, overview), Q_ARG(QImage, source));
+    }
+
+private:
+    QObject *m_receiver;
+    QSharedPointer<TileTicket> m_ticket;
+    QString m_path;
+    QImage m_source;  // 隐式共享，只读
+};
+
+class TileTask : public QRunnable {
+public:
+    TileTask(QObject *receiver, const QSharedPointer<TileTicket> &ticket, int generation, quint64 key,
+             const QString &path, const QRect &srcRect, const QSize &outSize, const QImage &source)
+        : m_receiver(receiver), m_ticket(ticket), m_generation(generation), m_key(key),
+          m_path(path), m_srcRect(srcRect), m_outSize(outSize), m_source(source) {}
+
+    void run() override
+    {
+        // 块已滚出视图或已切换图片：直接放弃
+        if (m_ticket->cancelled.loadAcquire()) return;
+        QImage tile;
+        if (!m_source.isNull()) {
+            tile = m_source.copy(m_srcRect);
+            if (tile.size() != m_outSize) tile = tile.scaled(m_outSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        } else {
+            // 只解码这一块：先裁剪原图区域，再缩放到本级的尺寸
+            QImageReader reader(m_path);
+            reader.setClipRect(m_srcRect);
+            reader.setScaledSize(m_outSize);
+            tile = reader.read();
+        }
+        QMetaObject::invokeMethod(m_receiver, "onTileDecoded", Qt::QueuedConnection,
+                                  Q_ARG(int, m_generation), Q_ARG(quint64, m_key), Q_ARG(QImage, tile));
+    }
+
+private:
+    QObject *m_receiver;
+    QSharedPointer<TileTicket> m_ticket;
+    int m_generation;
+    quint64 m_key;
+    QString m_path;
+    QRect m_srcRect;
+    QSize m_outSize;
+    QImage m_source;  // 隐式共享，只读
+};
+
+} // namespace
+
+TiledImageView::TiledImageView(QWidget *parent)
+    : QWidget(parent)
+{
+    m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 2));
+    setCursor(Qt::OpenHandCursor);
+}
+
+TiledImageView::~TiledImageView()
+{
+    cancelPending();
+    for (const auto &ticket : qAsConst(m_overviewing)) ticket->cancelled.storeRelease(1);
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void TiledImageView::cancelPending()
+{
+    for (const auto &ticket : qAsConst(m_pending)) ticket->cancelled.storeRelease(1);
+    m_pending.clear();
+}
+
+void TiledImageView::startOverview(const QString &path, int priority, const QImage &source)
+{
+    QSharedPointer<TileTicket> ticket(new TileTicket);
+    m_overviewing.insert(path, ticket);
+    m_pool.start(new OverviewTask(this, ticket, path, source), priority);
+}
+
+bool TiledImageView::lookupCached(const QString &path, QImage *overview, QImage *source)
+{
+    // 原图可能已在缓存中（悬停预热、复制）而总览图还没有：小图的总览图就是原图，大图仍需后台缩小
+    if (!m_images || !m_images->find(path, source, overview)) return false;
+    if (overview->isNull() && !source->isNull() && qMax(source->width(), source->height()) <= kOverviewBox) {
+        *overview = *source;
+    }
+    return !overview->isNull();
+}
+
+void TiledImageView::prefetch(const QStringList &paths)
+{
+    // 不再需要的排队预取取消（当前显示的图除外）；其余按列表顺序提交，排在当前图的块之后
+    for (auto it = m_overviewing.begin(); it != m_overviewing.end();) {
+        if (it.key() != m_path && !paths.contains(it.key())) {
+            it.value()->cancelled.storeRelease(1);
+            it = m_overviewing.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (const QString &p : paths) {
+        if (p.isEmpty() || m_overviewing.contains(p)) continue;
+        QImage overview, source;
+        if (!lookupCached(p, &overview, &source)) startOverview(p, 0, source);
+    }
+}
+
+void TiledImageView::setImagePath(const QString &path)
+{
+    ++m_generation;
+    cancelPending();  // 上一张图的块不再需要
+    m_tiles.clear();
+    m_source = QImage();
+    m_overview = QImage();
+    m_path = path;
+
+    QImageReader reader(path);
+    m_imageSize = reader.size();  // 只读文件头
+    if (!m_imageSize.isValid()) {
+        update();
+        return;
+    }
+    m_clipDecode = useClipDecode(reader);
+    m_maxLevel = 0;
+    while ((qMax(m_imageSize.width(), m_imageSize.height()) >> m_maxLevel) > TileSize) ++m_maxLevel;
+    m_userZoomed = false;
+    fitToView();
+    QImage overview, source;
+    const bool cached = lookupCached(path, &overview, &source);
+    m_source = source;  // 缓存中有完整解码的原图时，块直接从它切出
+    if (cached) {
+        m_overview = overview;  // 已预取：立即显示
+    } else if (!m_overviewing.contains(path)) {
+        startOverview(path, 3, source);  // 总览图优先于块与预取
+    }
+    DEBUG_LOG("Preview:" << path << m_imageSize << "levels:" << m_maxLevel + 1
+              << (m_clipDecode ? "clip decode" : "full decode"));
+    update();
+}
+
+QRect TiledImageView::tileSourceRect(int level, int tx, int ty) const
+{
+    const int span = TileSize << level;
+    return QRect(tx * span, ty * span, span, span) & QRect(QPoint(0, 0), m_imageSize);
+}
+
+int TiledImageView::levelForZoom() const
+{
+    // 选择分辨率仍不低于屏幕需要的最粗一级
+    const qreal need = m_zoom * devicePixelRatioF();
+    int level = 0;
+    while (level < m_maxLevel && need <= 1.0 / (1 << (level + 1))) ++level;
+    return level;
+}
+
+void TiledImageView::fitToView()
+{
+    if (isEmpty() || width() <= 0 || height() <= 0) return;
+    // 与原来一样占视图的 90%，小表情会被放大显示
+    m_fitZoom = 0.9 * qMin(width() / qreal(m_imageSize.width()), height() / qreal(m_imageSize.height()));
+    m_zoom = m_fitZoom;
+    clampOffset();
+}
+
+void TiledImageView::clampOffset()
+{
+    const QSizeF scaled = QSizeF(m_imageSize) * m_zoom;
+    // 图比视图小时居中；否则不允许拖出空白
+    if (scaled.width() <= width()) m_offset.setX((width() - scaled.width()) / 2);
+    else m_offset.setX(qBound(width() - scaled.width(), m_offset.x(), 0.0));
+    if (scaled.height() <= height()) m_offset.setY((height() - scaled.height()) / 2);
+    else m_offset.setY(qBound(height() - scaled.height(), m_offset.y(), 0.0));
+}
+
+void TiledImageView::setZoom(qreal zoom, const QPointF &anchor)
+{
+    if (isEmpty()) return;
+    zoom = qBound(m_fitZoom * 0.25, zoom, qMax<qreal>(m_fitZoom, 1.0) * 16);
+    const QPointF imagePoint = (anchor - m_offset) / m_zoom;  // 光标下的原图坐标保持不动
+    m_zoom = zoom;
+    m_offset = anchor - imagePoint * zoom;
+    m_userZoomed = true;
+    clampOffset();
+    update();
+}
+
+void TiledImageView::paintEvent(QPaintEvent *)
+{
+    QPainter p(this);
+    if (isEmpty()) return;
+    p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+
+    // 低分辨率总览图垫底，缺少的块先显示模糊版本
+    if (!m_overview.isNull()) p.drawImage(QRectF(m_offset, QSizeF(m_imageSize) * m_zoom), m_overview);
+    if (!m_clipDecode && m_source.isNull()) return;  // 完整解码尚未完成
+
+    const int level = levelForZoom();
+    const int span = TileSize << level;
+    const QRect visible = QRectF(-m_offset / m_zoom, QSizeF(size()) / m_zoom).toAlignedRect()
+                        & QRect(QPoint(0, 0), m_imageSize);
+    if (visible.isEmpty()) return;
+
+    QHash<quint64, QPixmap> kept;
+    QHash<quint64, QSharedPointer<TileTicket>> wanted;
+    for (int ty = visible.top() / span; ty <= visible.bottom() / span; ++ty) {
+        for (int tx = visible.left() / span; tx <= visible.right() / span; ++tx) {
+            const quint64 key = tileKey(level, tx, ty);
+            const QRect src = tileSourceRect(level, tx, ty);
+            auto hit = m_tiles.constFind(key);
+            if (hit != m_tiles.constEnd()) {
+                p.drawPixmap(QRectF(m_offset + QPointF(src.topLeft()) * m_zoom, QSizeF(src.size()) * m_zoom),
+                             hit.value(), QRectF(hit.value().rect()));
+                kept.insert(key, hit.value());
+                continue;
+            }
+            auto pending = m_pending.constFind(key);
+            if (pending != m_pending.constEnd()) {
+                wanted.insert(key, pending.value());
+                continue;
+            }
+            QSharedPointer<TileTicket> ticket(new TileTicket);
+            const QSize out((src.width() + (1 << level) - 1) >> level, (src.height() + (1 << level) - 1) >> level);
+            m_pool.start(new TileTask(this, ticket, m_generation, key, m_path, src, out, m_source), 2);
+            wanted.insert(key, ticket);
+        }
+    }
+    // 只保留可见的块；不再可见的排队任务取消
+    m_tiles.swap(kept);
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        if (!wanted.contains(it.key())) it.value()->cancelled.storeRelease(1);
+    }
+    m_pending.swap(wanted);
+}
+
+void TiledImageView::onOverviewDecoded(const QString &path, const QImage &overview, const QImage &source)
+{
+    m_overviewing.remove(path);
+    if (overview.isNull()) return;
+    if (m_images) m_images->insert(path, source, overview);  // 按实际字节数计入共享缓存的上限
+    if (path == m_path && m_overview.isNull()) {  // 正是当前显示的图
+        m_overview = overview;
+        if (!source.isNull()) m_source = source;
+        update();
+    }
+}
+
+void TiledImageView::onTileDecoded(int generation, quint64 key, const QImage &tile)
+{
+    if (generation != m_generation || !m_pending.remove(key) || tile.isNull()) return;
+    m_tiles.insert(key, QPixmap::fromImage(tile));
+    update();
+}
+
+void TiledImageView::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    if (!m_userZoomed) fitToView();
+    else clampOffset();
+}
+
+void TiledImageView::wheelEvent(QWheelEvent *event)
+{
+    if (!(event->modifiers() & Qt::ControlModifier)) {
+        event->ignore();  // 交给 PreviewDialog：切换上一张/下一张
+        return;
+    }
+    // Ctrl+滚轮：每一格缩放 1.25 倍，以光标为中心
+    const qreal steps = event->angleDelta().y() / 120.0;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    const QPointF anchor = event->position();
+#else
+    const QPointF anchor = event->posF();
+#endif
+    setZoom(m_zoom * qPow(1.25, steps), anchor);
+    event->accept();
+}
+
+void TiledImageView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    m_dragging = true;
+    m_dragFrom = event->pos();
+    setCursor(Qt::ClosedHandCursor);
+}
+
+void TiledImageView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!m_dragging) return;
+    m_offset += event->pos() - m_dragFrom;
+    m_dragFrom = event->pos();
+    m_userZoomed = true;
+    clampOffset();
+    update();
+}
+
+void TiledImageView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_dragging = false;
+        setCursor(Qt::OpenHandCursor);
+    }
+}
+
+void TiledImageView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    event->ignore();  // 交给 PreviewDialog：双击关闭
+}
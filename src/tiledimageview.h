@@ -0,0 +1,92 @@
+/*
+* 文件名：tiledimageview.h
+* 日期：2026-10-16
+* 该文件功能大致描述：预览对话框中的分块图像视图。图像按金字塔分级（第 L 级为原图的 1/2^L），每级切成 256px 的块，
+*                    在后台线程中解码：支持 ClipRect 的格式（JPEG 等）每块用 QImageReader::setClipRect + setScaledSize
+*                    只解码需要的区域；其他格式（PNG 等）或小图先在后台完整解码一次，块从中切出。打开时先显示一张低分辨率总览图，
+*                    随后可见的块逐步替换为清晰的块。Ctrl+滚轮以光标为中心缩放，左键拖动平移；内存中只保留当前可见的块。
+*                    相邻图片的总览图（小图连同完整解码结果）可以预先在后台解码，切换时立即显示。解码结果放进共享的
+*                    ImageCache，与复制/拖出共用一个内存上限；悬停时已预热的原图在这里也直接命中。
+* 该文件函数功能描述：
+*   - setImageCache()：设置共享的原图缓存（为空时不保留预取结果）
+*   - setImagePath()：切换到另一张图（之前未完成的块解码全部作废；已缓存的图直接显示，正在预取的图等待其结果）
+*   - prefetch()：预取一组图片（按优先顺序），不在列表中的排队预取被取消；结果放入 ImageCache，按其字节上限 LRU 保留
+*   - paintEvent()：先画总览图，再画已解码的可见块；缺少的块提交后台解码，不再可见的块与排队任务被丢弃
+*   - wheelEvent()/mousePressEvent()/mouseMoveEvent()：Ctrl+滚轮缩放、拖动平移；不带 Ctrl 的滚轮与双击交给父窗口（切换图片 / 关闭预览）
+* 与该文件相关联的其他文件：tiledimageview.cpp, previewdialog.h, previewdialog.cpp, imagecache.h
+*/
+
+#ifndef TILEDIMAGEVIEW_H
+#define TILEDIMAGEVIEW_H
+
+#include <QWidget>
+#include <QImage>
+#include <QPixmap>
+#include <QHash>
+#include <QStringList>
+#include <QThreadPool>
+#include <QSharedPointer>
+
+struct TileTicket;  // 前置声明：单个排队任务的取消标记
+class ImageCache;
+
+class TiledImageView : public QWidget {
+    Q_OBJECT
+public:
+    static const int TileSize = 256;
+    static const qint64 FullDecodePixels = 4LL * 1024 * 1024;  // 不超过该像素数的图直接完整解码
+
+    explicit TiledImageView(QWidget *parent = nullptr);
+    ~TiledImageView() override;
+
+    void setImageCache(ImageCache *images) { m_images = images; }
+    void setImagePath(const QString &path);
+    void prefetch(const QStringList &paths);
+    QString imagePath() const { return m_path; }
+    bool isEmpty() const { return !m_imageSize.isValid(); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private slots:
+    void onOverviewDecoded(const QString &path, const QImage &overview, const QImage &source);
+    void onTileDecoded(int generation, quint64 key, const QImage &tile);
+
+private:
+    static quint64 tileKey(int level, int tx, int ty) { return (quint64(level) << 48) | (quint64(ty) << 24) | quint64(tx); }
+    QRect tileSourceRect(int level, int tx, int ty) const;  // 块在原图中的区域
+    void startOverview(const QString &path, int priority, const QImage &source);
+    bool lookupCached(const QString &path, QImage *overview, QImage *source);
+    int levelForZoom() const;
+    void fitToView();
+    void setZoom(qreal zoom, const QPointF &anchor);
+    void clampOffset();
+    void cancelPending();
+
+    QThreadPool m_pool;
+    QString m_path;
+    QSize m_imageSize;         // 原图尺寸（只读文件头得到）
+    bool m_clipDecode = false; // true：逐块裁剪解码；false：从完整解码的 m_source 中切块
+    QImage m_source;           // 完整解码的原图（只在 m_clipDecode 为 false 时存在）
+    QImage m_overview;         // 低分辨率总览图
+    int m_maxLevel = 0;
+    int m_generation = 0;      // 每次切换图片递增，丢弃旧图片的解码结果
+    qreal m_zoom = 1.0;        // 显示像素 / 原图像素
+    qreal m_fitZoom = 1.0;
+    bool m_userZoomed = false; // 用户缩放/平移过：调整窗口大小时不再自动适配
+    QPointF m_offset;          // 原图左上角在控件中的位置
+    QPoint m_dragFrom;
+    bool m_dragging = false;
+    QHash<quint64, QPixmap> m_tiles;                          // 当前可见的块
+    QHash<quint64, QSharedPointer<TileTicket>> m_pending;     // 排队中/执行中的块
+    ImageCache *m_images = nullptr;                           // 共享的原图缓存：已解码的总览图与原图（含当前与相邻图片）
+    QHash<QString, QSharedPointer<TileTicket>> m_overviewing; // 排队中/执行中的总览图解码（每个文件至多一个）
+};
+
+#endif // TILEDIMAGEVIEW_H
@@ -0,0 +1,207 @@
+#include "trace.h"
+#include "emoji_meta.h"  // for DEBUG_LOG
+
+#include <QMutex>
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
+#include <QThread>
+#include <QSaveFile>
+#include <atomic>
+#include <algorithm>
+
+QBasicAtomicInt Trace::g_recording = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+namespace {
+
+struct Event {
+    const char *name;
+    qint64 ts;     // 纳秒（steady_clock）
+    qint64 value;  // 完整事件为持续时间（纳秒），计数器为值
+    quint32 category;
+    quint32 tid;
+    char phase;    // 'X' 完整事件，'C' 计数器，'i' 时间点
+};
+
+// 一个线程独占写入的环形缓冲区；线程退出后归还，由之后新建的线程复用
+struct ThreadBuffer {
+    static const int Capacity = 1 << 14;  // 每个线程最多保留最近的 16K 个事件
+    Event events[Capacity];
+    std::atomic<quint64> head{0};  // 已写入的事件总数；只有所属线程写，导出时读
+    quint32 tid = 0;
+};
+
+QMutex g_mutex;                          // 只在分配/归还缓冲区、开始录制与导出时使用
+QVector<ThreadBuffer *> g_buffers;       // 全部缓冲区（不释放）
+QVector<ThreadBuffer *> g_free;          // 所属线程已退出的缓冲区
+QHash<quint32, QByteArray> g_threadNames;
+quint32 g_nextTid = 1;
+qint64 g_startNs = 0;
+
+ThreadBuffer *acquireBuffer()
+{
+    QMutexLocker lock(&g_mutex);
+    ThreadBuffer *b;
+    if (!g_free.isEmpty()) {
+        b = g_free.takeLast();
+    } else {
+        b = new ThreadBuffer;
+        g_buffers.append(b);
+    }
+    // 复用的缓冲区中旧线程的事件保留原来的 tid，新事件使用新的 tid
+    b->tid = g_nextTid++;
+    QThread *t = QThread::currentThread();
+    QByteArray name = t ? t->objectName().toUtf8() : QByteArray();
+    if (name.isEmpty()) name = "Thread " + QByteArray::number(b->tid);
+    g_threadNames.insert(b->tid, name);
+    return b;
+}
+
+struct BufferHolder {
+    ThreadBuffer *buffer = nullptr;
+    ~BufferHolder()
+    {
+        if (!buffer) return;
+        QMutexLocker lock(&g_mutex);
+        g_free.append(buffer);
+    }
+};
+
+thread_local BufferHolder t_holder;
+
+void record(const Event &e)
+{
+    // 第一次在录制期间记录事件时才分配缓冲区：从不追踪的线程不占内存
+    ThreadBuffer *b = t_holder.buffer;
+    if (!b) b = t_holder.buffer = acquireBuffer();
+    const quint64 h = b->head.load(std::memory_order_relaxed);
+    Event &slot = b->events[h & (ThreadBuffer::Capacity - 1)];
+    slot = e;
+    slot.tid = b->tid;
+    b->head.store(h + 1, std::memory_order_release);
+}
+
+const char *categoryName(quint32 category)
+{
+    switch (category) {
+    case Trace::Import: return "import";
+    case Trace::Library: return "library";
+    case Trace::Model: return "model";
+    case Trace::Paint: return "paint";
+    case Trace::Input: return "input";
+    case Trace::Thumbnail: return "thumbnail";
+    case Trace::Startup: return "startup";
+    default: return "other";
+    }
+}
+
+void appendJsonString(QByteArray &out, const QByteArray &s)
+{
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+QByteArray micros(qint64 ns)
+{
+    return QByteArray::number(ns / 1000.0, 'f', 3);
+}
+
+} // namespace
+
+void Trace::start()
+{
+    QMutexLocker lock(&g_mutex);
+    g_recording.storeRelease(0);
+    for (ThreadBuffer *b : qAsConst(g_buffers)) b->head.store(0, std::memory_order_relaxed);
+    g_startNs = now();
+    g_recording.storeRelease(1);
+    DEBUG_LOG("Trace recording started");
+}
+
+void Trace::stop()
+{
+    g_recording.storeRelease(0);
+}
+
+void Trace::complete(quint32 category, const char *name, qint64 startNs, qint64 endNs)
+{
+    record(Event{name, startNs, endNs - startNs, category, 0, 'X'});
+}
+
+void Trace::counter(quint32 category, const char *name, qint64 value)
+{
+    record(Event{name, now(), value, category, 0, 'C'});
+}
+
+void Trace::instant(quint32 category, const char *name)
+{
+    record(Event{name, now(), 0, category, 0, 'i'});
+}
+
+bool Trace::writeChromeTrace(const QString &path)
+{
+    stop();
+    QVector<Event> events;
+    QHash<quint32, QByteArray> names;
+    qint64 base;
+    {
+        QMutexLocker lock(&g_mutex);
+        for (ThreadBuffer *b : qAsConst(g_buffers)) {
+            const quint64 head = b->head.load(std::memory_order_acquire);
+            // 停止录制的瞬间可能还有一次写入正在进行，它写的是 head 位置（即最旧的那一格）：跳过这一格
+            const quint64 n = qMin<quint64>(head, ThreadBuffer::Capacity - 1);
+            for (quint64 i = head - n; i < head; ++i) events.append(b->events[i & (ThreadBuffer::Capacity - 1)]);
+        }
+        names = g_threadNames;
+        base = g_startNs;
+    }
+    std::sort(events.begin(), events.end(), [](const Event &a, const Event &b) { return a.ts < b.ts; });
+
+    QByteArray out;
+    out.reserve(events.size() * 96 + 4096);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (auto it = names.constBegin(); it != names.constEnd(); ++it) {
+        if (!first) out += ",\n";
+        first = false;
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + QByteArray::number(it.key())
+               + ",\"args\":{\"name\":";
+        appendJsonString(out, it.value());
+        out += "}}";
+    }
+    for (const Event &e : qAsConst(events)) {
+        if (e.ts < base) continue;  // 开始录制之前就在进行的作用域
+        if (!first) out += ",\n";
+        first = false;
+        out += "{\"name\":";
+        appendJsonString(out, QByteArray(e.name));
+        out += ",\"cat\":\"";
+        out += categoryName(e.category);
+        out += "\",\"ph\":\"";
+        out += e.phase;
+        out += "\",\"pid\":1,\"tid\":" + QByteArray::number(e.tid) + ",\"ts\":" + micros(e.ts - base);
+        if (e.phase == 'X') out += ",\"dur\":" + micros(e.value);
+        else if (e.phase == 'C') out += ",\"args\":{\"value\":" + QByteArray::number(e.value) + '}';
+        else out += ",\"s\":\"t\"";
+        out += '}';
+    }
+    out += "\n]}\n";
+
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly) || f.write(out) != out.size() || !f.commit()) {
+        DEBUG_LOG("Failed to write trace:" << path);
+        return false;
+    }
+    DEBUG_LOG("Trace written:" << path << events.size() << "events");
+    return true;
+}
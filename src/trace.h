@@ -0,0 +1,111 @@
+/*
+* 文件名：trace.h
+* 日期：2026-10-16
+* 该文件功能大致描述：低开销的结构化追踪，取代用 DEBUG_LOG 打印耗时。TRACE_SCOPE 记录一段代码的起止时间（Chrome trace 的
+*                    完整事件），TRACE_COUNTER 记录计数器的值，TRACE_INSTANT 记录时间点。每个线程写自己的环形缓冲区
+*                    （单写者，无锁；写满后覆盖最旧的事件），事件名必须是字符串字面量，记录时不分配内存。
+*                    类别在编译期过滤：EMOJI_TRACE_CATEGORIES 中没有的类别，宏展开后不产生任何代码；编译进来的类别
+*                    在未录制时只多一次原子读。录制结果导出为 Chrome trace / Perfetto 可以打开的 JSON。
+* 该文件函数功能描述：
+*   - Category：追踪类别（位掩码）
+*   - compiledIn()：某类别是否编译进来（编译期常量）
+*   - isRecording()：是否正在录制
+*   - start()/stop()：开始录制（清空之前的事件）/ 停止录制
+*   - writeChromeTrace()：停止录制并把各线程缓冲区中的事件写成 JSON（chrome://tracing 或 ui.perfetto.dev 打开）
+*   - TRACE_SCOPE/TRACE_COUNTER/TRACE_INSTANT：记录宏
+* 与该文件相关联的其他文件：trace.cpp, main.cpp, mainwindow.cpp 及各处记录追踪事件的文件
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QAtomicInt>
+#include <chrono>
+
+// 编译进来的类别（位掩码）；例如 DEFINES += EMOJI_TRACE_CATEGORIES=0 去掉全部追踪，=0x8 只保留绘制
+#ifndef EMOJI_TRACE_CATEGORIES
+#define EMOJI_TRACE_CATEGORIES 0xffffffffu
+#endif
+
+namespace Trace {
+
+enum Category : quint32 {
+    Import    = 1u << 0,  // 导入流水线、目录遍历
+    Library   = 1u << 1,  // 表情库读写（快照、日志、SQLite）
+    Model     = 1u << 2,  // 模型重建、排序、过滤、删除
+    Paint     = 1u << 3,  // 委托绘制
+    Input     = 1u << 4,  // 鼠标与键盘事件
+    Thumbnail = 1u << 5,  // 缩略图解码与缓存
+    Startup   = 1u << 6   // 启动阶段
+};
+
+constexpr bool compiledIn(quint32 category) { return (EMOJI_TRACE_CATEGORIES & category) != 0; }
+
+extern QBasicAtomicInt g_recording;
+inline bool isRecording() { return g_recording.loadAcquire() != 0; }
+
+inline qint64 now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void start();
+void stop();
+bool writeChromeTrace(const QString &path);
+
+// 记录函数：调用方已经检查过 isRecording()
+void complete(quint32 category, const char *name, qint64 startNs, qint64 endNs);
+void counter(quint32 category, const char *name, qint64 value);
+void instant(quint32 category, const char *name);
+
+template <bool Enabled> class ScopedSpan;
+
+template <> class ScopedSpan<false> {
+public:
+    ScopedSpan(quint32, const char *) {}
+};
+
+template <> class ScopedSpan<true> {
+public:
+    ScopedSpan(quint32 category, const char *name)
+        : m_category(category), m_name(name), m_start(isRecording() ? now() : -1) {}
+    ~ScopedSpan()
+    {
+        if (m_start >= 0) complete(m_category, m_name, m_start, now());
+    }
+    ScopedSpan(const ScopedSpan &) = delete;
+    ScopedSpan &operator=(const ScopedSpan &) = delete;
+
+private:
+    quint32 m_category;
+    const char *m_name;
+    qint64 m_start;  // -1 表示开始时未在录制
+};
+
+} // namespace Trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// 作用域内的耗时；name 必须是字符串字面量
+#define TRACE_SCOPE(category, name) \
+    Trace::ScopedSpan<Trace::compiledIn(category)> TRACE_CONCAT(traceSpan_, __LINE__)((category), (name))
+
+#define TRACE_COUNTER(category, name, value) \
+    do { \
+        if constexpr (Trace::compiledIn(category)) { \
+            if (Trace::isRecording()) Trace::counter((category), (name), (value)); \
+        } \
+    } while (0)
+
+#define TRACE_INSTANT(category, name) \
+    do { \
+        if constexpr (Trace::compiledIn(category)) { \
+            if (Trace::isRecording()) Trace::instant((category), (name)); \
+        } \
+    } while (0)
+
+#endif // TRACE_H
@@ -0,0 +1,72 @@
+#include "benchrunner.h"
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QThread>
+#include <QTextStream>
+#include <algorithm>
+
+void BenchRunner::run(const QString &name, int n, const std::function<void()> &setup, const std::function<void()> &body)
+{
+    if (!m_filter.isEmpty() && !name.contains(m_filter)) return;
+    QVector<double> samples;
+    qint64 totalNs = 0;
+    QElapsedTimer timer;
+    while (samples.size() < MaxIterations
+           && (samples.size() < MinIterations || totalNs < qint64(m_minTimeMs) * 1000000)) {
+        if (setup) setup();
+        timer.start();
+        body();
+        const qint64 ns = timer.nsecsElapsed();
+        totalNs += ns;
+        samples.append(ns / 1e6);
+    }
+    std::sort(samples.begin(), samples.end());
+    Result r;
+    r.name = name;
+    r.n = n;
+    r.iterations = samples.size();
+    r.minMs = samples.first();
+    r.medianMs = samples.at(samples.size() / 2);
+    r.meanMs = totalNs / 1e6 / samples.size();
+    m_results.append(r);
+
+    QTextStream(stderr) << QString("%1 n=%2: median %3 ms, min %4 ms (%5 iterations)\n")
+                               .arg(name, -28).arg(n).arg(r.medianMs, 0, 'f', 3).arg(r.minMs, 0, 'f', 3)
+                               .arg(r.iterations);
+}
+
+QJsonObject BenchRunner::toJson() const
+{
+    QJsonArray results;
+    for (const Result &r : m_results) {
+        QJsonObject o;
+        o["name"] = r.name;
+        o["n"] = r.n;
+        o["iterations"] = r.iterations;
+        o["min_ms"] = r.minMs;
+        o["median_ms"] = r.medianMs;
+        o["mean_ms"] = r.meanMs;
+        results.append(o);
+    }
+    QJsonObject env;
+    env["qt"] = QString::fromLatin1(qVersion());
+    env["os"] = QSysInfo::prettyProductName();
+    env["cpu"] = QSysInfo::currentCpuArchitecture();
+    env["threads"] = QThread::idealThreadCount();
+#ifdef QT_DEBUG
+    env["build"] = "debug";
+#else
+    env["build"] = "release";
+#endif
+    QJsonObject root;
+    root["tool"] = "emojibench";
+    root["format"] = 1;
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["min_time_ms"] = m_minTimeMs;
+    root["environment"] = env;
+    root["results"] = results;
+    return root;
+}
@@ -0,0 +1,47 @@
+/*
+* 文件名：benchrunner.h
+* 日期：2026-10-16
+* 该文件功能大致描述：基准测试的计时与结果收集，语义与 QBENCHMARK 相同：同一个用例反复执行，直到累计时间达到下限
+*                    （且至少执行 MinIterations 次），报告单次耗时的最小值、中位数与平均值。准备工作（setup）不计时，
+*                    每次执行前都重新准备，测量的总是同一个起始状态。结果以 JSON 输出，便于不同版本之间比较。
+* 该文件函数功能描述：
+*   - BenchRunner::run()：执行一个用例；名称不匹配过滤条件时跳过
+*   - BenchRunner::toJson()：全部结果（含运行环境）
+* 与该文件相关联的其他文件：benchrunner.cpp, main.cpp
+*/
+
+#ifndef BENCHRUNNER_H
+#define BENCHRUNNER_H
+
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <functional>
+
+class BenchRunner {
+public:
+    struct Result {
+        QString name;
+        int n = 0;           // 数据规模（条目数）
+        int iterations = 0;
+        double minMs = 0;
+        double medianMs = 0;
+        double meanMs = 0;
+    };
+
+    static const int MinIterations = 3;
+    static const int MaxIterations = 1000;
+
+    BenchRunner(int minTimeMs, const QString &filter) : m_minTimeMs(minTimeMs), m_filter(filter) {}
+
+    void run(const QString &name, int n, const std::function<void()> &setup, const std::function<void()> &body);
+    const QVector<Result> &results() const { return m_results; }
+    QJsonObject toJson() const;
+
+private:
+    int m_minTimeMs;
+    QString m_filter;
+    QVector<Result> m_results;
+};
+
+#endif // BENCHRUNNER_H
@@ -0,0 +1,335 @@
+#include "corpusgenerator.h"
+#include "librarystore.h"
+#include "contenthash.h"
+
+#include <QRandomGenerator>
+#include <QPainter>
+#include <QBuffer>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+namespace {
+
+enum Format { Png, Jpeg, Gif };
+
+struct FilePlan {
+    Format format = Png;
+    int width = 0;
+    int height = 0;
+    int duplicateOf = -1;  // 与该序号的文件字节相同
+    QDateTime time;
+};
+
+// 每个文件用自己的种子：并行生成与生成顺序无关，结果可复现
+FilePlan planFile(const CorpusOptions &o, int i)
+{
+    QRandomGenerator rng(o.seed * 1000003u + quint32(i));
+    FilePlan p;
+    if (i > 0 && rng.generateDouble() < o.duplicateShare) p.duplicateOf = rng.bounded(i);
+    const double f = rng.generateDouble();
+    p.format = f < o.pngShare ? Png : (f < o.pngShare + o.jpegShare ? Jpeg : Gif);
+    // 表情包以小图为主：70% 96–320px，25% 320–640px，5% 640–1600px；GIF 不超过 480px
+    const double s = rng.generateDouble();
+    int side = s < 0.70 ? 96 + rng.bounded(224) : (s < 0.95 ? 320 + rng.bounded(320) : 640 + rng.bounded(960));
+    if (p.format == Gif) side = qMin(side, 480);
+    p.width = side;
+    p.height = qMax(32, int(side * (0.75 + rng.generateDouble() * 0.58)));
+    p.time = QDateTime(QDate(2020, 1, 1), QTime(0, 0), Qt::UTC).addSecs(rng.bounded(5 * 365 * 86400));
+    return p;
+}
+
+QString relativePath(int i, Format format)
+{
+    static const char *const ext[] = { "png", "jpg", "gif" };
+    return QString("%1/sticker_%2.%3").arg(i / 1000, 4, 10, QLatin1Char('0'))
+                                      .arg(i, 6, 10, QLatin1Char('0')).arg(QLatin1String(ext[format]));
+}
+
+QImage drawFrame(const FilePlan &p, quint32 seed, int frame)
+{
+    QRandomGenerator rng(seed);
+    const bool transparent = p.format == Png && rng.bounded(10) < 4;
+    QImage img(p.width, p.height, p.format == Png ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    img.fill(transparent ? QColor(Qt::transparent) : QColor::fromHsv(rng.bounded(360), 40 + rng.bounded(80), 230));
+    QPainter painter(&img);
+    painter.setRenderHint(QPainter::Antialiasing);
+    const int shapes = 3 + rng.bounded(6);
+    for (int k = 0; k < shapes; ++k) {
+        painter.setBrush(QColor::fromHsv(rng.bounded(360), 120 + rng.bounded(135), 120 + rng.bounded(135)));
+        painter.setPen(QPen(Qt::black, 1 + rng.bounded(4)));
+        const int w = p.width / 6 + rng.bounded(qMax(1, p.width / 2));
+        const int h = p.height / 6 + rng.bounded(qMax(1, p.height / 2));
+        const int x = rng.bounded(qMax(1, p.width - w)) + frame * (k % 3 - 1) * 4;  // 各帧略有位移
+        const int y = rng.bounded(qMax(1, p.height - h)) + frame * 3;
+        switch (rng.bounded(3)) {
+        case 0: painter.drawEllipse(x, y, w, h); break;
+        case 1: painter.drawRect(x, y, w, h); break;
+        default: painter.drawRoundedRect(x, y, w, h, w / 4.0, h / 4.0); break;
+        }
+    }
+    static const char *const captions[] = { "OK", "?!", "233", "hhh", "666", "GG" };
+    QFont font = painter.font();
+    font.setPixelSize(qMax(10, p.height / 5));
+    font.setBold(true);
+    painter.setFont(font);
+    painter.setPen(Qt::white);
+    painter.drawText(img.rect().adjusted(0, 0, 0, -p.height / 10), Qt::AlignHCenter | Qt::AlignBottom,
+                     QString::fromLatin1(captions[rng.bounded(6)]));
+    return img;
+}
+
+QByteArray encodeFile(const FilePlan &p, quint32 seed)
+{
+    QByteArray bytes;
+    if (p.format == Gif) {
+        QVector<QImage> frames;
+        const int n = 2 + int(seed % 3);
+        for (int f = 0; f < n; ++f) frames.append(drawFrame(p, seed, f));
+        return CorpusGenerator::encodeGif(frames, 10);
+    }
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    drawFrame(p, seed, 0).save(&buffer, p.format == Png ? "PNG" : "JPG", p.format == Png ? -1 : 85);
+    return bytes;
+}
+
+quint64 hashBytes(const QByteArray &bytes)
+{
+    ContentHash h;
+    h.update(reinterpret_cast<const uchar *>(bytes.constData()), bytes.size());
+    return h.digest();
+}
+
+class GenerateTask : public QRunnable {
+public:
+    GenerateTask(const CorpusOptions &o, QVector<LibraryRecord> *records, QVector<FilePlan> *plans, int first, int stride)
+        : m_o(o), m_records(records), m_plans(plans), m_first(first), m_stride(stride) {}
+
+    void run() override
+    {
+        // 每个任务只写自己负责的序号，records/plans 已预先分配好大小
+        for (int i = m_first; i < m_o.count; i += m_stride) {
+            const FilePlan &p = m_plans->at(i);
+            if (p.duplicateOf >= 0) continue;  // 副本在所有原件写完之后复制
+            const QByteArray bytes = encodeFile(p, m_o.seed * 1000003u + quint32(i));
+            LibraryRecord &rec = (*m_records)[i];
+            QFile f(rec.path);
+            if (!f.open(QIODevice::WriteOnly) || f.write(bytes) != bytes.size()) continue;
+            rec.size = bytes.size();
+            rec.hash = hashBytes(bytes);
+        }
+    }
+
+private:
+    CorpusOptions m_o;
+    QVector<LibraryRecord> *m_records;
+    QVector<FilePlan> *m_plans;
+    int m_first;
+    int m_stride;
+};
+
+// GIF 的 LZW 压缩：只输出字面码，每 LiteralRun 个码之后发一次清除码，码宽恒为 9 位。
+// 文件比真正压缩的大一些，但编码简单，任何解码器都能读
+class GifBitWriter {
+public:
+    explicit GifBitWriter(QByteArray *out) : m_out(out) {}
+    void put(int code)
+    {
+        m_acc |= quint32(code) << m_bits;
+        m_bits += 9;
+        while (m_bits >= 8) {
+            byte(m_acc & 0xff);
+            m_acc >>= 8;
+            m_bits -= 8;
+        }
+    }
+    void finish()
+    {
+        if (m_bits > 0) byte(m_acc & 0xff);
+        if (m_blockLen > 0) flushBlock();
+        m_out->append(char(0));  // 数据子块结束
+    }
+
+private:
+    void byte(quint32 b)
+    {
+        m_block[m_blockLen++] = char(b);
+        if (m_blockLen == 255) flushBlock();
+    }
+    void flushBlock()
+    {
+        m_out->append(char(m_blockLen));
+        m_out->append(m_block, m_blockLen);
+        m_blockLen = 0;
+    }
+
+    QByteArray *m_out;
+    quint32 m_acc = 0;
+    int m_bits = 0;
+    char m_block[255];
+    int m_blockLen = 0;
+};
+
+void appendLe16(QByteArray &out, int v)
+{
+    out.append(char(v & 0xff));
+    out.append(char((v >> 8) & 0xff));
+}
+
+} // namespace
+
+QString CorpusGenerator::snapshotPath(const QString &dir)
+{
+    return QDir(dir).filePath("emoji_data.json");
+}
+
+QByteArray CorpusGenerator::encodeGif(const QVector<QImage> &frames, int delayCs)
+{
+    if (frames.isEmpty()) return QByteArray();
+    const int w = frames.first().width(), h = frames.first().height();
+    // 固定的 6×6×6 色立方调色板（补齐到 256 色）
+    QVector<QRgb> palette;
+    for (int r = 0; r < 6; ++r)
+        for (int g = 0; g < 6; ++g)
+            for (int b = 0; b < 6; ++b) palette.append(qRgb(r * 51, g * 51, b * 51));
+    while (palette.size() < 256) palette.append(qRgb(0, 0, 0));
+
+    QByteArray out("GIF89a");
+    appendLe16(out, w);
+    appendLe16(out, h);
+    out.append(char(0xF7));  // 全局调色板，256 色
+    out.append(char(0));
+    out.append(char(0));
+    for (QRgb c : qAsConst(palette)) {
+        out.append(char(qRed(c)));
+        out.append(char(qGreen(c)));
+        out.append(char(qBlue(c)));
+    }
+    if (frames.size() > 1) {
+        // NETSCAPE2.0：无限循环
+        out.append("\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00", 19);
+    }
+
+    static const int ClearCode = 256, EndCode = 257, LiteralRun = 250;
+    for (const QImage &frame : frames) {
+        const QImage indexed = frame.convertToFormat(QImage::Format_RGB32)
+                                    .convertToFormat(QImage::Format_Indexed8, palette, Qt::ThresholdDither);
+        out.append("\x21\xF9\x04\x00", 4);  // 图形控制扩展：帧延迟
+        appendLe16(out, delayCs);
+        out.append(char(0));
+        out.append(char(0));
+        out.append(char(0x2C));             // 图像描述符
+        appendLe16(out, 0);
+        appendLe16(out, 0);
+        appendLe16(out, w);
+        appendLe16(out, h);
+        out.append(char(0));
+        out.append(char(8));                // LZW 最小码长
+        GifBitWriter bits(&out);
+        int run = 0;
+        bits.put(ClearCode);
+        for (int y = 0; y < h; ++y) {
+            const uchar *line = indexed.constScanLine(y);
+            for (int x = 0; x < w; ++x) {
+                if (run == LiteralRun) {
+                    bits.put(ClearCode);
+                    run = 0;
+                }
+                bits.put(line[x]);
+                ++run;
+            }
+        }
+        bits.put(EndCode);
+        bits.finish();
+    }
+    out.append(char(0x3B));
+    return out;
+}
+
+QVector<LibraryRecord> CorpusGenerator::generate(const CorpusOptions &o, QString *error)
+{
+    QTextStream log(stderr);
+    QDir dir(o.dir);
+    if (!dir.mkpath(".")) {
+        if (error) *error = QString("cannot create %1").arg(o.dir);
+        return {};
+    }
+    QJsonObject manifest;
+    manifest["version"] = Version;
+    manifest["count"] = o.count;
+    manifest["seed"] = double(o.seed);
+    manifest["png"] = o.pngShare;
+    manifest["jpeg"] = o.jpegShare;
+    manifest["duplicates"] = o.duplicateShare;
+    const QString manifestPath = dir.filePath("corpus.json");
+
+    // 已有同样参数生成的语料：直接读快照
+    QFile mf(manifestPath);
+    if (mf.open(QIODevice::ReadOnly) && QJsonDocument::fromJson(mf.readAll()).object() == manifest
+        && QFileInfo::exists(snapshotPath(o.dir))) {
+        LibraryStore store(snapshotPath(o.dir));
+        const QVector<LibraryRecord> records = store.load();
+        if (records.size() == o.count) {
+            log << "corpus: reusing " << o.count << " files in " << o.dir << "\n";
+            return records;
+        }
+    }
+    mf.close();
+    QFile::remove(manifestPath);
+
+    QElapsedTimer timer;
+    timer.start();
+    log << "corpus: generating " << o.count << " files in " << o.dir << " (seed " << o.seed << ")\n";
+    log.flush();
+    QVector<FilePlan> plans(o.count);
+    QVector<LibraryRecord> records(o.count);
+    for (int i = 0; i < o.count; ++i) {
+        FilePlan p = planFile(o, i);
+        if (p.duplicateOf >= 0) p.format = plans.at(p.duplicateOf).format;  // 副本沿用原件的格式（扩展名）
+        plans[i] = p;
+        if (i % 1000 == 0) dir.mkpath(QString("%1").arg(i / 1000, 4, 10, QLatin1Char('0')));
+        LibraryRecord &rec = records[i];
+        rec.path = dir.filePath(relativePath(i, p.format));
+        rec.name = QFileInfo(rec.path).fileName();
+        rec.time = p.time;
+    }
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int stride = qMax(1, pool->maxThreadCount());
+    for (int t = 0; t < stride; ++t) pool->start(new GenerateTask(o, &records, &plans, t, stride));
+    pool->waitForDone();
+
+    for (int i = 0; i < o.count; ++i) {
+        const int src = plans.at(i).duplicateOf;
+        if (src < 0) continue;
+        QFile::remove(records.at(i).path);
+        if (!QFile::copy(records.at(src).path, records.at(i).path)) continue;
+        records[i].size = records.at(src).size;
+        records[i].hash = records.at(src).hash;
+    }
+    for (const LibraryRecord &rec : qAsConst(records)) {
+        if (rec.size == 0) {
+            if (error) *error = QString("failed to write %1").arg(rec.path);
+            return {};
+        }
+    }
+
+    {
+        // 快照由 LibraryStore 写出，保证与程序读取的格式一致；析构时等待写线程完成
+        QFile::remove(snapshotPath(o.dir));
+        LibraryStore store(snapshotPath(o.dir));
+        QFile::remove(store.journalPath());
+        store.writeSnapshot(records);
+    }
+    if (mf.open(QIODevice::WriteOnly)) mf.write(QJsonDocument(manifest).toJson());
+    log << "corpus: generated in " << timer.elapsed() << " ms\n";
+    for (int i = 0; i < records.size(); ++i) records[i].order = i;
+    return records;
+}
@@ -0,0 +1,42 @@
+/*
+* 文件名：corpusgenerator.h
+* 日期：2026-10-16
+* 该文件功能大致描述：基准测试用的合成表情库。按给定数量与随机种子生成可复现的图片文件（PNG/JPEG/GIF 混合，
+*                    尺寸以表情包常见的小图为主，少量大图，GIF 有多帧；另有一小部分与之前文件字节完全相同的副本，
+*                    用于覆盖按内容去重的路径），并写出与之对应的 emoji_data.json（由 LibraryStore 写出，格式与程序一致）。
+*                    同一目录下已有相同数量、种子与版本的语料时直接复用，不重新生成。
+* 该文件函数功能描述：
+*   - CorpusOptions 结构体：数量、种子、输出目录、格式与尺寸分布
+*   - CorpusGenerator::generate()：生成（或复用）语料，返回按顺序排列的库记录
+*   - CorpusGenerator::encodeGif()：把若干帧编码为 GIF（Qt 只能读取 GIF，不能写出）
+* 与该文件相关联的其他文件：corpusgenerator.cpp, main.cpp, ../../src/librarystore.h, ../../src/contenthash.h
+*/
+
+#ifndef CORPUSGENERATOR_H
+#define CORPUSGENERATOR_H
+
+#include <QString>
+#include <QVector>
+#include <QImage>
+#include <QByteArray>
+#include "librarybackend.h"
+
+struct CorpusOptions {
+    int count = 1000;
+    quint32 seed = 1;
+    QString dir;                  // 语料目录；图片按每 1000 个一个子目录存放，快照为 dir/emoji_data.json
+    double pngShare = 0.50;       // 其余为 GIF
+    double jpegShare = 0.35;
+    double duplicateShare = 0.02; // 与更早的某个文件内容相同的比例
+};
+
+class CorpusGenerator {
+public:
+    static const int Version = 1;  // 生成规则变化时递增，旧语料随之失效
+
+    static QVector<LibraryRecord> generate(const CorpusOptions &options, QString *error = nullptr);
+    static QString snapshotPath(const QString &dir);
+    static QByteArray encodeGif(const QVector<QImage> &frames, int delayCs);
+};
+
+#endif // CORPUSGENERATOR_H
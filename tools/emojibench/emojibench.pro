@@ -0,0 +1,51 @@
+# 数据路径基准测试：与 EmojiManager.pro 共用 src/ 下的模型、导入与存储实现，不含界面
+# 构建：qmake tools/emojibench/emojibench.pro && make（或 nmake / jom）；用法见 main.cpp 文件头
+QT += core gui sql
+QT -= widgets
+
+CONFIG += c++17 release console
+CONFIG -= app_bundle
+TARGET = emojibench
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += \
+    main.cpp \
+    corpusgenerator.cpp \
+    benchrunner.cpp \
+    $$SRC/emojilistmodel.cpp \
+    $$SRC/emojimimedata.cpp \
+    $$SRC/imagecache.cpp \
+    $$SRC/sortengine.cpp \
+    $$SRC/searchindex.cpp \
+    $$SRC/similarityindex.cpp \
+    $$SRC/importpipeline.cpp \
+    $$SRC/thumbnailcache.cpp \
+    $$SRC/thumbnailer.cpp \
+    $$SRC/contenthash.cpp \
+    $$SRC/perceptualhash.cpp \
+    $$SRC/librarystore.cpp \
+    $$SRC/sqlitecatalog.cpp \
+    $$SRC/trace.cpp
+
+HEADERS += \
+    corpusgenerator.h \
+    benchrunner.h \
+    $$SRC/emoji_meta.h \
+    $$SRC/emojilistmodel.h \
+    $$SRC/emojimimedata.h \
+    $$SRC/imagecache.h \
+    $$SRC/sortengine.h \
+    $$SRC/searchindex.h \
+    $$SRC/similarityindex.h \
+    $$SRC/importpipeline.h \
+    $$SRC/thumbnailcache.h \
+    $$SRC/thumbnailer.h \
+    $$SRC/contenthash.h \
+    $$SRC/perceptualhash.h \
+    $$SRC/librarystore.h \
+    $$SRC/librarybackend.h \
+    $$SRC/sqlitecatalog.h \
+    $$SRC/trace.h
@@ -0,0 +1,288 @@
+/*
+* 文件名：main.cpp
+* 日期：2026-10-16
+* 该文件功能描述：数据路径基准测试（emojibench）。为每个规模生成（或复用）合成语料，然后测量与 MainWindow 相同的数据路径：
+*                导入单个文件（ImportPipeline::process，冷解码 / 命中缩略图缓存）、导入后的批量插入（appendEmojiItems）、
+*                读取表情库（loadFromJson：JSON 快照 + 日志，或 SQLite 目录第一页 / 全部）、写快照（saveToJson）、
+*                三种排序与切换升降序（onSortCriteriaChanged）、批量删除（分散 / 连续）。界面部分（视图、委托绘制）不在此测量。
+*                结果写成 JSON（--out），不同版本之间可直接比较。
+*                用法：emojibench --sizes 1000,10000,200000 --corpus D:/bench --out result.json [--filter sort] [--min-time 500]
+* 与该文件相关联的其他文件：corpusgenerator.h/cpp, benchrunner.h/cpp, emojibench.pro, ../../src/ 下的模型与存储实现
+*/
+
+#include "corpusgenerator.h"
+#include "benchrunner.h"
+#include "emojilistmodel.h"
+#include "importpipeline.h"
+#include "thumbnailcache.h"
+#include "contenthash.h"
+#include "librarystore.h"
+#include "sqlitecatalog.h"
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QTextStream>
+#include <memory>
+
+namespace {
+
+const int ImportSample = 200;  // 导入用例处理的文件数（解码是逐个文件的代价，不随库大小变化）
+const int InsertBatch = 256;   // 导入时每批插入的条数（约为一帧内完成的导入数）
+const int FirstPageSize = 1000;
+
+// 与 MainWindow::itemsFromRecords 相同：记录 → 条目，并登记内容哈希
+QVector<EmojiItem> toItems(const QVector<LibraryRecord> &records, ContentIndex *index)
+{
+    QVector<EmojiItem> list;
+    list.reserve(records.size());
+    for (const LibraryRecord &rec : records) {
+        EmojiItem it;
+        it.filePath = rec.path;
+        it.fileName = rec.name;
+        it.createTime = rec.time;
+        it.fileSize = rec.size;
+        it.orderIndex = list.size();
+        it.contentHash = rec.hash;
+        it.perceptualHash = rec.phash;
+        it.hasPerceptualHash = rec.hasPhash;
+        index->add(rec.path, rec.size, rec.hash);
+        list.append(it);
+    }
+    return list;
+}
+
+// 与 MainWindow::toRecord 相同
+LibraryRecord toRecord(const EmojiItem &item)
+{
+    LibraryRecord rec;
+    rec.path = item.filePath;
+    rec.name = item.fileName;
+    rec.time = item.createTime;
+    rec.size = item.fileSize;
+    rec.hash = item.contentHash;
+    rec.phash = item.perceptualHash;
+    rec.hasPhash = item.hasPerceptualHash;
+    return rec;
+}
+
+// 每次执行前重建的状态：模型、内容索引与一个临时的日志存储
+struct Library {
+    std::unique_ptr<EmojiListModel> model;
+    ContentIndex index;
+    std::unique_ptr<LibraryStore> store;
+
+    void reset(const QString &scratchDir, const QVector<EmojiItem> *items = nullptr)
+    {
+        store.reset();  // 先析构：等待上一次的后台写入完成
+        const QString snapshot = QDir(scratchDir).filePath("scratch.json");
+        QFile::remove(snapshot);
+        store.reset(new LibraryStore(snapshot));
+        QFile::remove(store->journalPath());
+        model.reset(new EmojiListModel);
+        index.clear();
+        if (items) {
+            model->setItems(*items);
+            for (const EmojiItem &it : *items) index.add(it.filePath, it.fileSize, it.contentHash);
+        }
+    }
+};
+
+void runSize(BenchRunner &bench, const QString &corpusRoot, int n, quint32 seed)
+{
+    CorpusOptions options;
+    options.count = n;
+    options.seed = seed;
+    options.dir = QDir(corpusRoot).filePath(QString("n%1_seed%2").arg(n).arg(seed));
+    QString error;
+    const QVector<LibraryRecord> records = CorpusGenerator::generate(options, &error);
+    if (records.isEmpty()) {
+        QTextStream(stderr) << "corpus generation failed: " << error << "\n";
+        return;
+    }
+    const QString snapshot = CorpusGenerator::snapshotPath(options.dir);
+    const QString scratch = QDir(options.dir).filePath("scratch");
+    QDir().mkpath(scratch);
+
+    ContentIndex scratchIndex;
+    const QVector<EmojiItem> items = toItems(records, &scratchIndex);
+    Library lib;
+
+    // 导入：冷解码与命中缩略图缓存（再次导入同一批文件）
+    QStringList sample;
+    const int sampleCount = qMin(ImportSample, records.size());
+    const int step = records.size() / sampleCount;  // 在整个语料中均匀取样，各种格式与尺寸都有
+    for (int i = 0; i < sampleCount; ++i) sample.append(records.at(i * step).path);
+    bench.run("import/process-cold", sample.size(), [&]() { lib.index.clear(); }, [&]() {
+        for (const QString &p : qAsConst(sample)) ImportPipeline::process(p, nullptr, &lib.index);
+    });
+    ThumbnailCache thumbCache;
+    const QString thumbDir = QDir(scratch).filePath("thumbs");
+    QDir(thumbDir).removeRecursively();
+    thumbCache.open(thumbDir);
+    for (const QString &p : qAsConst(sample)) ImportPipeline::process(p, &thumbCache, nullptr);  // 预热缓存
+    bench.run("import/process-cached", sample.size(), [&]() { lib.index.clear(); }, [&]() {
+        for (const QString &p : qAsConst(sample)) ImportPipeline::process(p, &thumbCache, &lib.index);
+    });
+
+    // appendEmojiItems：每批一次模型插入，每条一行日志（缩略图不计：QPixmap 转换与数据规模无关）
+    bench.run("appendEmojiItems", n, [&]() { lib.reset(scratch); }, [&]() {
+        for (int from = 0; from < items.size(); from += InsertBatch) {
+            const QVector<EmojiItem> batch = items.mid(from, InsertBatch);
+            for (const EmojiItem &it : batch) {
+                lib.index.add(it.filePath, it.fileSize, it.contentHash);
+                lib.store->recordAdd(toRecord(it));
+            }
+            lib.model->appendItems(batch);
+        }
+        lib.store->flush();
+    });
+
+    // loadFromJson：快照 + 日志重放 → 条目 → 模型
+    bench.run("loadFromJson/json", n, [&]() { lib.reset(scratch); }, [&]() {
+        LibraryStore store(snapshot);
+        lib.model->setItems(toItems(store.load(), &lib.index));
+    });
+    if (SqliteCatalog::isAvailable()) {
+        const QString db = QDir(scratch).filePath("catalog.db");
+        QFile::remove(db);
+        {
+            SqliteCatalog migrate(db, snapshot);  // 第一次打开时从 JSON 导入，不计时
+            migrate.open();
+        }
+        bench.run("loadFromJson/sqlite-first-page", n, [&]() { lib.reset(scratch); }, [&]() {
+            SqliteCatalog catalog(db, snapshot);
+            catalog.open();
+            LibraryQuery q;
+            q.limit = FirstPageSize;
+            lib.model->setItems(toItems(catalog.query(q), &lib.index));
+        });
+        bench.run("loadFromJson/sqlite-full", n, [&]() { lib.reset(scratch); }, [&]() {
+            SqliteCatalog catalog(db, snapshot);
+            catalog.open();
+            lib.model->setItems(toItems(catalog.load(), &lib.index));
+        });
+    }
+
+    // saveToJson：收集记录 + 后台写快照（析构时等待写完，计入耗时）
+    const QString savePath = QDir(scratch).filePath("save.json");
+    bench.run("saveToJson", n, [&]() { lib.reset(scratch, &items); }, [&]() {
+        QVector<LibraryRecord> out;
+        out.reserve(lib.model->rowCount());
+        for (int i = 0; i < lib.model->rowCount(); ++i) out.append(toRecord(lib.model->item(i)));
+        LibraryStore store(savePath);
+        store.writeSnapshot(out);
+    });
+
+    // 排序：每次从未排序的模型开始（排序引擎的缓存不复用）；切换升降序从已排序的状态开始
+    const struct { const char *name; EmojiListModel::SortKey key; } sorts[] = {
+        { "sort/date", EmojiListModel::SortByDate },
+        { "sort/size", EmojiListModel::SortBySize },
+        { "sort/name", EmojiListModel::SortByName },
+    };
+    for (const auto &s : sorts) {
+        bench.run(s.name, n, [&]() { lib.reset(scratch, &items); }, [&]() {
+            lib.model->sortItems(s.key, Qt::DescendingOrder);
+        });
+    }
+    bench.run("sort/toggle-order", n, [&]() {
+        lib.reset(scratch, &items);
+        lib.model->sortItems(EmojiListModel::SortByDate, Qt::DescendingOrder);
+    }, [&]() {
+        lib.model->sortItems(EmojiListModel::SortByDate, Qt::AscendingOrder);
+    });
+
+    // 批量删除 10%：分散的行（每 10 行一个）与连续的行
+    auto bulkDelete = [&](bool scattered) {
+        const int count = lib.model->rowCount() / 10;
+        QVector<int> rows;
+        QStringList paths;
+        rows.reserve(count);
+        for (int k = 0; k < count; ++k) {
+            rows.append(scattered ? k * 10 : k);
+            const EmojiItem &it = lib.model->item(rows.last());
+            paths.append(it.filePath);
+            lib.index.remove(it.filePath, it.fileSize, it.contentHash);
+        }
+        lib.model->removeRowSet(rows);
+        lib.store->recordRemove(paths);
+        lib.store->flush();
+    };
+    bench.run("delete/scattered-10pct", n, [&]() { lib.reset(scratch, &items); }, [&]() { bulkDelete(true); });
+    bench.run("delete/contiguous-10pct", n, [&]() { lib.reset(scratch, &items); }, [&]() { bulkDelete(false); });
+    lib.store.reset();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // 不需要窗口：没有指定平台时使用 offscreen
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName("emojibench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("EmojiManager data-path benchmarks");
+    parser.addHelpOption();
+    QCommandLineOption sizesOpt("sizes", "Library sizes to benchmark (1000..200000).", "list", "1000,10000");
+    QCommandLineOption corpusOpt("corpus", "Directory for generated corpora (reused between runs).", "dir",
+                                 QDir::temp().filePath("emojibench_corpus"));
+    QCommandLineOption seedOpt("seed", "Corpus random seed.", "n", "1");
+    QCommandLineOption outOpt("out", "Write results as JSON to this file (default: stdout).", "file");
+    QCommandLineOption filterOpt("filter", "Only run benchmarks whose name contains this text.", "text");
+    QCommandLineOption minTimeOpt("min-time", "Minimum measured time per benchmark in ms.", "ms", "500");
+    QCommandLineOption generateOpt("generate-only", "Only generate the corpora.");
+    parser.addOptions({ sizesOpt, corpusOpt, seedOpt, outOpt, filterOpt, minTimeOpt, generateOpt });
+    parser.process(app);
+
+    QVector<int> sizes;
+    for (const QString &s : parser.value(sizesOpt).split(',')) {
+        if (s.trimmed().isEmpty()) continue;  // "1000,,5000" 或末尾的逗号
+        const int n = s.trimmed().toInt();
+        if (n < 1 || n > 200000) {
+            QTextStream(stderr) << "size out of range (1..200000): " << s << "\n";
+            return 2;
+        }
+        sizes.append(n);
+    }
+    const quint32 seed = parser.value(seedOpt).toUInt();
+
+    if (parser.isSet(generateOpt)) {
+        for (int n : qAsConst(sizes)) {
+            CorpusOptions options;
+            options.count = n;
+            options.seed = seed;
+            options.dir = QDir(parser.value(corpusOpt)).filePath(QString("n%1_seed%2").arg(n).arg(seed));
+            QString error;
+            if (CorpusGenerator::generate(options, &error).isEmpty()) {
+                QTextStream(stderr) << "corpus generation failed: " << error << "\n";
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    BenchRunner bench(parser.value(minTimeOpt).toInt(), parser.value(filterOpt));
+    for (int n : qAsConst(sizes)) runSize(bench, parser.value(corpusOpt), n, seed);
+
+    QJsonObject root = bench.toJson();
+    root["seed"] = double(seed);
+    QJsonArray sizeArr;
+    for (int n : qAsConst(sizes)) sizeArr.append(n);
+    root["sizes"] = sizeArr;
+    const QByteArray json = QJsonDocument(root).toJson();
+    if (parser.isSet(outOpt)) {
+        QFile f(parser.value(outOpt));
+        if (!f.open(QIODevice::WriteOnly) || f.write(json) != json.size()) {
+            QTextStream(stderr) << "cannot write " << parser.value(outOpt) << "\n";
+            return 1;
+        }
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
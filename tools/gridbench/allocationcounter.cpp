@@ -0,0 +1,93 @@
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<quint64> g_allocations{0};
+
+inline void countOne()
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+}
+
+quint64 AllocationCounter::count()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+
+// 可执行文件里定义的 malloc 会优先于 libc 的版本被各共享库解析到；真正的分配转发给 glibc 的内部入口
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    countOne();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    countOne();
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    countOne();
+    return __libc_realloc(ptr, size);
+}
+}
+
+bool AllocationCounter::coversWholeProcess()
+{
+    return true;
+}
+
+#else
+
+// 只替换本程序的 operator new/new[]；nothrow 版本按标准默认转发到这里，对齐版本（很少用到）不计入
+void *operator new(std::size_t size)
+{
+    countOne();
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+bool AllocationCounter::coversWholeProcess()
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,25 @@
+/*
+* 文件名：allocationcounter.h
+* 日期：2026-10-16
+* 该文件功能大致描述：进程内堆分配计数，供渲染基准测试统计“每帧分配次数”。只计次数，不计字节，也不改变分配行为。
+*                    glibc 下直接替换 malloc/calloc/realloc（转发到 __libc_*），Qt 各库与 libstdc++ 的 operator new
+*                    都经过这里，计数覆盖整个进程；其他平台替换本程序的 operator new/new[]，
+*                    只能统计本程序（含 ../../src 下编译进来的代码）里的 new，Qt DLL 内部的分配不计入。
+*                    计数是全进程的，后台线程的分配也会计入；基准测试期间不启动后台任务。
+* 该文件函数功能描述：
+*   - AllocationCounter::count()：到目前为止的分配次数（realloc 计为一次）
+*   - AllocationCounter::coversWholeProcess()：当前平台的计数是否覆盖 Qt 库内部的分配
+* 与该文件相关联的其他文件：allocationcounter.cpp, main.cpp
+*/
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+namespace AllocationCounter {
+quint64 count();
+bool coversWholeProcess();
+}
+
+#endif // ALLOCATIONCOUNTER_H
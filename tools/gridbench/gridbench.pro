@@ -0,0 +1,53 @@
+# 网格渲染基准测试：与 EmojiManager.pro 共用 src/ 下的视图、委托与模型实现，在 offscreen 平台下运行
+# 构建：qmake tools/gridbench/gridbench.pro && make（或 nmake / jom）；用法见 main.cpp 文件头
+QT += core gui widgets
+
+CONFIG += c++17 release console
+CONFIG -= app_bundle
+TARGET = gridbench
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += \
+    main.cpp \
+    allocationcounter.cpp \
+    $$SRC/emojilistwidget.cpp \
+    $$SRC/emojilistdelegate.cpp \
+    $$SRC/emojilistmodel.cpp \
+    $$SRC/emojifiltermodel.cpp \
+    $$SRC/emojimimedata.cpp \
+    $$SRC/framecache.cpp \
+    $$SRC/animationclock.cpp \
+    $$SRC/imagecache.cpp \
+    $$SRC/sortengine.cpp \
+    $$SRC/searchindex.cpp \
+    $$SRC/similarityindex.cpp \
+    $$SRC/importpipeline.cpp \
+    $$SRC/thumbnailcache.cpp \
+    $$SRC/thumbnailer.cpp \
+    $$SRC/contenthash.cpp \
+    $$SRC/perceptualhash.cpp \
+    $$SRC/trace.cpp
+
+HEADERS += \
+    allocationcounter.h \
+    $$SRC/emoji_meta.h \
+    $$SRC/emojilistwidget.h \
+    $$SRC/emojilistdelegate.h \
+    $$SRC/emojilistmodel.h \
+    $$SRC/emojifiltermodel.h \
+    $$SRC/emojimimedata.h \
+    $$SRC/framecache.h \
+    $$SRC/animationclock.h \
+    $$SRC/imagecache.h \
+    $$SRC/sortengine.h \
+    $$SRC/searchindex.h \
+    $$SRC/similarityindex.h \
+    $$SRC/importpipeline.h \
+    $$SRC/thumbnailcache.h \
+    $$SRC/thumbnailer.h \
+    $$SRC/contenthash.h \
+    $$SRC/perceptualhash.h \
+    $$SRC/trace.h
@@ -0,0 +1,385 @@
+/*
+* 文件名：main.cpp
+* 日期：2026-10-16
+* 该文件功能描述：网格渲染基准测试（gridbench）。在 offscreen 平台下构造与 MainWindow 相同的视图组合
+*                （EmojiListWidget + EmojiFilterModel + EmojiListModel + EmojiListDelegate），填入 N 个合成条目，
+*                按脚本逐帧执行：平滑滚动与快速甩动、鼠标悬停划过单元格、单击与 Shift 范围选择、窗口宽度变化、
+*                切换显示文件名。每一帧 = 执行动作 + 处理事件（布局与重绘都在其中完成，只重绘脏区域，与真实窗口一致）。
+*                每个场景报告帧耗时与绘制耗时的 p50/p90/p99/最大值、每帧绘制的单元格数、每帧堆分配次数，结果写成 JSON。
+*                条目的缩略图直接在内存中生成（一组尺寸、颜色各异的 QPixmap 轮流使用，另有一部分留空走占位图），
+*                路径都是 .png，不触发动图解码，测的只是视图与委托本身。
+*                用法：gridbench --items 10000 --out grid.json [--filter scroll] [--size 1000x800]
+* 与该文件相关联的其他文件：allocationcounter.h/cpp, gridbench.pro, ../../src/emojilistwidget.h, ../../src/emojilistdelegate.h
+*/
+
+#include "allocationcounter.h"
+#include "emojilistwidget.h"
+#include "emojilistdelegate.h"
+#include "emojilistmodel.h"
+#include "emojifiltermodel.h"
+#include "importpipeline.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QScrollBar>
+#include <QMouseEvent>
+#include <QHoverEvent>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QTextStream>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+const int SmoothStep = 40;       // 平滑滚动每帧的像素数（约为滚轮一格的三分之一）
+const int FlingStep = 400;       // 甩动时每帧的像素数
+const int EmptyThumbEvery = 7;   // 每 7 个条目留一个没有缩略图（绘制占位图）
+
+// 统计一帧内视口的绘制：绘制耗时与单元格数
+struct FrameCounters {
+    qint64 paintNs = 0;
+    int cells = 0;
+    int paints = 0;
+};
+
+// 每绘制一个单元格计数一次；计时放在视图的 paintEvent 上，避免逐单元格计时本身的开销
+class CountingDelegate : public EmojiListDelegate {
+public:
+    explicit CountingDelegate(FrameCounters *counters, QObject *parent = nullptr)
+        : EmojiListDelegate(parent), m_counters(counters) {}
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override
+    {
+        ++m_counters->cells;
+        EmojiListDelegate::paint(painter, option, index);
+    }
+
+private:
+    FrameCounters *m_counters;
+};
+
+class BenchView : public EmojiListWidget {
+public:
+    explicit BenchView(FrameCounters *counters) : m_counters(counters) {}
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        QElapsedTimer timer;
+        timer.start();
+        EmojiListWidget::paintEvent(event);
+        m_counters->paintNs += timer.nsecsElapsed();
+        ++m_counters->paints;
+    }
+
+private:
+    FrameCounters *m_counters;
+};
+
+// 一组各不相同的缩略图：宽高比、底色与图案都不同，cacheKey 互不相同，委托的预缩放缓存要真正工作
+QVector<QPixmap> makeThumbnails(int distinct)
+{
+    QVector<QPixmap> thumbs;
+    thumbs.reserve(distinct);
+    const int side = ImportPipeline::ThumbnailSize;
+    for (int i = 0; i < distinct; ++i) {
+        const int w = (i % 3 == 1) ? side * 2 / 3 : side;
+        const int h = (i % 3 == 2) ? side / 2 : side;
+        QPixmap pm(w, h);
+        pm.fill(QColor::fromHsv((i * 37) % 360, 80 + i % 120, 255));
+        QPainter p(&pm);
+        p.setRenderHint(QPainter::Antialiasing);
+        p.setBrush(QColor::fromHsv((i * 71 + 180) % 360, 200, 200));
+        p.setPen(Qt::NoPen);
+        p.drawEllipse(QRect(w / 6, h / 6, w * 2 / 3, h * 2 / 3));
+        p.end();
+        thumbs.append(pm);
+    }
+    return thumbs;
+}
+
+QVector<EmojiItem> makeItems(int count, const QVector<QPixmap> &thumbs)
+{
+    static const char *const stems[] = {"doge", "狗头", "笑哭", "reaction_image", "猫猫震惊", "ok", "这是一个很长很长的表情包文件名_最终版(2)"};
+    const QDateTime base = QDateTime::currentDateTime();
+    QVector<EmojiItem> items;
+    items.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        EmojiItem it;
+        it.fileName = QString::fromUtf8(stems[i % 7]) + QString::number(i);
+        it.filePath = QStringLiteral("/bench/%1/%2.png").arg(i / 1000).arg(it.fileName);
+        if (i % EmptyThumbEvery != 0) it.thumbnail = thumbs.at(i % thumbs.size());
+        it.createTime = base.addSecs(-i);
+        it.fileSize = 1024 + (i * 7919) % (512 * 1024);
+        it.orderIndex = i;
+        items.append(it);
+    }
+    return items;
+}
+
+double percentile(QVector<double> sorted, double p)
+{
+    if (sorted.isEmpty()) return 0;
+    std::sort(sorted.begin(), sorted.end());
+    const int idx = qBound(0, int(p * sorted.size() + 0.5) - 1, sorted.size() - 1);
+    return sorted.at(idx);
+}
+
+class GridBench {
+public:
+    GridBench(int items, const QSize &size, int distinct)
+        : m_size(size)
+    {
+        m_view.setItemDelegate(new CountingDelegate(&m_counters, &m_view));
+        m_filter.setSourceModel(&m_model);
+        m_view.setModel(&m_filter);
+        m_view.setDragDropMode(QAbstractItemView::DragOnly);
+        m_model.setItems(makeItems(items, makeThumbnails(distinct)));
+        m_view.resize(m_size);
+        m_view.show();
+        settle();
+    }
+
+    // 执行一个场景：每个动作是一帧；场景开始前恢复到初始状态（顶端、无选择、显示文件名、初始尺寸）
+    void run(const QString &name, const std::function<void(QVector<std::function<void()>> &)> &script)
+    {
+        if (!m_filterText.isEmpty() && !name.contains(m_filterText)) return;
+        m_view.resize(m_size);
+        m_view.clearSelection();
+        m_view.verticalScrollBar()->setValue(0);
+        m_model.setShowNames(true);
+        settle();
+
+        QVector<std::function<void()>> actions;
+        script(actions);
+
+        QVector<double> frameMs, paintMs, cells, allocs;
+        int painted = 0;
+        QElapsedTimer timer;
+        for (const std::function<void()> &action : actions) {
+            m_counters = FrameCounters();
+            const quint64 allocBefore = AllocationCounter::count();
+            timer.start();
+            action();
+            QCoreApplication::sendPostedEvents();
+            QCoreApplication::processEvents();
+            const qint64 ns = timer.nsecsElapsed();
+            allocs.append(double(AllocationCounter::count() - allocBefore));
+            frameMs.append(ns / 1e6);
+            paintMs.append(m_counters.paintNs / 1e6);
+            cells.append(m_counters.cells);
+            if (m_counters.paints > 0) ++painted;
+        }
+
+        QJsonObject r;
+        r["name"] = name;
+        r["items"] = m_model.rowCount();
+        r["frames"] = actions.size();
+        r["painted_frames"] = painted;
+        r["frame_ms"] = summary(frameMs);
+        r["paint_ms"] = summary(paintMs);
+        r["cells_per_frame"] = QJsonObject{{"mean", mean(cells)}, {"max", percentile(cells, 1.0)}};
+        r["allocations_per_frame"] = QJsonObject{{"mean", mean(allocs)}, {"p99", percentile(allocs, 0.99)},
+                                                 {"max", percentile(allocs, 1.0)}};
+        m_results.append(r);
+
+        QTextStream(stderr) << QString("%1 n=%2: frame p50 %3 ms p99 %4 ms, paint p50 %5 ms, %6 cells/frame, %7 allocs/frame\n")
+                                   .arg(name, -12).arg(m_model.rowCount())
+                                   .arg(percentile(frameMs, 0.5), 0, 'f', 3).arg(percentile(frameMs, 0.99), 0, 'f', 3)
+                                   .arg(percentile(paintMs, 0.5), 0, 'f', 3).arg(mean(cells), 0, 'f', 1)
+                                   .arg(mean(allocs), 0, 'f', 1);
+    }
+
+    void setFilter(const QString &filter) { m_filterText = filter; }
+    EmojiListWidget &view() { return m_view; }
+    EmojiListModel &model() { return m_model; }
+    const QSize &size() const { return m_size; }
+    const QJsonArray &results() const { return m_results; }
+
+    // 视口中心点落在单元格内的行（按从上到下、从左到右的顺序）
+    QVector<QModelIndex> visibleIndexes() const
+    {
+        QVector<QModelIndex> out;
+        const QRect area = m_view.viewport()->rect();
+        const QModelIndex first = m_view.indexAt(QPoint(area.left() + 20, area.top() + 20));
+        for (int row = qMax(0, first.row()); row < m_filter.rowCount(); ++row) {
+            const QModelIndex idx = m_filter.index(row, 0);
+            const QRect rect = m_view.visualRect(idx);
+            if (rect.top() > area.bottom()) break;
+            if (area.contains(rect.center())) out.append(idx);
+        }
+        return out;
+    }
+
+private:
+    void settle()
+    {
+        for (int i = 0; i < 3; ++i) {
+            QCoreApplication::sendPostedEvents();
+            QCoreApplication::processEvents();
+        }
+    }
+
+    static double mean(const QVector<double> &v)
+    {
+        if (v.isEmpty()) return 0;
+        double sum = 0;
+        for (double x : v) sum += x;
+        return sum / v.size();
+    }
+
+    static QJsonObject summary(const QVector<double> &v)
+    {
+        return QJsonObject{{"p50", percentile(v, 0.5)}, {"p90", percentile(v, 0.9)},
+                           {"p99", percentile(v, 0.99)}, {"max", percentile(v, 1.0)}};
+    }
+
+    QSize m_size;
+    FrameCounters m_counters;
+    EmojiListModel m_model;
+    EmojiFilterModel m_filter;
+    BenchView m_view{&m_counters};
+    QString m_filterText;
+    QJsonArray m_results;
+};
+
+void sendMouse(QWidget *viewport, QEvent::Type type, const QPoint &pos, Qt::MouseButton button,
+               Qt::KeyboardModifiers modifiers = Qt::NoModifier)
+{
+    const Qt::MouseButtons buttons = (type == QEvent::MouseButtonPress) ? Qt::MouseButtons(button) : Qt::NoButton;
+    QMouseEvent ev(type, pos, viewport->mapToGlobal(pos), button, buttons, modifiers);
+    QCoreApplication::sendEvent(viewport, &ev);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // 默认不弹出窗口；需要观察时可显式设置 QT_QPA_PLATFORM
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gridbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("EmojiManager grid rendering benchmark");
+    parser.addHelpOption();
+    QCommandLineOption itemsOpt("items", "Number of items in the grid.", "n", "10000");
+    QCommandLineOption sizeOpt("size", "Initial viewport size, WxH.", "size", "1000x800");
+    QCommandLineOption distinctOpt("distinct", "Number of distinct thumbnails.", "n", "2048");
+    QCommandLineOption outOpt("out", "Write results as JSON to this file.", "file");
+    QCommandLineOption filterOpt("filter", "Only run scenarios whose name contains this text.", "text");
+    parser.addOptions({itemsOpt, sizeOpt, distinctOpt, outOpt, filterOpt});
+    parser.process(app);
+
+    const int items = qMax(1, parser.value(itemsOpt).toInt());
+    const QStringList wh = parser.value(sizeOpt).split('x');
+    const QSize size(wh.value(0).toInt() > 0 ? wh.value(0).toInt() : 1000,
+                     wh.value(1).toInt() > 0 ? wh.value(1).toInt() : 800);
+
+    GridBench bench(items, size, qMax(1, parser.value(distinctOpt).toInt()));
+    bench.setFilter(parser.value(filterOpt));
+    EmojiListWidget &view = bench.view();
+    QWidget *viewport = view.viewport();
+
+    // 平滑滚动到底（最多 600 帧），再以甩动速度滚回顶端
+    bench.run("scroll", [&](QVector<std::function<void()>> &frames) {
+        QScrollBar *bar = view.verticalScrollBar();
+        const int smoothFrames = qMin(600, bar->maximum() / SmoothStep + 1);
+        for (int i = 1; i <= smoothFrames; ++i)
+            frames.append([bar, i] { bar->setValue(i * SmoothStep); });
+        const int top = smoothFrames * SmoothStep;
+        for (int y = top - FlingStep; y > -FlingStep; y -= FlingStep)
+            frames.append([bar, y] { bar->setValue(qMax(0, y)); });
+    });
+
+    // 鼠标逐个划过可见单元格（每个单元格两帧：进入与在格内移动），来回三遍
+    bench.run("hover", [&](QVector<std::function<void()>> &frames) {
+        const QVector<QModelIndex> cells = bench.visibleIndexes();
+        for (int pass = 0; pass < 3; ++pass) {
+            for (int k = 0; k < cells.size(); ++k) {
+                const QRect rect = view.visualRect(cells.at(pass % 2 ? cells.size() - 1 - k : k));
+                for (const QPoint &pos : {rect.center(), rect.center() + QPoint(6, 6)}) {
+                    frames.append([viewport, pos] {
+                        QHoverEvent hover(QEvent::HoverMove, pos, pos - QPoint(6, 6));
+                        QCoreApplication::sendEvent(viewport, &hover);
+                        sendMouse(viewport, QEvent::MouseMove, pos, Qt::NoButton);
+                    });
+                }
+            }
+        }
+    });
+
+    // 单击切换选中（每帧一次），随后 Shift+单击做范围选择
+    bench.run("selection", [&](QVector<std::function<void()>> &frames) {
+        const QVector<QModelIndex> cells = bench.visibleIndexes();
+        for (int pass = 0; pass < 4; ++pass) {
+            for (int k = 0; k < cells.size(); ++k) {
+                const QPoint pos = view.visualRect(cells.at(k)).center();
+                const Qt::KeyboardModifiers mods = (k % 4 == 3) ? Qt::ShiftModifier : Qt::NoModifier;
+                frames.append([viewport, pos, mods] {
+                    sendMouse(viewport, QEvent::MouseButtonPress, pos, Qt::LeftButton, mods);
+                    sendMouse(viewport, QEvent::MouseButtonRelease, pos, Qt::LeftButton, mods);
+                });
+            }
+        }
+    });
+
+    // 拖动窗口边缘：宽度从 600 逐步到 1400 再回来，每帧 20 像素
+    bench.run("resize", [&](QVector<std::function<void()>> &frames) {
+        const int h = bench.size().height();
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int w = 600; w <= 1400; w += 20) {
+                const int width = pass ? 2000 - w : w;
+                frames.append([&view, width, h] { view.resize(width, h); });
+            }
+        }
+    });
+
+    // 切换显示文件名；在顶端和中部各做一次
+    bench.run("show-names", [&](QVector<std::function<void()>> &frames) {
+        EmojiListModel *model = &bench.model();
+        QScrollBar *bar = view.verticalScrollBar();
+        for (int i = 0; i < 20; ++i) {
+            if (i == 10) frames.append([bar] { bar->setValue(bar->maximum() / 2); });
+            frames.append([model] { model->setShowNames(!model->showNames()); });
+        }
+    });
+
+    QJsonObject env;
+    env["qt"] = QString::fromLatin1(qVersion());
+    env["os"] = QSysInfo::prettyProductName();
+    env["cpu"] = QSysInfo::currentCpuArchitecture();
+    env["platform"] = QGuiApplication::platformName();
+    env["allocations_cover_qt"] = AllocationCounter::coversWholeProcess();
+#ifdef QT_DEBUG
+    env["build"] = "debug";
+#else
+    env["build"] = "release";
+#endif
+    QJsonObject root;
+    root["tool"] = "gridbench";
+    root["format"] = 1;
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["viewport"] = QString("%1x%2").arg(size.width()).arg(size.height());
+    root["environment"] = env;
+    root["results"] = bench.results();
+
+    if (parser.isSet(outOpt)) {
+        QFile f(parser.value(outOpt));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "cannot write " << f.fileName() << "\n";
+            return 1;
+        }
+        f.write(QJsonDocument(root).toJson());
+    } else {
+        QTextStream(stdout) << QJsonDocument(root).toJson();
+    }
+    return 0;
+}